@@ -0,0 +1,104 @@
+#include <cstdlib>
+#include <iostream>
+
+#include <networking/exceptions.hpp>
+#include <networking/requests/graph_delta.hpp>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << description << std::endl;
+        ++failures;
+    }
+}
+
+/// A graph of the graph library with three vertices in a path and costs for its two edges
+graphs::GenericRequest stored_graph()
+{
+    graphs::GenericRequest stored;
+    auto *graph = stored.mutable_graph();
+    for (int uid = 0; uid < 3; ++uid)
+    {
+        graph->add_vertexlist()->set_uid(uid);
+    }
+    for (int uid = 0; uid < 2; ++uid)
+    {
+        auto *edge = graph->add_edgelist();
+        edge->set_uid(uid);
+        edge->set_invertexindex(uid);
+        edge->set_outvertexindex(uid + 1);
+    }
+    stored.add_edgecosts(1);
+    stored.add_edgecosts(2);
+    return stored;
+}
+
+}  // namespace
+
+/**
+ * @brief Merges jobs referencing a graph of the graph library into the stored graph, like the
+ * handler process does before handling them
+ */
+int main()
+{
+    // A job with its own costs replaces the costs of the stored graph
+    {
+        graphs::GenericRequest job;
+        job.set_graphid(1);
+        job.add_edgecosts(7);
+        job.add_edgecosts(8);
+
+        auto merged = stored_graph();
+        server::merge_into_base(job, merged);
+
+        check(merged.graph().vertexlist_size() == 3, "vertices of the stored graph are kept");
+        check(merged.graph().edgelist_size() == 2, "edges of the stored graph are kept");
+        check(merged.edgecosts_size() == 2, "edge costs of the job replace the stored ones");
+        check(merged.edgecosts_size() == 2 && merged.edgecosts(0) == 7 && merged.edgecosts(1) == 8,
+              "edge costs are those of the job");
+        check(merged.graphid() == 0, "the reference is not merged");
+    }
+
+    // A job without costs uses those of the stored graph
+    {
+        graphs::GenericRequest job;
+        job.set_graphid(1);
+
+        auto merged = stored_graph();
+        server::merge_into_base(job, merged);
+
+        check(merged.edgecosts_size() == 2 && merged.edgecosts(0) == 1,
+              "edge costs of the stored graph are kept");
+    }
+
+    // A job with a graph of its own is rejected instead of mixing both graphs
+    {
+        graphs::GenericRequest job;
+        job.set_graphid(1);
+        job.mutable_graph()->add_vertexlist()->set_uid(5);
+
+        auto merged = stored_graph();
+        bool rejected = false;
+        try
+        {
+            server::merge_into_base(job, merged);
+        }
+        catch (const server::request_parse_error &)
+        {
+            rejected = true;
+        }
+        check(rejected, "a job setting graph and graphId is rejected");
+    }
+
+    if (failures > 0)
+    {
+        return EXIT_FAILURE;
+    }
+    std::cout << "All graph reference checks passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -1,12 +1,17 @@
 #include <csignal>
 #include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <thread>
 
 #include <config/config.hpp>
 #include <networking/io/client_server.hpp>
 #include <networking/io/management_server.hpp>
+#include <networking/io/metrics_server.hpp>
+#include <persistence/job_maintenance.hpp>
 #include <scheduler/scheduler.hpp>
+#include <util/tracing.hpp>
 
 static void block_signals(sigset_t &sigset)
 {
@@ -16,6 +21,12 @@ static void block_signals(sigset_t &sigset)
     pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
 }
 
+static size_t get_server_threads()
+{
+    const auto nof_threads = server::config(server::config_options::SERVER_THREADS).as<size_t>();
+    return (nof_threads > 0) ? nof_threads : std::thread::hardware_concurrency();
+}
+
 static std::string get_runtime_dir_path()
 {
     static const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
@@ -34,7 +45,8 @@ int main(int argc, const char **argv)
 
 #ifdef SPANNERS_UNENCRYPTED_CONNECTION
     server::client_server c_server{
-        server::config(server::config_options::SERVER_PORT).as<unsigned short>()};
+        server::config(server::config_options::SERVER_PORT).as<unsigned short>(),
+        get_server_threads()};
 #else
     if (server::config(server::config_options::TLS_CERT_PATH).empty() ||
         server::config(server::config_options::TLS_KEY_PATH).empty())
@@ -47,13 +59,45 @@ int main(int argc, const char **argv)
     std::string key_path{server::config(server::config_options::TLS_KEY_PATH).as<std::string>()};
     server::client_server c_server{
         server::config(server::config_options::SERVER_PORT).as<unsigned short>(), cert_path,
-        key_path};
+        key_path, get_server_threads()};
 #endif
 
+    // Metrics are served for Prometheus unless the port is zero
+    const auto metrics_port =
+        server::config(server::config_options::METRICS_PORT).as<unsigned short>();
+    std::optional<server::metrics_server> metrics_server;
+    if (metrics_port != 0)
+    {
+        metrics_server.emplace(
+            server::config(server::config_options::METRICS_ADDRESS).as<std::string>(),
+            metrics_port);
+    }
+
+    // Tracing can also be started and stopped later through spannersctl
+    const auto &trace_file = server::config(server::config_options::TRACE_FILE).as<std::string>();
+    if (!trace_file.empty())
+    {
+        try
+        {
+            server::tracing::instance().start(trace_file);
+            std::cout << "[INFO] Tracing jobs to " << trace_file << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[ERROR] " << e.what() << std::endl;
+            return -1;
+        }
+    }
+
     server::scheduler::instance().start();
+    server::job_maintenance::instance().start();
 
     c_server.start();
     m_server.start();
+    if (metrics_server)
+    {
+        metrics_server->start();
+    }
 
     // Wait for signal to terminate process
     std::cout << "[INFO] Press Ctrl-C to shutdown" << std::endl;
@@ -63,5 +107,9 @@ int main(int argc, const char **argv)
     // Shutdown servers on signal
     c_server.stop();
     m_server.stop();
+    if (metrics_server)
+    {
+        metrics_server->stop();
+    }
     return 0;
 }
@@ -0,0 +1,156 @@
+#include "persistence/database_wrapper.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <pqxx/pqxx>
+#include <string>
+#include <utility>
+
+namespace {
+
+constexpr const int NOF_USERS = 1000;
+constexpr const int NOF_JOBS = 1000000;
+constexpr const int NOF_WAITING_JOBS = 10;
+
+/**
+ * Connection string of the database the benchmarks fill, taken from SPANNERS_BENCH_DB. The
+ *  benchmarks insert NOF_JOBS jobs, so they refuse to run without a dedicated database instead of
+ *  falling back to the one of the server.
+ */
+const std::string &benchmark_connection_string()
+{
+    static const std::string connection_string = [] {
+        const char *value = std::getenv("SPANNERS_BENCH_DB");
+        if (value == nullptr || *value == '\0')
+        {
+            std::cerr << "[BENCHMARK] Set SPANNERS_BENCH_DB to the connection string of a dedicated "
+                         "database with the schema applied, never the database of a server"
+                      << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        return std::string{value};
+    }();
+    return connection_string;
+}
+
+/**
+ * Connects to the benchmark database and fills it with NOF_JOBS finished jobs of NOF_USERS users
+ *  named benchmark-<n>, once. Deleting these users removes all of their jobs again. The schema
+ *  including its migrations has to be applied already.
+ */
+server::database_wrapper &populated_database()
+{
+    static server::database_wrapper database = [] {
+        pqxx::connection connection{benchmark_connection_string()};
+        pqxx::work txn{connection};
+        if (!txn.query_value<bool>(
+                "SELECT EXISTS (SELECT 1 FROM users WHERE user_name = 'benchmark-0')"))
+        {
+            txn.exec_params0("INSERT INTO users (user_name, pw_hash, salt, role) SELECT "
+                             "'benchmark-' || i, ''::bytea, ''::bytea, 0 FROM "
+                             "generate_series(0, $1 - 1) i",
+                             NOF_USERS);
+
+            // One job per second, which spans the partitions of up to two months
+            txn.exec_params0("SELECT create_job_partitions(now() - $1 * INTERVAL '1 second', "
+                             "now())",
+                             NOF_JOBS);
+
+            // Job and request data reference each other, see database_wrapper::insert_job()
+            txn.exec_params0(
+                "WITH ids AS MATERIALIZED (SELECT nextval('jobs_job_id_seq')::INT AS job_id, "
+                "nextval('data_data_id_seq')::INT AS data_id, i, now() - i * INTERVAL '1 second' "
+                "AS time_received FROM generate_series(0, $1 - 1) i), "
+                "job AS (INSERT INTO jobs (job_id, user_id, status, request_id, time_received) "
+                "SELECT job_id, user_id, $2, data_id, time_received FROM ids "
+                "JOIN users ON user_name = 'benchmark-' || (i % $3)) "
+                "INSERT INTO data (data_id, job_id, time_received, type, binary_data) SELECT "
+                "data_id, job_id, time_received, 0, ''::bytea FROM ids",
+                NOF_JOBS, static_cast<int>(graphs::StatusType::SUCCESS), NOF_USERS);
+
+            // A few jobs waiting for the scheduler, which must not be running
+            txn.exec_params0("INSERT INTO jobs (user_id, status) SELECT user_id, $1 FROM users, "
+                             "generate_series(1, $2) WHERE user_name = 'benchmark-0'",
+                             static_cast<int>(graphs::StatusType::WAITING), NOF_WAITING_JOBS);
+        }
+        txn.commit();
+        pqxx::nontransaction{connection}.exec0("VACUUM ANALYZE jobs, data");
+
+        return server::database_wrapper{benchmark_connection_string()};
+    }();
+    return database;
+}
+
+/// A job of a benchmark user and the ID of the user, picked from the middle of the table
+std::pair<int, int> sample_job()
+{
+    pqxx::connection connection{benchmark_connection_string()};
+    pqxx::work txn{connection};
+    pqxx::row row = txn.exec_params1(
+        "SELECT job_id, jobs.user_id FROM jobs JOIN users ON jobs.user_id = users.user_id WHERE "
+        "user_name = 'benchmark-1' ORDER BY job_id OFFSET $1 LIMIT 1",
+        NOF_JOBS / NOF_USERS / 2);
+    return {row[0].as<int>(), row[1].as<int>()};
+}
+
+}  // namespace
+
+/**
+ * The scheduler polling for waiting jobs among NOF_JOBS finished ones
+ */
+static void BM_database_NextJobs(benchmark::State &state)
+{
+    auto &database = populated_database();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(database.get_next_jobs(NOF_WAITING_JOBS));
+    }
+}
+BENCHMARK(BM_database_NextJobs)->Unit(benchmark::kMicrosecond);
+
+/**
+ * STATUS request for a single job
+ */
+static void BM_database_StatusSingle(benchmark::State &state)
+{
+    auto &database = populated_database();
+    const auto [job_id, user_id] = sample_job();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(database.get_status_data(job_id, user_id));
+    }
+}
+BENCHMARK(BM_database_StatusSingle)->Unit(benchmark::kMicrosecond);
+
+/**
+ * STATUS request for all jobs of a user, which has NOF_JOBS / NOF_USERS jobs
+ */
+static void BM_database_StatusAll(benchmark::State &state)
+{
+    auto &database = populated_database();
+    const int user_id = sample_job().second;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(database.get_status_changes(user_id, {}, NOF_JOBS));
+    }
+}
+BENCHMARK(BM_database_StatusAll)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Management info of a user, listing all jobs with the size of their data
+ */
+static void BM_database_UserJobs(benchmark::State &state)
+{
+    auto &database = populated_database();
+    const int user_id = sample_job().second;
+    for (auto _ : state)
+    {
+        for (const auto &job : database.get_job_entries(user_id))
+        {
+            benchmark::DoNotOptimize(database.get_job_data_size(job.job_id, user_id));
+        }
+    }
+}
+BENCHMARK(BM_database_UserJobs)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,102 @@
+#include "networking/io/tls_stream.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <boost/asio.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/ssl.hpp>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using boost::asio::ip::tcp;
+
+constexpr const size_t RESPONSE_SIZE = size_t{100} << 20;
+
+/// Creates a server context with a self signed certificate, so no files are needed
+boost::asio::ssl::context build_server_context(bool kernel_offload)
+{
+    boost::asio::ssl::context ctx{boost::asio::ssl::context::tls_server};
+
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, X509_get_subject_name(cert));
+    X509_sign(cert, key, EVP_sha256());
+
+    SSL_CTX_use_certificate(ctx.native_handle(), cert);
+    SSL_CTX_use_PrivateKey(ctx.native_handle(), key);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    if (kernel_offload)
+    {
+        ctx.set_options(SSL_OP_ENABLE_KTLS);
+    }
+#else
+    static_cast<void>(kernel_offload);
+#endif
+
+    return ctx;
+}
+
+}  // namespace
+
+/**
+ * Sends 100 MB responses over a loopback TLS connection, the client reads on its own thread.
+ *  Compares kernel TLS offload (argument 1) with encryption in user space (argument 0), the label
+ *  shows which one was used in the end, as kTLS silently falls back if the kernel lacks support.
+ */
+static void BM_tls_TransferResponse(benchmark::State &state)
+{
+    auto server_ctx = build_server_context(state.range(0) != 0);
+    boost::asio::ssl::context client_ctx{boost::asio::ssl::context::tls_client};
+
+    boost::asio::io_context io_ctx;
+    tcp::acceptor acceptor{io_ctx, tcp::endpoint{boost::asio::ip::address_v4::loopback(), 0}};
+
+    server::tls_stream server_stream{io_ctx.get_executor(), server_ctx};
+    boost::asio::ssl::stream<tcp::socket> client_stream{io_ctx, client_ctx};
+
+    // Connect and handshake, the client does not verify the self signed certificate
+    boost::asio::spawn(io_ctx, [&](boost::asio::yield_context yield) {
+        acceptor.async_accept(server_stream.next_layer(), yield);
+        server_stream.async_handshake(boost::asio::ssl::stream_base::server, yield);
+    });
+    boost::asio::spawn(io_ctx, [&](boost::asio::yield_context yield) {
+        client_stream.next_layer().async_connect(acceptor.local_endpoint(), yield);
+        client_stream.async_handshake(boost::asio::ssl::stream_base::client, yield);
+    });
+    io_ctx.run();
+
+    const std::vector<char> response(RESPONSE_SIZE, 'x');
+    std::vector<char> received(RESPONSE_SIZE);
+
+    for (auto _ : state)
+    {
+        std::thread client{[&] {
+            boost::asio::read(client_stream, boost::asio::buffer(received));
+        }};
+
+        io_ctx.restart();
+        boost::asio::spawn(io_ctx, [&](boost::asio::yield_context yield) {
+            boost::asio::async_write(server_stream, boost::asio::buffer(response), yield);
+        });
+        io_ctx.run();
+
+        client.join();
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * RESPONSE_SIZE));
+    state.SetLabel(server_stream.kernel_tls_send() ? "kTLS" : "user space");
+}
+BENCHMARK(BM_tls_TransferResponse)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,146 @@
+#include "networking/utils.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr const int NOF_NODES = 100000;
+constexpr const int NOF_EDGES = NOF_NODES - 1;
+
+server::graph_message build_mock_graph_message()
+{
+    graphs::Graph g;
+    g.set_uid(0);
+
+    for (int vertex_idx = 0; vertex_idx < NOF_NODES; ++vertex_idx)
+    {
+        auto *v = g.add_vertexlist();
+        v->set_uid(vertex_idx);
+    }
+
+    for (int edge_idx = 0; edge_idx < NOF_EDGES; ++edge_idx)
+    {
+        auto *e = g.add_edgelist();
+        e->set_uid(edge_idx);
+        e->set_invertexindex(edge_idx);
+        e->set_outvertexindex(edge_idx + 1);
+    }
+
+    return server::graph_message{g};
+}
+
+google::protobuf::RepeatedField<double> build_mock_edge_costs()
+{
+    google::protobuf::RepeatedField<double> costs;
+    for (int edge_idx = 0; edge_idx < NOF_EDGES; ++edge_idx)
+    {
+        costs.Add(edge_idx * 0.5);
+    }
+    return costs;
+}
+
+google::protobuf::RepeatedPtrField<graphs::VertexCoordinates> build_mock_coordinates()
+{
+    google::protobuf::RepeatedPtrField<graphs::VertexCoordinates> coords;
+    for (int vertex_idx = 0; vertex_idx < NOF_NODES; ++vertex_idx)
+    {
+        auto *c = coords.Add();
+        c->set_x(vertex_idx);
+        c->set_y(-vertex_idx);
+        c->set_z(0.0);
+    }
+    return coords;
+}
+
+}  // namespace
+
+static void BM_utils_ParseEdgeCosts(benchmark::State &state)
+{
+    const auto graph = build_mock_graph_message();
+    const auto costs = build_mock_edge_costs();
+    ogdf::EdgeArray<double> edge_costs(graph.graph());
+
+    for (auto _ : state)
+    {
+        server::utils::parse_edge_attribute(costs, graph, edge_costs);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_utils_ParseEdgeCosts);
+
+static void BM_utils_ParseEdgeCostsTransformed(benchmark::State &state)
+{
+    const auto graph = build_mock_graph_message();
+    const auto costs = build_mock_edge_costs();
+    ogdf::EdgeArray<double> edge_costs(graph.graph());
+
+    for (auto _ : state)
+    {
+        server::utils::parse_edge_attribute(costs, graph, edge_costs, [](double cost) {
+            return cost;
+        });
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_utils_ParseEdgeCostsTransformed);
+
+static void BM_utils_SerializeEdgeCosts(benchmark::State &state)
+{
+    const auto graph = build_mock_graph_message();
+    ogdf::EdgeArray<double> edge_costs(graph.graph());
+    server::utils::parse_edge_attribute(build_mock_edge_costs(), graph, edge_costs);
+
+    google::protobuf::RepeatedField<double> costs;
+    for (auto _ : state)
+    {
+        server::utils::serialize_edge_attribute(edge_costs, graph, costs);
+        benchmark::DoNotOptimize(costs.data());
+    }
+}
+BENCHMARK(BM_utils_SerializeEdgeCosts);
+
+static void BM_utils_SerializeEdgeCostsTransformed(benchmark::State &state)
+{
+    const auto graph = build_mock_graph_message();
+    ogdf::EdgeArray<double> edge_costs(graph.graph());
+    server::utils::parse_edge_attribute(build_mock_edge_costs(), graph, edge_costs);
+
+    google::protobuf::RepeatedField<double> costs;
+    for (auto _ : state)
+    {
+        server::utils::serialize_edge_attribute(edge_costs, graph, costs, [](double cost) {
+            return cost;
+        });
+        benchmark::DoNotOptimize(costs.data());
+    }
+}
+BENCHMARK(BM_utils_SerializeEdgeCostsTransformed);
+
+static void BM_utils_ParseNodeCoordinates(benchmark::State &state)
+{
+    const auto graph = build_mock_graph_message();
+    const auto coords = build_mock_coordinates();
+    ogdf::NodeArray<server::node_coordinates> node_coords(graph.graph());
+
+    for (auto _ : state)
+    {
+        server::utils::parse_node_attribute(coords, graph, node_coords);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_utils_ParseNodeCoordinates);
+
+static void BM_utils_SerializeNodeCoordinates(benchmark::State &state)
+{
+    const auto graph = build_mock_graph_message();
+    ogdf::NodeArray<server::node_coordinates> node_coords(graph.graph());
+    server::utils::parse_node_attribute(build_mock_coordinates(), graph, node_coords);
+
+    for (auto _ : state)
+    {
+        google::protobuf::RepeatedPtrField<graphs::VertexCoordinates> coords;
+        server::utils::serialize_node_attribute(node_coords, graph, coords);
+        benchmark::DoNotOptimize(coords.data());
+    }
+}
+BENCHMARK(BM_utils_SerializeNodeCoordinates);
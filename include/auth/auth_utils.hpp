@@ -1,8 +1,11 @@
 #pragma once
 
+#include <boost/asio/spawn.hpp>
+#include <chrono>
 #include <string>
 
 #include <persistence/database_wrapper.hpp>
+#include <persistence/user.hpp>
 
 namespace server {
 
@@ -31,6 +34,45 @@ namespace auth_utils {
      */
     bool hash_password(const std::string &pw, binary_data &hashed_pw, binary_data &salt);
 
+    /**
+     * @brief Same as check_password, but the hashing is done on the bounded authentication worker
+     *        pool while the calling coroutine is suspended.
+     *
+     * @throws boost::system::system_error if the queue of the worker pool is full
+     */
+    bool async_check_password(boost::asio::yield_context &yield, const std::string &password,
+                              const binary_data &salt, const binary_data &correct_hash);
+
+    /**
+     * @brief Same as hash_password, but the hashing is done on the bounded authentication worker
+     *        pool while the calling coroutine is suspended.
+     *
+     * @throws boost::system::system_error if the queue of the worker pool is full
+     */
+    bool async_hash_password(boost::asio::yield_context &yield, const std::string &pw,
+                             binary_data &hashed_pw, binary_data &salt);
+
+    /**
+     * @brief Issues a signed session token for an authenticated user.
+     *        The token is bound to the current password hash of the user, so changing the password
+     *        invalidates all issued tokens. Tokens are signed with a key generated at server start
+     *        and therefore do not survive a restart.
+     *
+     * @param user Constant reference to the authenticated user
+     * @param lifetime Duration the token stays valid
+     * @return std::string The session token
+     */
+    std::string issue_session_token(const user &user, std::chrono::seconds lifetime);
+
+    /**
+     * @brief Checks if a session token was issued for the given user and is not expired.
+     *
+     * @param token Constant reference to the token sent by the client
+     * @param user Constant reference to the user the token is used for
+     * @return bool True if the token is valid, else false is returned
+     */
+    bool check_session_token(const std::string &token, const user &user);
+
 }  // namespace auth_utils
 
 }  // namespace server
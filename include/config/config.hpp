@@ -9,12 +9,42 @@ namespace config_options {
     const char *const HELP = "help";
     const char *const CONFIG_FILE = "config-file";
     const char *const SERVER_PORT = "server-port";
+    const char *const SERVER_THREADS = "server-threads";
+    const char *const CONNECTION_IDLE_TIMEOUT = "connection-idle-timeout";
+    const char *const CONNECTION_PIPELINE_LIMIT = "connection-pipeline-limit";
+    const char *const CONNECTION_LIMIT = "connection-limit";
+    const char *const CONNECTION_READ_TIMEOUT = "connection-read-timeout";
+    const char *const CONNECTION_RATE_LIMIT = "connection-rate-limit";
+    const char *const REQUEST_RATE_LIMIT = "request-rate-limit";
+    const char *const PAYLOAD_MEMORY_BUDGET = "payload-memory-budget";
+    const char *const REQUEST_SIZE_LIMIT = "request-size-limit";
+    const char *const UPLOAD_LIMIT = "upload-limit";
+    const char *const UPLOAD_TIMEOUT = "upload-timeout";
+    const char *const UPLOAD_THREADS = "upload-threads";
     const char *const DB_HOST = "db-host";
     const char *const DB_PORT = "db-port";
     const char *const DB_USER = "db-user";
     const char *const DB_NAME = "db-name";
     const char *const DB_PASSWORD = "db-password";
     const char *const DB_TIMEOUT = "db-timeout";
+    const char *const DB_POOL_MIN_SIZE = "db-pool-min-size";
+    const char *const DB_POOL_MAX_SIZE = "db-pool-max-size";
+    const char *const DB_POOL_CHECK_INTERVAL = "db-pool-check-interval";
+    const char *const DB_POOL_IDLE_TIMEOUT = "db-pool-idle-timeout";
+    const char *const BLOB_STORE_PATH = "blob-store-path";
+    const char *const BLOB_STORE_THRESHOLD = "blob-store-threshold";
+    const char *const JOB_RETENTION_MONTHS = "job-retention-months";
+    const char *const JOB_RETENTION_MODE = "job-retention-mode";
+    const char *const JOB_DELETE_BATCH_SIZE = "job-delete-batch-size";
+    const char *const JOB_MAINTENANCE_INTERVAL = "job-maintenance-interval";
+    const char *const USER_CACHE_TTL = "user-cache-ttl";
+    const char *const PAYLOAD_COMPRESSION_LEVEL = "payload-compression-level";
+    const char *const PAYLOAD_DICT_INTERVAL = "payload-dict-interval";
+    const char *const PAYLOAD_DICT_SAMPLES = "payload-dict-samples";
+    const char *const PAYLOAD_DICT_SIZE = "payload-dict-size";
+    const char *const METRICS_ADDRESS = "metrics-address";
+    const char *const METRICS_PORT = "metrics-port";
+    const char *const TRACE_FILE = "trace-file";
     const char *const SCHEDULER_EXEC_PATH = "scheduler-exec-path";
     const char *const SCHEDULER_PROCESS_LIMIT = "scheduler-process-limit";
     const char *const SCHEDULER_TIME_LIMIT = "scheduler-time-limit";
@@ -22,6 +52,10 @@ namespace config_options {
     const char *const SCHEDULER_SLEEP = "scheduler-sleep";
     const char *const TLS_CERT_PATH = "tls-cert-path";
     const char *const TLS_KEY_PATH = "tls-key-path";
+    const char *const TLS_KERNEL_OFFLOAD = "tls-kernel-offload";
+    const char *const AUTH_THREADS = "auth-threads";
+    const char *const AUTH_QUEUE_LIMIT = "auth-queue-limit";
+    const char *const SESSION_TOKEN_LIFETIME = "session-token-lifetime";
 
 }  // namespace config_options
 
@@ -29,12 +63,42 @@ namespace config_env_vars {
 
     const char *const XDG_CONFIG_HOME = "XDG_CONFIG_HOME";
     const char *const SERVER_PORT = "SPANNERS_SERVER_PORT";
+    const char *const SERVER_THREADS = "SPANNERS_SERVER_THREADS";
+    const char *const CONNECTION_IDLE_TIMEOUT = "SPANNERS_CONNECTION_IDLE_TIMEOUT";
+    const char *const CONNECTION_PIPELINE_LIMIT = "SPANNERS_CONNECTION_PIPELINE_LIMIT";
+    const char *const CONNECTION_LIMIT = "SPANNERS_CONNECTION_LIMIT";
+    const char *const CONNECTION_READ_TIMEOUT = "SPANNERS_CONNECTION_READ_TIMEOUT";
+    const char *const CONNECTION_RATE_LIMIT = "SPANNERS_CONNECTION_RATE_LIMIT";
+    const char *const REQUEST_RATE_LIMIT = "SPANNERS_REQUEST_RATE_LIMIT";
+    const char *const PAYLOAD_MEMORY_BUDGET = "SPANNERS_PAYLOAD_MEMORY_BUDGET";
+    const char *const REQUEST_SIZE_LIMIT = "SPANNERS_REQUEST_SIZE_LIMIT";
+    const char *const UPLOAD_LIMIT = "SPANNERS_UPLOAD_LIMIT";
+    const char *const UPLOAD_TIMEOUT = "SPANNERS_UPLOAD_TIMEOUT";
+    const char *const UPLOAD_THREADS = "SPANNERS_UPLOAD_THREADS";
     const char *const DB_HOST = "SPANNERS_DB_HOST";
     const char *const DB_PORT = "SPANNERS_DB_PORT";
     const char *const DB_USER = "SPANNERS_DB_USER";
     const char *const DB_NAME = "SPANNERS_DB_NAME";
     const char *const DB_PASSWORD = "SPANNERS_DB_PASSWORD";
     const char *const DB_TIMEOUT = "SPANNERS_DB_TIMEOUT";
+    const char *const DB_POOL_MIN_SIZE = "SPANNERS_DB_POOL_MIN_SIZE";
+    const char *const DB_POOL_MAX_SIZE = "SPANNERS_DB_POOL_MAX_SIZE";
+    const char *const DB_POOL_CHECK_INTERVAL = "SPANNERS_DB_POOL_CHECK_INTERVAL";
+    const char *const DB_POOL_IDLE_TIMEOUT = "SPANNERS_DB_POOL_IDLE_TIMEOUT";
+    const char *const BLOB_STORE_PATH = "SPANNERS_BLOB_STORE_PATH";
+    const char *const BLOB_STORE_THRESHOLD = "SPANNERS_BLOB_STORE_THRESHOLD";
+    const char *const JOB_RETENTION_MONTHS = "SPANNERS_JOB_RETENTION_MONTHS";
+    const char *const JOB_RETENTION_MODE = "SPANNERS_JOB_RETENTION_MODE";
+    const char *const JOB_DELETE_BATCH_SIZE = "SPANNERS_JOB_DELETE_BATCH_SIZE";
+    const char *const JOB_MAINTENANCE_INTERVAL = "SPANNERS_JOB_MAINTENANCE_INTERVAL";
+    const char *const USER_CACHE_TTL = "SPANNERS_USER_CACHE_TTL";
+    const char *const PAYLOAD_COMPRESSION_LEVEL = "SPANNERS_PAYLOAD_COMPRESSION_LEVEL";
+    const char *const PAYLOAD_DICT_INTERVAL = "SPANNERS_PAYLOAD_DICT_INTERVAL";
+    const char *const PAYLOAD_DICT_SAMPLES = "SPANNERS_PAYLOAD_DICT_SAMPLES";
+    const char *const PAYLOAD_DICT_SIZE = "SPANNERS_PAYLOAD_DICT_SIZE";
+    const char *const METRICS_ADDRESS = "SPANNERS_METRICS_ADDRESS";
+    const char *const METRICS_PORT = "SPANNERS_METRICS_PORT";
+    const char *const TRACE_FILE = "SPANNERS_TRACE_FILE";
     const char *const SCHEDULER_EXEC_PATH = "SPANNERS_SCHEDULER_EXEC_PATH";
     const char *const SCHEDULER_PROCESS_LIMIT = "SPANNERS_SCHEDULER_PROCESS_LIMIT";
     const char *const SCHEDULER_TIME_LIMIT = "SPANNERS_SCHEDULER_TIME_LIMIT";
@@ -42,6 +106,10 @@ namespace config_env_vars {
     const char *const SCHEDULER_SLEEP = "SPANNERS_SCHEDULER_SLEEP";
     const char *const TLS_CERT_PATH = "SPANNERS_TLS_CERT_PATH";
     const char *const TLS_KEY_PATH = "SPANNERS_TLS_KEY_PATH";
+    const char *const TLS_KERNEL_OFFLOAD = "SPANNERS_TLS_KERNEL_OFFLOAD";
+    const char *const AUTH_THREADS = "SPANNERS_AUTH_THREADS";
+    const char *const AUTH_QUEUE_LIMIT = "SPANNERS_AUTH_QUEUE_LIMIT";
+    const char *const SESSION_TOKEN_LIFETIME = "SPANNERS_SESSION_TOKEN_LIFETIME";
 
 }  // namespace config_env_vars
 
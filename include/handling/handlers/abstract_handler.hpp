@@ -5,6 +5,7 @@
 
 #include <handling/handler_factory.hpp>
 #include <networking/responses/abstract_response.hpp>
+#include <util/job_phases.hpp>
 #include "available_handlers.pb.h"
 
 namespace server {
@@ -97,6 +97,7 @@ handle_return general_spanner_handler<spanner_algorithm>::handle()
     auto return_type = spanner_algorithm_instance.call(ga, stretch, *spanner, in_spanner);
     auto stop = std::chrono::high_resolution_clock::now();
     long ogdf_time = (std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count();
+    const job_phases::scope result_phase{job_phases::RESULT};
 
     const auto &og_node_uids = graph_message->node_uids();
     const auto *og_node_coords = m_request->node_coords();
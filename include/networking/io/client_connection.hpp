@@ -4,11 +4,19 @@
 #include <boost/asio.hpp>
 #include <boost/asio/spawn.hpp>
 #include <boost/asio/ssl.hpp>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <vector>
 
+#include <networking/io/job_subscriptions.hpp>
+#include <networking/io/rate_limiter.hpp>
+#include <networking/io/tls_stream.hpp>
 #include <networking/messages/meta_data.hpp>
-#include <persistence/database_wrapper.hpp>  // for binary_data
+#include <persistence/database_pool.hpp>
+#include <persistence/database_wrapper.hpp>  // for binary_data, compressed_data, mapped_blob
+#include <persistence/user.hpp>
 
 #include "container.pb.h"
 #include "error.pb.h"
@@ -20,19 +28,25 @@ template <typename CONNECTION_TYPE>
 class connection_handler;
 
 /**
- * @brief Representaion of a tcp connection communicating with gzip compressed protobuf messages.
+ * @brief Representaion of a tcp connection communicating with compressed protobuf messages.
  *
  * A connections lifetime is always managed by a <server::connection_handler>
  *
- * A successful connection receives a <graphs::RequestContainer> and always responds with a
- *  <graphs::ResponseContainer> protobuf. Request and response are gzip compressed and serialized
- *  protobuf messages.
+ * A connection stays open for multiple framed requests. Each frame consists of the size of the
+ *  <graphs::MetaData>, the meta data itself and a container compressed with the codec named in
+ *  the meta data (see <server::compression>). Requests may be pipelined: every request is handled
+ *  in its own coroutine and its response carries the request id of the meta data, so responses
+ *  can be matched even if they are sent out of order.
+ *  After a SUBSCRIBE request, status changes of the users jobs are pushed as responses to it.
+ *  Idle connections without a subscription are closed after a configurable timeout, as are
+ *  connections taking too long to send a started request. Received payloads are accounted in the
+ *  global <server::memory_budget> and the request rate of every client address is limited.
  */
 class client_connection
 {
 public:
 #ifndef SPANNERS_UNENCRYPTED_CONNECTION
-    using socket_ptr = std::unique_ptr<boost::asio::ssl::stream<boost::asio::ip::tcp::socket>>;
+    using socket_ptr = std::unique_ptr<tls_stream>;
 #else
     using socket_ptr = std::unique_ptr<boost::asio::ip::tcp::socket>;
 #endif
@@ -42,10 +56,14 @@ public:
      * @param id Identifier of the connection in the corresponding <server::connection_handler>.
      *          Used to destruct the connection when handling is finished
      * @param connection_handler Reference to the lifetime managing <server::connection_handler>.
-     * @param socket Underlying socket of the connection.
+     * @param socket Underlying socket of the connection. Its executor should be a strand, since
+     *          the connection may be served by multiple threads.
+     * @param source Address of the client, used for rate limiting
+     * @param request_limiter Limits the rate of requests per address
      */
     explicit client_connection(size_t id, connection_handler<client_connection> &handler,
-                               socket_ptr sock);
+                               socket_ptr sock, boost::asio::ip::address source,
+                               rate_limiter &request_limiter);
 
     client_connection(const client_connection &) = delete;
     client_connection &operator=(const client_connection &) = delete;
@@ -56,40 +74,143 @@ public:
 
     /**
      * @brief Handles receiving and responding.
-     *  Creates a boost coroutine to handle the request and respond to the client.
+     *  Creates a boost coroutine on the sockets strand that performs the TLS handshake (if
+     *  encryption is enabled) and reads requests until the client closes the connection or it
+     *  times out. A second coroutine writes the responses.
      *  When finished this function will automatically deregister the connection from m_handler
      */
     void handle();
 
 private:
-    /// Internal handling of the connection
-    void handle_internal(boost::asio::yield_context &yield);
+    /// Reads framed requests and spawns a coroutine handling each of them
+    void read_requests(boost::asio::yield_context &yield);
 
-    /// Read a protobuf message from the underlying socket connection and parse it according to the template type
+    /// Writes queued responses until all requests are handled and the reader finished
+    void write_responses(boost::asio::yield_context &yield);
+
+    /// Runs the handler and catches all errors, so they are sent as error responses
+    template <typename Handler>
+    void handle_errors(const graphs::MetaData &meta_proto, Handler &&handler);
+
+    /// Handles a single request and catches all errors, so they are sent as error responses
+    void handle_request(boost::asio::yield_context &yield, const graphs::MetaData &meta_proto,
+                        const std::vector<char> &container);
+
+    /// Internal handling of a single request
+    void handle_internal(boost::asio::yield_context &yield, const graphs::MetaData &meta_proto,
+                         const std::vector<char> &container);
+
+    /// Checks the credentials or session token of the request, throws if they are invalid
+    user authenticate(boost::asio::yield_context &yield, const graphs::MetaData &meta_proto);
+
+    /// Takes the decompressed data of an upload piece by piece
+    using upload_consumer = std::function<void(const char *, size_t)>;
+
+    /// Decompresses an upload into a consumer, returns false if the connection broke meanwhile
+    using upload_reader = std::function<bool(const upload_consumer &)>;
+
+    /**
+     * @brief Receives a container which is decompressed piece by piece while it is read from the
+     *  socket instead of being buffered, checking the upload limit of the user on the way.
+     *
+     * @param receive Called with the authenticated user and the reader of the upload, it
+     *  responds to the request. Errors thrown by either are sent to the client.
+     *
+     * @return bool False if the connection is broken and no further frames can be read
+     */
+    bool receive_streamed(boost::asio::yield_context &yield, const graphs::MetaData &meta_proto,
+                          const std::function<void(const user &, const upload_reader &)> &receive);
+
+    /**
+     * @brief Receives the container of a new job and streams it into the database, see
+     *  receive_streamed()
+     *
+     * @return bool False if the connection is broken and no further frames can be read
+     */
+    bool receive_job(boost::asio::yield_context &yield, const graphs::MetaData &meta_proto);
+
+    /**
+     * @brief Receives the container of an UPLOAD_GRAPH request and stores its graph, see
+     *  receive_streamed()
+     *
+     * @return bool False if the connection is broken and no further frames can be read
+     */
+    bool receive_graph(boost::asio::yield_context &yield, const graphs::MetaData &meta_proto);
+
+    /// Acquires a connection from the database pool, suspending while none is free
+    database_pool::lease database(boost::asio::yield_context &yield);
+
+    /// (Re)starts the idle timeout of the connection
+    void restart_idle_timer();
+
+    /// Starts the read timeout, the connection is closed unless m_read_deadline is cancelled in time
+    void start_read_deadline();
+
+    /// Starts the timeout of a whole job upload, the connection is closed unless
+    /// m_upload_deadline is cancelled in time
+    void start_upload_deadline();
+
+    /// Delays reading the next request if the client exceeds its request rate
+    void throttle(boost::asio::yield_context &yield);
+
+    /// A framed response: length field and meta data, followed by the compressed container.
+    /// The container consists of an already compressed part read from the database or the blob
+    /// store (may be empty) and a part compressed for this response.
+    struct outgoing_frame {
+        std::vector<char> header;
+        binary_data stored_part;
+        std::optional<mapped_blob> stored_blob;
+        std::vector<char> container;
+
+        size_t stored_size() const
+        {
+            return stored_blob ? stored_blob->size() : stored_part.size();
+        }
+    };
+
+    /// Read the meta data of a request from the underlying socket connection
+    graphs::MetaData read_meta_data(boost::asio::yield_context &yield, size_t len);
+
+    /// Decompress and parse a received container according to the template type
     template <typename MESSAGE_TYPE>
-    MESSAGE_TYPE read_message(boost::asio::yield_context &yield, size_t len);
+    MESSAGE_TYPE parse_container(const graphs::MetaData &meta_proto,
+                                 const std::vector<char> &container);
 
     /// Respond with a serializable in form of a protobuf message
     template <class Serializable>
-    void respond(boost::asio::yield_context &yield, const meta_data &meta_info,
+    void respond(const graphs::MetaData &request, const meta_data &meta_info,
                  const Serializable &container);
 
-    /// Respond with binary data (used for responses read from the database)
-    void respond(boost::asio::yield_context &yield, const meta_data &meta_info,
-                 const binary_data &binary);
+    /// Respond with compressed data read from the database, followed by an appended message
+    void respond_stored(const graphs::MetaData &request, const meta_data &meta_info,
+                        compressed_data stored, const graphs::ResponseContainer &appended);
 
     /// Respond an error response with a graphs::ResponseContainer containing the given status code as its body
-    void respond_error(boost::asio::yield_context &yield,
+    void respond_error(const graphs::MetaData &request,
                        graphs::ResponseContainer::StatusCode code);
 
     /// Respond an error response with a graphs::ErrorMessage as its body
-    void respond_error(boost::asio::yield_context &yield, graphs::ErrorType error_type);
+    void respond_error(const graphs::MetaData &request, graphs::ErrorType error_type);
+
+    /// Meta data of a response to the given request, using the compression codec of the request
+    graphs::MetaData build_response_meta(const graphs::MetaData &request,
+                                         const meta_data &meta_info);
+
+    /// Queue a response for the writing coroutine
+    void enqueue_response(graphs::MetaData &meta_proto, outgoing_frame frame);
 
     /// Read data from the underlying socket connection
     bool direct_read(boost::asio::yield_context &yield, char *const data, size_t length);
 
-    /// Write data to the underlying socket connection
-    void direct_write(boost::asio::yield_context &yield, const char *data, size_t length);
+    /// Write a framed response to the underlying socket connection
+    bool write_frame(boost::asio::yield_context &yield, const outgoing_frame &frame);
+
+    /// Socket files can be sent to with sendfile(), nullptr if data is encrypted in user space
+    boost::asio::ip::tcp::socket *file_socket();
+
+    /// Send a mapped blob with sendfile(), the data is not copied to user space
+    size_t send_file(boost::asio::yield_context &yield, const mapped_blob &blob,
+                     boost::system::error_code &error);
 
     /// Identifier used to identify the connection within m_handler
     size_t m_identifier;
@@ -99,6 +220,43 @@ private:
 
     /// Underlying socket for network communications
     socket_ptr m_sock;
+
+    /// Framed responses waiting to be written
+    std::deque<outgoing_frame> m_outbox;
+
+    /// Number of requests currently handled
+    size_t m_pending_requests{};
+
+    /// True if the client closed the connection or reading failed
+    bool m_reading_finished{false};
+
+    /// Cancelled to wake up the writing coroutine
+    boost::asio::steady_timer m_writer_signal;
+
+    /// Cancelled to wake up the reading coroutine waiting for a free request slot
+    boost::asio::steady_timer m_reader_signal;
+
+    /// Closes the connection if no request was received for a while
+    boost::asio::steady_timer m_idle_timer;
+
+    /// Closes the connection if a started read takes too long
+    boost::asio::steady_timer m_read_deadline;
+
+    /// Closes the connection if a job upload takes too long, even if every read is in time
+    boost::asio::steady_timer m_upload_deadline;
+
+    /// Address of the client
+    boost::asio::ip::address m_source;
+
+    /// Limits the rate of requests per address
+    rate_limiter &m_request_limiter;
+
+    /// Subscription to the status changes of the users jobs, if the client asked for it
+    std::shared_ptr<job_subscriptions::subscription> m_subscription;
+
+    /// Expires with the connection. Timer handlers already queued when the connection finished
+    /// can not be cancelled anymore, they check it before touching the connection.
+    std::shared_ptr<const bool> m_alive{std::make_shared<const bool>(true)};
 };
 
 }  // namespace server
@@ -8,13 +8,18 @@
 #include <networking/io/client_connection.hpp>
 #include <networking/io/connection_handler.hpp>
 #include <networking/io/io_server.hpp>
+#include <networking/io/rate_limiter.hpp>
 
 namespace server {
 
 /**
  * @brief Server class to provide async network io.
  *
- * Connections are handled via class <connection> and managed via <connection_handler>
+ * Connections are handled via class <connection> and managed via <connection_handler>. The i/o
+ * context is run by a pool of threads, every connection is bound to its own strand.
+ * While the connection limit is reached, no further connections are accepted, so new clients
+ * wait in the listen backlog. Connections of addresses exceeding the connection rate limit are
+ * closed right away.
  */
 class client_server : public io_server
 {
@@ -24,8 +29,9 @@ public:
      * @brief Constructor for client server serving unencrypted connections
      *
      * @param listening_port Port on which the server should listen for incoming connections
+     * @param nof_threads Number of threads serving client connections
      */
-    explicit client_server(unsigned short listening_port);
+    client_server(unsigned short listening_port, size_t nof_threads);
 #else
     /**
      * @brief Constructor for client server server encrypted connections
@@ -33,9 +39,10 @@ public:
      * @param listening_port Port on which the server short listen for incoming connections
      * @param cert_path Path to the servers PEM encoded public certificate used for TLS connections
      * @param key_path Path to the servers PEM encoded private key used for TLS connections
+     * @param nof_threads Number of threads serving client connections
      */
     client_server(unsigned short listening_port, const std::string &cert_path,
-                  const std::string &key_path);
+                  const std::string &key_path, size_t nof_threads);
 #endif
 
     client_server(const client_server &) = delete;
@@ -64,6 +71,18 @@ private:
 
     /// Storage to keep active connections alive
     connection_handler<client_connection> m_connections;
+
+    /// Cancelled to wake up the accept loop waiting for a connection to finish
+    boost::asio::steady_timer m_accept_signal;
+
+    /// Limits the rate of new connections per address
+    rate_limiter m_connection_limiter;
+
+    /// Limits the rate of requests per address, shared by all connections
+    rate_limiter m_request_limiter;
+
+    /// Identifier for the next accepted connection. Only accessed by the accept loop.
+    size_t m_next_connection_id{};
 };
 
 }  // namespace server
@@ -0,0 +1,105 @@
+#ifndef IO_SERVER_COMPRESSION_HPP
+#define IO_SERVER_COMPRESSION_HPP
+
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <google/protobuf/message_lite.h>
+#include <functional>
+#include <vector>
+
+#include "meta.pb.h"
+
+namespace server {
+
+/**
+ * @brief Compression of the containers sent between client and server.
+ *
+ * The codec is negotiated per request using the compression field of <graphs::MetaData>: the
+ *  server decompresses a request with the codec named by the client and responds with the same
+ *  codec. GZIP is the default and always available, NONE is meant for local links and ZSTD is only
+ *  available if the server was built with zstd support.
+ *
+ * Messages are (de)compressed through protobuf's ZeroCopy streams, so the uncompressed
+ *  serialization is never materialised in an intermediate buffer.
+ */
+namespace compression {
+
+    using codec = graphs::CompressionType;
+
+    /**
+     * @brief Checks if a codec is supported by this build of the server
+     */
+    bool is_supported(codec type);
+
+    /**
+     * @brief Decompresses and parses a protobuf message in a single pass
+     *
+     * @param type Codec the data is compressed with
+     * @param data Pointer to the compressed data
+     * @param size Size of the compressed data in bytes
+     * @param message Message to parse into
+     * @return bool True if the data could be decompressed and parsed, else false is returned
+     */
+    bool parse(codec type, const char *data, size_t size, google::protobuf::MessageLite &message);
+
+    /**
+     * @brief Serializes and compresses a protobuf message in a single pass
+     *
+     * @param type Codec to compress with
+     * @param message Message to serialize
+     * @param out Buffer the compressed data is appended to
+     */
+    void serialize(codec type, const google::protobuf::MessageLite &message,
+                   std::vector<char> &out);
+
+    /**
+     * @brief Compresses raw data
+     *
+     * @param type Codec to compress with
+     * @param data Pointer to the uncompressed data
+     * @param size Size of the uncompressed data in bytes
+     * @param out Buffer the compressed data is appended to
+     */
+    void compress(codec type, const char *data, size_t size, std::vector<char> &out);
+
+    /**
+     * @brief Decompresses raw data
+     *
+     * @param type Codec the data is compressed with
+     * @param data Pointer to the compressed data
+     * @param size Size of the compressed data in bytes
+     * @param out Buffer the decompressed data is appended to
+     * @return bool True if the data could be decompressed, else false is returned
+     */
+    bool decompress(codec type, const char *data, size_t size, std::vector<char> &out);
+
+    /**
+     * @brief Runs a reader on a stream decompressing the given data, for readers working on the
+     *        wire format instead of parsing a whole message
+     *
+     * @param type Codec the data is compressed with
+     * @param data Pointer to the compressed data
+     * @param size Size of the compressed data in bytes
+     * @param reader Reads from the decompressing stream, returns false on failure
+     * @return bool True if the data could be decompressed and the reader succeeded
+     */
+    bool with_decompressed(codec type, const char *data, size_t size,
+                           const std::function<bool(google::protobuf::io::ZeroCopyInputStream &)>
+                               &reader);
+
+    /**
+     * @brief Decompresses data read from a stream chunk by chunk, so the decompressed data never
+     *        has to be held in memory at once
+     *
+     * @param type Codec the data is compressed with
+     * @param compressed Stream providing the compressed data
+     * @param consumer Called with every decompressed chunk, may return false to stop
+     * @return bool True if all data could be decompressed and was consumed, else false is returned
+     */
+    bool decompress(codec type, google::protobuf::io::ZeroCopyInputStream &compressed,
+                    const std::function<bool(const char *, size_t)> &consumer);
+
+}  // namespace compression
+
+}  // namespace server
+
+#endif
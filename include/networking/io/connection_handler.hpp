@@ -1,13 +1,18 @@
 #ifndef IO_SERVER_CONNECTION_HANDLER_HPP
 #define IO_SERVER_CONNECTION_HANDLER_HPP
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 
 namespace server {
 
 /**
  * @brief Class to manage the lifetime of active/not finished <server::connection>s.
+ *
+ * All methods are thread-safe, so connections running on different threads of the same i/o
+ * context may remove themselves concurrently.
  */
 template <typename CONNECTION_TYPE>
 class connection_handler
@@ -22,9 +27,20 @@ public:
      */
     bool add(size_t identifier, std::unique_ptr<connection_type> connection)
     {
-        if (auto [conn_it, success] = m_store.insert({identifier, std::move(connection)}); success)
+        connection_type *added = nullptr;
         {
-            conn_it->second->handle();
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (auto [conn_it, success] = m_store.insert({identifier, std::move(connection)});
+                success)
+            {
+                added = conn_it->second.get();
+            }
+        }
+
+        // Start handling outside of the lock, the connection may remove itself at any time
+        if (added)
+        {
+            added->handle();
             return true;
         }
         return false;
@@ -36,17 +52,52 @@ public:
      */
     bool remove(size_t identifier)
     {
-        if (const auto &conn_it = m_store.find(identifier); conn_it != m_store.end())
+        std::unique_ptr<connection_type> removed;
         {
-            m_store.erase(conn_it);
-            return true;
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (const auto &conn_it = m_store.find(identifier); conn_it != m_store.end())
+            {
+                removed = std::move(conn_it->second);
+                m_store.erase(conn_it);
+            }
         }
-        return false;
+
+        // Destroy the connection outside of the lock
+        if (!removed)
+        {
+            return false;
+        }
+        removed.reset();
+
+        if (m_on_remove)
+        {
+            m_on_remove();
+        }
+        return true;
     }
 
+    /// Number of managed connections
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_store.size();
+    }
+
+    /**
+     * @brief Sets a callback run after a connection was removed and destroyed. Must be set before
+     *  the first connection is added.
+     */
+    void on_remove(std::function<void()> callback) { m_on_remove = std::move(callback); }
+
 private:
+    /// Guards m_store
+    std::mutex m_mutex;
+
     /// Underlying storage for all handled connections
     std::map<size_t, std::unique_ptr<connection_type>> m_store;
+
+    /// Called after a connection was removed
+    std::function<void()> m_on_remove;
 };
 
 }  // namespace server
@@ -1,8 +1,10 @@
 #ifndef IO_SERVER_HPP
 #define IO_SERVER_HPP
 
+#include <atomic>
 #include <boost/asio.hpp>
 #include <future>
+#include <vector>
 
 namespace server {
 
@@ -15,7 +17,13 @@ protected:
     /// Enum representing the servers listening status
     enum server_status { STOPPED, RUNNING };
 
-    io_server() = default;
+    /**
+     * @brief Constructs the io server
+     *
+     * @param nof_threads Number of threads running the servers i/o context. Values smaller than
+     *  one are treated as one.
+     */
+    explicit io_server(size_t nof_threads = 1);
     io_server(const io_server &) = delete;
     io_server &operator=(const io_server &) = delete;
 
@@ -23,7 +31,8 @@ protected:
 
     /**
      * @brief Runs the io server until program aborts.
-     *  Blocking function that runs the io server indefinitely.
+     *  Blocking function that runs the io server indefinitely. The calling thread is used as one of
+     *  the servers threads.
      */
     virtual void run();
 
@@ -48,13 +57,23 @@ protected:
     virtual void handle() = 0;
 
     /// Listening status of the server
-    server_status m_status = STOPPED;
+    std::atomic<server_status> m_status{STOPPED};
 
-    /// Future to keep the handling function running in the background when using start() function
-    std::future<void> m_future;
+    /// Futures to keep the threads running the i/o context alive in the background
+    std::vector<std::future<void>> m_futures;
+
+    /// Number of threads running m_ctx
+    const size_t m_nof_threads;
 
     /// The servers i/o context is used for all async network operations
-    boost::asio::io_context m_ctx{1};
+    boost::asio::io_context m_ctx;
+
+private:
+    /// Launches the background threads running m_ctx
+    void spawn_threads(size_t nof_threads);
+
+    /// Waits for all background threads to finish
+    void join_threads();
 };
 
 }  // namespace server
@@ -0,0 +1,79 @@
+#ifndef IO_SERVER_JOB_SUBSCRIPTIONS_HPP
+#define IO_SERVER_JOB_SUBSCRIPTIONS_HPP
+
+#include <boost/asio/any_io_executor.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "status.pb.h"
+
+namespace server {
+
+/**
+ * @brief Registry of clients subscribed to the status changes of their jobs.
+ *
+ * The scheduler notifies the registry whenever a job changes its state, the registry forwards the
+ * status to all subscriptions of the jobs owner. Subscriptions are owned by the subscriber and
+ * only referenced weakly here, so a subscription simply ends when its owner drops it.
+ *
+ * All methods are thread-safe.
+ */
+class job_subscriptions
+{
+public:
+    using push_function = std::function<void(const graphs::StatusSingle &)>;
+
+    /**
+     * @brief A single subscription. The push function is always called on the executor of the
+     *  subscription, and only as long as the subscription is alive.
+     */
+    struct subscription {
+        boost::asio::any_io_executor executor;
+        push_function push;
+    };
+
+    static job_subscriptions &instance();
+
+    /**
+     * @brief Subscribes to the status changes of all jobs of a user
+     *
+     * @param user_id ID of the user whose jobs are observed
+     * @param executor Executor the push function is called on. Destroying the returned
+     *  subscription on the same executor guarantees no push happens afterwards.
+     * @param push Called with the new status of a job
+     *
+     * @return std::shared_ptr<subscription> The subscription, active as long as it is held
+     */
+    std::shared_ptr<subscription> subscribe(int user_id, boost::asio::any_io_executor executor,
+                                            push_function push);
+
+    /**
+     * @brief Checks if anyone is subscribed to the jobs of a user, so the status only needs to be
+     *  fetched if it is going to be pushed
+     */
+    bool has_subscribers(int user_id);
+
+    /**
+     * @brief Pushes a new job status to all subscriptions of a user. Returns immediately, the
+     *  push functions are run on the executors of the subscriptions.
+     */
+    void notify(int user_id, const graphs::StatusSingle &status);
+
+private:
+    job_subscriptions() = default;
+
+    /// Removes expired subscriptions of a user. Requires m_mutex to be locked.
+    void remove_expired(int user_id);
+
+    /// Guards m_subscriptions
+    std::mutex m_mutex;
+
+    /// Subscriptions by user ID
+    std::unordered_multimap<int, std::weak_ptr<subscription>> m_subscriptions;
+};
+
+}  // namespace server
+
+#endif
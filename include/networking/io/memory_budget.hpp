@@ -0,0 +1,82 @@
+#ifndef IO_SERVER_MEMORY_BUDGET_HPP
+#define IO_SERVER_MEMORY_BUDGET_HPP
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace server {
+
+/**
+ * @brief Global budget for request payloads held in memory by the client connections.
+ *
+ * Connections reserve the size of a payload before allocating it. If the budget is exhausted,
+ * the reading coroutine is suspended until enough memory is released, so clients are slowed
+ * down by TCP backpressure instead of the server running out of memory. A single payload larger
+ * than the whole budget is admitted once nothing else is reserved, so it can not wait forever.
+ *
+ * The size of the budget is read from the config on first use. All methods are thread-safe.
+ */
+class memory_budget
+{
+public:
+    /**
+     * @brief Reserved part of the budget, released on destruction
+     */
+    class reservation
+    {
+    public:
+        reservation() = default;
+        reservation(reservation &&rhs) noexcept;
+        reservation &operator=(reservation &&rhs) noexcept;
+        ~reservation();
+
+        reservation(const reservation &) = delete;
+        reservation &operator=(const reservation &) = delete;
+
+        size_t size() const { return m_size; }
+
+    private:
+        friend class memory_budget;
+        explicit reservation(size_t size);
+
+        size_t m_size{};
+    };
+
+    static memory_budget &instance();
+
+    /**
+     * @brief Reserves memory for a payload, suspending the coroutine until it is available
+     *
+     * @param yield Coroutine to suspend
+     * @param executor Executor of the coroutine (the strand it was spawned on), used to wake it up
+     * @param size Number of bytes to reserve
+     * @return reservation Reserved memory, held as long as the payload is
+     */
+    reservation reserve(boost::asio::yield_context &yield,
+                        const boost::asio::any_io_executor &executor, size_t size);
+
+private:
+    memory_budget();
+
+    void release(size_t size);
+
+    /// Guards m_used and m_waiters
+    std::mutex m_mutex;
+
+    /// Size of the budget in bytes, zero if unlimited
+    const size_t m_limit;
+
+    /// Currently reserved bytes
+    size_t m_used{};
+
+    /// Signals of coroutines waiting for memory, cancelled to wake them up
+    std::vector<std::weak_ptr<boost::asio::steady_timer>> m_waiters;
+};
+
+}  // namespace server
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef IO_METRICS_SERVER_HPP
+#define IO_METRICS_SERVER_HPP
+
+#include <boost/asio.hpp>
+#include <boost/asio/spawn.hpp>
+#include <string>
+
+#include <networking/io/io_server.hpp>
+
+namespace server {
+
+/**
+ * @brief Minimal HTTP server exporting the <metrics> of the server for Prometheus.
+ *
+ * GET /metrics responds with all metrics in the text exposition format, every other request with
+ * 404. Each connection serves a single request and is closed afterwards. The server is meant for
+ * scraping from the local machine and listens on loopback unless metrics-address says otherwise.
+ */
+class metrics_server : public io_server
+{
+public:
+    /**
+     * @param address Address to listen on
+     * @param port Port to listen on
+     */
+    metrics_server(const std::string &address, unsigned short port);
+
+    metrics_server(const metrics_server &) = delete;
+    metrics_server &operator=(const metrics_server &) = delete;
+    metrics_server(metrics_server &&) = delete;
+    metrics_server &operator=(metrics_server &&) = delete;
+
+    ~metrics_server() = default;
+
+    // Use functions provided by abstract base class
+    using io_server::run;
+    using io_server::start;
+    using io_server::stop;
+
+private:
+    /// Accepts connections and serves each in a coroutine of its own
+    void handle() override;
+
+    /// Reads the request from a connection and responds to it
+    void serve(boost::asio::yield_context &yield, boost::asio::ip::tcp::socket &sock);
+
+    boost::asio::ip::tcp::acceptor m_acceptor;
+};
+
+}  // namespace server
+
+#endif
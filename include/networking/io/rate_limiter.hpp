@@ -0,0 +1,71 @@
+#ifndef IO_SERVER_RATE_LIMITER_HPP
+#define IO_SERVER_RATE_LIMITER_HPP
+
+#include <boost/asio/ip/address.hpp>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+namespace server {
+
+/**
+ * @brief Token bucket rate limiting per source address.
+ *
+ * Every address gets a bucket filling up with the configured rate up to the burst size. Buckets
+ * that filled up completely are dropped from time to time, so the number of remembered addresses
+ * stays bounded by the recently active ones.
+ *
+ * All methods are thread-safe.
+ */
+class rate_limiter
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @param rate Tokens per second, the limiter is disabled if zero or negative
+     * @param burst Maximum number of tokens a source can accumulate
+     */
+    rate_limiter(double rate, double burst);
+
+    /**
+     * @brief Takes a token of the source
+     * @return bool False if the source has no token left, nothing is taken then
+     */
+    bool try_acquire(const boost::asio::ip::address &source);
+
+    /**
+     * @brief Takes a token of the source even if none is left
+     * @return clock::duration Time the source has to wait until the token would have been
+     *  available, zero if it was
+     */
+    clock::duration acquire(const boost::asio::ip::address &source);
+
+private:
+    struct address_hash {
+        size_t operator()(const boost::asio::ip::address &address) const;
+    };
+
+    struct bucket {
+        double tokens;
+        clock::time_point updated;
+    };
+
+    /// Bucket of the source, refilled up to now. Requires m_mutex to be locked.
+    bucket &refilled_bucket(const boost::asio::ip::address &source, clock::time_point now);
+
+    const double m_rate;
+    const double m_burst;
+
+    /// Guards m_buckets and m_sweep_size
+    std::mutex m_mutex;
+
+    std::unordered_map<boost::asio::ip::address, bucket, address_hash> m_buckets;
+
+    /// Number of buckets at which full buckets are dropped next
+    size_t m_sweep_size;
+};
+
+}  // namespace server
+
+#endif
@@ -1,10 +1,15 @@
 #ifndef IO_SERVER_REQUEST_HANDLING_HPP
 #define IO_SERVER_REQUEST_HANDLING_HPP
 
+#include <boost/asio/spawn.hpp>
+#include <functional>
+#include <string>
 #include <vector>
 
 #include <networking/messages/meta_data.hpp>
+#include <persistence/database_pool.hpp>
 #include <persistence/database_wrapper.hpp>
+#include <persistence/job_upload.hpp>
 #include <persistence/user.hpp>
 
 #include "container.pb.h"
@@ -20,6 +25,16 @@ namespace request_handling {
      */
     using handled_request = std::pair<meta_data, graphs::ResponseContainer>;
 
+    /**
+     * @brief handled_result Result of a handled result request. The stored response is sent
+     *  without recompression, followed by the separately compressed latest status of the job.
+     */
+    struct handled_result {
+        meta_data meta;
+        compressed_data response;
+        graphs::ResponseContainer status;
+    };
+
     /**
      * @brief Creates response to requests for all available handlers
      *
@@ -30,27 +45,34 @@ namespace request_handling {
     /**
      * @brief Creates response to requests asking for job status data
      *
+     * All states are built from a single query. The request may limit the number of returned
+     * jobs and pass the cursor of a previous response to only get the jobs changed since then.
+     *
      * @param db Reference to a database connection to get the status information from
+     * @param request Constant reference to the container of a graphs::StatusRequest, an empty
+     * container asks for all jobs
      * @param user Constant reference to a user struct to only query for one users jobs
      *
      * @return handled_request containing the meta data and the response
      */
-    handled_request handle_status(database_wrapper &db, const user &user);
+    handled_request handle_status(database_wrapper &db, const graphs::RequestContainer &request,
+                                  const user &user);
 
     /**
      * @brief Creates response to requests for job results
      *
+     * If the request selects fields or an element range, the stored response is sliced
+     * accordingly and returned uncompressed (see <server::slice_result>).
+     *
      * @param db Reference to a database connection to get the status information from
      * @param meta Constant reference to the requests meta data
      * @param request Constant reference to the data container of the handled request
      * @param user Constant reference to a user struct to only query for one users jobs
      *
-     * @return handled_request containing the meta data and the response
+     * @return handled_result containing the meta data, the stored response and the job status
      */
-    std::pair<meta_data, binary_data> handle_result(database_wrapper &db,
-                                                    const graphs::MetaData &meta,
-                                                    const graphs::RequestContainer &request,
-                                                    const user &user);
+    handled_result handle_result(database_wrapper &db, const graphs::MetaData &meta,
+                                 const graphs::RequestContainer &request, const user &user);
 
     /**
      * @brief Creates response to requests for job abort
@@ -75,27 +97,72 @@ namespace request_handling {
                                       const user &user);
 
     /**
-     * @brief Creates response for results asking to create a new job
+     * @brief Creates response for results asking to create a new job, after its request data has
+     *  been received
      *
-     * @param db Reference to a database connection to get the status information from
-     * @param meta Constant reference to the requests meta data
-     * @param buffer Constant reference to the buffer containing the compressed data of the job
-     * @param user Constant reference to a user struct to only query for one users jobs
+     * @param upload Reference to the upload containing the request data of the job, committed by
+     *  this function
+     * @param database Connection to commit the upload with
+     * @param yield Context of the calling coroutine, suspended while the upload is committed
+     * @param inserted Called with the ID of the job before it is committed, see
+     *  <job_upload::commit>
      *
      * @return handled_request containing the meta data and the response
      */
-    handled_request handle_new_job(database_wrapper &db, const graphs::MetaData &meta,
-                                   const std::vector<char> &buffer, const user &user);
+    handled_request handle_new_job(job_upload &upload, const database_pool::lease &database,
+                                   boost::asio::yield_context &yield,
+                                   const std::function<void(int)> &inserted = {});
+
+    /**
+     * @brief uploaded_graph The graph of an UPLOAD_GRAPH request, found by read_uploaded_graph()
+     */
+    struct uploaded_graph {
+        /// Serialized graphs::GenericRequest holding the graph and its attributes
+        binary_data_view graph;
+
+        /// Hex encoded SHA-256 hash of graph
+        std::string hash;
+    };
+
+    /**
+     * @brief Finds and hashes the graph in the received container of an UPLOAD_GRAPH request.
+     *  The container is only scanned, neither it nor the graph is parsed or copied.
+     *
+     * @param container View to the decompressed graphs::RequestContainer of the request, which
+     *  the returned graph points into
+     *
+     * @return uploaded_graph The graph as sent by the client and its hash
+     * @throws graphs::ResponseContainer::StatusCode If the container is malformed, holds no
+     *  graphs::GenericRequest or one referencing another stored graph
+     */
+    uploaded_graph read_uploaded_graph(binary_data_view container);
+
+    /**
+     * @brief Stores an uploaded graph in the graph library of the user. Requests of new jobs can
+     *  then reference it by its ID instead of containing it.
+     *
+     * @param db Reference to a database connection to store the graph in
+     * @param graph Constant reference to the graph found by read_uploaded_graph()
+     * @param user Constant reference to the user who uploads the graph
+     *
+     * @return handled_request containing the meta data and the response
+     */
+    handled_request handle_upload_graph(database_wrapper &db, const uploaded_graph &graph,
+                                        const user &user);
 
     /**
      * @brief Creates response for a user creation request
      *
-     * @param db Reference to a database connection to get the status information from
+     * @param database Leased database connection to create the user with
      * @param meta Constant reference to the requests meta data
+     * @param yield Context of the calling coroutine, suspended while the password is hashed and
+     *  the user is created
      *
      * @return handled_request containing the meta data and the response
      */
-    handled_request handle_user_creation(database_wrapper &db, const graphs::MetaData &meta);
+    handled_request handle_user_creation(database_pool::lease &database,
+                                         const graphs::MetaData &meta,
+                                         boost::asio::yield_context &yield);
 
     /**
      * @brief Creates response to requests for fetching job origin graph
@@ -0,0 +1,54 @@
+#ifndef IO_SERVER_RESULT_SLICING_HPP
+#define IO_SERVER_RESULT_SLICING_HPP
+
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace server {
+
+/**
+ * @brief Selection of parts of a stored result, as requested by a <graphs::ResultRequest>
+ */
+struct result_selection {
+    /// Names of the fields of the algorithm response to return, all fields if empty
+    std::vector<std::string> fields;
+
+    /// Index of the first vertex and of the first edge returned
+    uint64_t offset{};
+
+    /// Maximum number of vertices and of edges returned, unlimited if 0
+    uint64_t count{};
+
+    /// True if the whole result is selected, so it does not have to be sliced at all
+    bool selects_all() const;
+};
+
+/**
+ * @brief Slices a serialized <graphs::ResponseContainer> holding an algorithm response.
+ *
+ * The container is processed on the wire format, using the descriptors of the response type
+ *  named in its Any field, without parsing it into messages. Fields of the response not named in
+ *  the selection are skipped.
+ *
+ * The range selects a page of vertices and, independently, a page of edges with the same offset
+ *  and count. Lists with one element per vertex (fields named vertex... or node..., e.g.
+ *  vertexList or vertexCoordinates, and the values of VERTEX attributes) are sliced by the vertex
+ *  page, lists with one element per edge (fields named edge... and the values of EDGE attributes)
+ *  by the edge page, at any nesting depth. The vertex indices of kept edges are rewritten relative
+ *  to the vertex page and set to -1 if the vertex is not part of it. All other repeated fields,
+ *  e.g. paths or the values of GRAPH attributes, are returned whole, and map entries are never
+ *  dropped.
+ *
+ * @param container Stream providing the uncompressed serialization of the container
+ * @param selection Parts of the response to keep
+ * @param out Serialization of the sliced container
+ * @return bool True if the container could be sliced, false if its serialization is broken
+ */
+bool slice_result(google::protobuf::io::ZeroCopyInputStream &container,
+                  const result_selection &selection, std::string &out);
+
+}  // namespace server
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef IO_SERVER_TLS_STREAM_HPP
+#define IO_SERVER_TLS_STREAM_HPP
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <openssl/ssl.h>
+#include <memory>
+
+namespace server {
+
+/**
+ * @brief TLS stream running OpenSSL directly on the socket, so the kernel TLS offload (kTLS) of
+ *  OpenSSL can be used.
+ *
+ * boost::asio::ssl::stream feeds OpenSSL through memory BIOs, which rules out kTLS. This stream
+ *  lets OpenSSL work on the socket itself and waits for readiness of the socket instead. If the
+ *  context enables kTLS (SSL_OP_ENABLE_KTLS) and the kernel supports the negotiated cipher,
+ *  OpenSSL hands the send keys to the kernel after the handshake. Writes then bypass OpenSSL
+ *  completely: they go straight to the socket, including gather writes, and are encrypted by the
+ *  kernel. Otherwise writes go through SSL_write like before.
+ *
+ * Meets the requirements of AsyncReadStream and AsyncWriteStream. Like boost::asio::ssl::stream,
+ *  at most one read and one write may be outstanding at a time.
+ */
+class tls_stream
+{
+public:
+    using executor_type = boost::asio::ip::tcp::socket::executor_type;
+    using next_layer_type = boost::asio::ip::tcp::socket;
+    using lowest_layer_type = boost::asio::ip::tcp::socket::lowest_layer_type;
+
+    /**
+     * @brief Creates a stream with an unconnected socket
+     * @param executor Executor of the socket, should be a strand
+     * @param ctx TLS context to create the connection from
+     */
+    tls_stream(const executor_type &executor, boost::asio::ssl::context &ctx);
+
+    tls_stream(const tls_stream &) = delete;
+    tls_stream &operator=(const tls_stream &) = delete;
+
+    ~tls_stream() = default;
+
+    executor_type get_executor() { return m_socket.get_executor(); }
+    next_layer_type &next_layer() { return m_socket; }
+    lowest_layer_type &lowest_layer() { return m_socket.lowest_layer(); }
+
+    /// True if encryption of written data was offloaded to the kernel
+    bool kernel_tls_send() const { return m_kernel_tls_send; }
+
+    template <typename HandshakeHandler>
+    auto async_handshake(boost::asio::ssl::stream_base::handshake_type type,
+                         HandshakeHandler &&handler)
+    {
+        return boost::asio::async_compose<HandshakeHandler, void(boost::system::error_code)>(
+            handshake_op{*this, type}, handler, m_socket);
+    }
+
+    template <typename MutableBufferSequence, typename ReadHandler>
+    auto async_read_some(const MutableBufferSequence &buffers, ReadHandler &&handler)
+    {
+        return boost::asio::async_compose<ReadHandler, void(boost::system::error_code, size_t)>(
+            io_op<boost::asio::mutable_buffer>{*this, first_buffer<boost::asio::mutable_buffer>(
+                                                          buffers)},
+            handler, m_socket);
+    }
+
+    template <typename ConstBufferSequence, typename WriteHandler>
+    auto async_write_some(const ConstBufferSequence &buffers, WriteHandler &&handler)
+    {
+        if (m_kernel_tls_send)
+        {
+            // The kernel encrypts, the data does not have to pass OpenSSL
+            return m_socket.async_write_some(buffers, std::forward<WriteHandler>(handler));
+        }
+
+        return boost::asio::async_compose<WriteHandler, void(boost::system::error_code, size_t)>(
+            io_op<boost::asio::const_buffer>{*this,
+                                             first_buffer<boost::asio::const_buffer>(buffers)},
+            handler, m_socket);
+    }
+
+private:
+    struct ssl_deleter {
+        void operator()(SSL *ssl) const { SSL_free(ssl); }
+    };
+
+    /// Result of a single attempt of an OpenSSL operation
+    enum class step { done, want_read, want_write, failed };
+
+    step handshake_step(boost::asio::ssl::stream_base::handshake_type type,
+                        boost::system::error_code &error);
+    step read_step(boost::asio::mutable_buffer buffer, size_t &transferred,
+                   boost::system::error_code &error);
+    step write_step(boost::asio::const_buffer buffer, size_t &transferred,
+                    boost::system::error_code &error);
+
+    /// Translates the result of an OpenSSL call
+    step to_step(int result, boost::system::error_code &error);
+
+    /// Continues an operation after the socket is ready, returns false if it is finished
+    template <typename Self>
+    bool wait_for(step s, Self &self)
+    {
+        switch (s)
+        {
+            case step::want_read:
+                m_socket.async_wait(boost::asio::socket_base::wait_read, std::move(self));
+                return true;
+            case step::want_write:
+                m_socket.async_wait(boost::asio::socket_base::wait_write, std::move(self));
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    template <typename Buffer, typename BufferSequence>
+    static Buffer first_buffer(const BufferSequence &buffers)
+    {
+        for (auto it = boost::asio::buffer_sequence_begin(buffers);
+             it != boost::asio::buffer_sequence_end(buffers); ++it)
+        {
+            Buffer buffer(*it);
+            if (buffer.size() > 0)
+            {
+                return buffer;
+            }
+        }
+        return Buffer{};
+    }
+
+    struct handshake_op {
+        tls_stream &stream;
+        boost::asio::ssl::stream_base::handshake_type type;
+        bool started{false};
+
+        template <typename Self>
+        void operator()(Self &self, boost::system::error_code error = {})
+        {
+            if (!started)
+            {
+                // Never complete within the initiating function
+                started = true;
+                boost::asio::post(stream.get_executor(), std::move(self));
+                return;
+            }
+
+            if (!error)
+            {
+                const step s = stream.handshake_step(type, error);
+                if (stream.wait_for(s, self))
+                {
+                    return;
+                }
+            }
+            self.complete(error);
+        }
+    };
+
+    template <typename Buffer>
+    struct io_op {
+        tls_stream &stream;
+        Buffer buffer;
+        bool started{false};
+
+        template <typename Self>
+        void operator()(Self &self, boost::system::error_code error = {})
+        {
+            if (!started)
+            {
+                // Never complete within the initiating function, composed operations like
+                // async_write would recurse otherwise
+                started = true;
+                boost::asio::post(stream.get_executor(), std::move(self));
+                return;
+            }
+
+            size_t transferred = 0;
+            if (!error && buffer.size() > 0)
+            {
+                step s;
+                if constexpr (std::is_same_v<Buffer, boost::asio::mutable_buffer>)
+                {
+                    s = stream.read_step(buffer, transferred, error);
+                }
+                else
+                {
+                    s = stream.write_step(buffer, transferred, error);
+                }
+
+                if (stream.wait_for(s, self))
+                {
+                    return;
+                }
+            }
+            self.complete(error, transferred);
+        }
+    };
+
+    boost::asio::ip::tcp::socket m_socket;
+    std::unique_ptr<SSL, ssl_deleter> m_ssl;
+    bool m_kernel_tls_send{false};
+};
+
+}  // namespace server
+
+#endif
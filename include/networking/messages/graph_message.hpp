@@ -138,9 +138,29 @@ public:
      */
     const ogdf::Array<ogdf::edge> &all_edges() const;
 
+    /**
+     * @brief Checks whether the node at position `i` of `all_nodes()` has the OGDF index `i`. If
+     *        so, an `ogdf::NodeArray` stores its values in the same order as the corresponding
+     *        Protobuf attribute fields, which allows attributes to be copied in bulk.
+     *
+     * @return true if node indices match their positions in `all_nodes()`
+     */
+    bool has_ordered_node_indices() const;
+
+    /**
+     * @brief Checks whether the edge at position `i` of `all_edges()` has the OGDF index `i`. See
+     *        `has_ordered_node_indices()`.
+     *
+     * @return true if edge indices match their positions in `all_edges()`
+     */
+    bool has_ordered_edge_indices() const;
+
 private:
     uid_t make_uid() const;
 
+    /// Updates `m_ordered_node_indices` and `m_ordered_edge_indices` after the graph was (re)built
+    void update_index_order();
+
     std::unique_ptr<ogdf::Graph> m_graph;
 
     // XXX: This is only okay because `graph_message::graph()` returns a const &. Otherwise,
@@ -166,6 +186,9 @@ private:
      * their UIDs.
      */
     std::unique_ptr<std::unordered_map<uid_t, ogdf::edge>> m_uid_to_edge;
+
+    bool m_ordered_node_indices{};
+    bool m_ordered_edge_indices{};
 };
 
 }  // namespace server
@@ -16,6 +16,9 @@ struct meta_data {
     std::string handler_type;
 
     std::string job_name;
+
+    /// Session token issued on a successful authentication, empty if none is sent
+    std::string session_token;
 };
 
 }  // namespace server
@@ -13,6 +13,9 @@ struct node_coordinates {
 
     graphs::VertexCoordinates as_proto() const;
 
+    // Writes the coordinates into an existing message, e.g. one owned by a RepeatedPtrField
+    void to_proto(graphs::VertexCoordinates &proto) const;
+
     double m_x{};
     double m_y{};
     double m_z{};
@@ -164,6 +164,9 @@ public:
     const std::unordered_map<std::string, std::string> &static_attributes() const;
 
 private:
+    /// Throws a request_parse_error if attributes are not given for every node or edge
+    void check_attribute_size(graphs::AttributeType type, int size) const;
+
     template <typename T>
     using AttributeMap = std::unordered_map<std::string, T>;
 
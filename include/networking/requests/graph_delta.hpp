@@ -0,0 +1,38 @@
+#pragma once
+
+#include "generic_container.pb.h"
+
+namespace server {
+
+/**
+ * @brief Applies the changes of a `GraphDelta` to the request it is based on.
+ *
+ * Vertices and edges are identified by their UIDs. Removals are applied first, removing a vertex
+ * also removes its incident edges. Then the added vertices and edges are appended and finally the
+ * changed costs and coordinates are set. All per vertex and per edge values (coordinates, costs
+ * and attributes) are kept in line with the vertex and edge lists.
+ *
+ * Throws a `request_parse_error` if the delta does not fit the base request, e.g. if it references
+ * unknown UIDs or adds elements without values for present per element data.
+ *
+ * @param delta Changes to apply
+ * @param base Request the changes are applied to
+ */
+void apply_graph_delta(const graphs::GraphDelta &delta, graphs::GenericRequest &base);
+
+/**
+ * @brief Merges the fields of a request over the stored graph or delta result it references.
+ *
+ * Lists set by the request (e.g. edgeCosts) replace those of the base instead of being appended,
+ * attribute maps are merged by name and the other fields set by the request take precedence. The
+ * references themselves (graphId and delta) are not merged.
+ *
+ * Throws a `request_parse_error` if the request sets a graph of its own, which would be mixed
+ * with the vertices and edges of the base.
+ *
+ * @param request Request referencing the base
+ * @param base Request the fields are merged into
+ */
+void merge_into_base(graphs::GenericRequest request, graphs::GenericRequest &base);
+
+}  // namespace server
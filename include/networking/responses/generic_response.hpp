@@ -27,8 +27,9 @@ public:
 
     graphs::GenericResponse as_proto();
 
-    friend void copy_static_attributes(const graphs::RequestContainer &request_container,
-                                       generic_response &response);
+    friend void copy_static_attributes(
+        const std::unordered_map<std::string, std::string> &static_attributes,
+        generic_response &response);
 
 private:
     graphs::Graph m_proto_graph;
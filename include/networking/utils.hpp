@@ -1,12 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <regex>
 #include <string>
 #include <type_traits>
 #include <vector>
 
 #include "networking/messages/graph_message.hpp"
+#include "networking/messages/node_coordinates.hpp"
 
 namespace server {
 
@@ -15,10 +17,11 @@ namespace server {
  * Protobuf representation, and vice-versa. Note that all methods return `void`. The desired format
  * is contained in the second-to-last function parameter which functions as an out parameter.
  *
- * The `transformer` function is applied to the elements of the source format before writing to the
+ * The `transformer` functor is applied to the elements of the source format before writing to the
  * target format. Users can make use of this to perform desired transformations "in place", e.g.
- * converting a custom type to the format of a Protobuf class. Per default, the `transformer`
- * function returns the element as a `target_type`.
+ * converting a custom type to the format of a Protobuf class. Per default, `utils::identity` is
+ * used, and conversions between types of identical layout (e.g. `RepeatedField<double>` and
+ * `EdgeArray<double>`) are performed as bulk copies if the graph's indices allow for it.
  */
 namespace utils {
 
@@ -58,152 +61,257 @@ namespace utils {
             std::regex(R"(\d{4}-[01]\d-[0-3]\dT[0-2]\d:[0-5]\d:[0-5]\d\.\d+)"));
     }
 
-    template <typename source_type, typename target_type>
-    void parse_node_attribute(
-        const google::protobuf::RepeatedField<source_type> &rep_field, const graph_message &msg,
-        ogdf::NodeArray<target_type> &node_array,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
-    {
-        for (int idx = 0; idx < rep_field.size(); ++idx)
+    /**
+     * @brief Default transformer that passes elements through unchanged. Conversions using this
+     *        transformer are detected at compile time and lowered to bulk copies whenever source
+     *        and target share the same memory layout.
+     */
+    struct identity {
+        template <typename value_type>
+        constexpr value_type &&operator()(value_type &&value) const noexcept
         {
-            const auto &node = msg.all_nodes()[idx];
-            node_array[node] = transformer(rep_field.at(idx));
+            return std::forward<value_type>(value);
+        }
+    };
+
+    namespace detail {
+
+        /// Whether a `source_type` can be reinterpreted bytewise as a `target_type`
+        template <typename source_type, typename target_type>
+        constexpr bool is_bitwise_convertible_v =
+            std::is_arithmetic_v<source_type> && std::is_arithmetic_v<target_type> &&
+            !std::is_same_v<source_type, bool> && !std::is_same_v<target_type, bool> &&
+            sizeof(source_type) == sizeof(target_type) &&
+            std::is_floating_point_v<source_type> == std::is_floating_point_v<target_type> &&
+            std::is_signed_v<source_type> == std::is_signed_v<target_type>;
+
+        /// Whether an attribute conversion can be performed as a single `memcpy`
+        template <typename source_type, typename target_type, typename transformer_type>
+        constexpr bool is_bulk_copyable_v =
+            std::is_same_v<std::decay_t<transformer_type>, identity> &&
+            is_bitwise_convertible_v<source_type, target_type>;
+
+        template <typename rep_field_type, typename element_type, typename array_type,
+                  typename transformer_type>
+        void parse_elementwise(const rep_field_type &rep_field,
+                               const ogdf::Array<element_type> &all_elements, array_type &array,
+                               transformer_type &transformer)
+        {
+            // Surplus values have no element to belong to, callers reject them beforehand
+            const int nof_values = std::min<int>(rep_field.size(), all_elements.size());
+            for (int idx = 0; idx < nof_values; ++idx)
+            {
+                array[all_elements[idx]] = transformer(rep_field.Get(idx));
+            }
+        }
+
+        template <typename target_type, typename element_type, typename array_type,
+                  typename transformer_type>
+        void serialize_elementwise(const array_type &array,
+                                   const ogdf::Array<element_type> &all_elements,
+                                   google::protobuf::RepeatedField<target_type> &rep_field,
+                                   transformer_type &transformer)
+        {
+            const int nof_elements = all_elements.size();
+
+            rep_field.Clear();
+            rep_field.Reserve(nof_elements);
+            for (int idx = 0; idx < nof_elements; ++idx)
+            {
+                rep_field.AddAlreadyReserved(transformer(array[all_elements[idx]]));
+            }
         }
-    }
 
-    template <typename source_type, typename target_type>
-    void parse_node_attribute(
-        const google::protobuf::RepeatedPtrField<source_type> &rep_field, const graph_message &msg,
-        ogdf::NodeArray<target_type> &node_array,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
+        template <typename target_type, typename element_type, typename array_type,
+                  typename transformer_type>
+        void serialize_elementwise(const array_type &array,
+                                   const ogdf::Array<element_type> &all_elements,
+                                   google::protobuf::RepeatedPtrField<target_type> &rep_field,
+                                   transformer_type &transformer)
+        {
+            const int nof_elements = all_elements.size();
+
+            rep_field.Clear();
+            rep_field.Reserve(nof_elements);
+            for (int idx = 0; idx < nof_elements; ++idx)
+            {
+                *rep_field.Add() = transformer(array[all_elements[idx]]);
+            }
+        }
+
+        /// Copies `rep_field` into `array`. Requires indices to match positions in `rep_field` and
+        /// `rep_field` to hold exactly one value per element.
+        template <typename source_type, typename array_type>
+        void bulk_parse(const google::protobuf::RepeatedField<source_type> &rep_field,
+                        array_type &array)
+        {
+            if (!rep_field.empty())
+            {
+                std::memcpy(&array[0], rep_field.data(), rep_field.size() * sizeof(source_type));
+            }
+        }
+
+        /// Copies the first `nof_elements` entries of `array` into `rep_field`. Requires indices to
+        /// match positions in `rep_field`.
+        template <typename target_type, typename array_type>
+        void bulk_serialize(const array_type &array, int nof_elements,
+                            google::protobuf::RepeatedField<target_type> &rep_field)
+        {
+            rep_field.Clear();
+            if (nof_elements > 0)
+            {
+                rep_field.Reserve(nof_elements);
+                std::memcpy(rep_field.AddNAlreadyReserved(nof_elements), &array[0],
+                            nof_elements * sizeof(target_type));
+            }
+        }
+
+    }  // namespace detail
+
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void parse_node_attribute(const google::protobuf::RepeatedField<source_type> &rep_field,
+                              const graph_message &msg, ogdf::NodeArray<target_type> &node_array,
+                              transformer_type transformer = {})
     {
-        for (int idx = 0; idx < rep_field.size(); ++idx)
+        if constexpr (detail::is_bulk_copyable_v<source_type, target_type, transformer_type>)
         {
-            const auto &edge = msg.all_nodes()[idx];
-            node_array[edge] = transformer(rep_field.at(idx));
+            // Arrays are sized for the graph, anything else is copied element by element
+            if (msg.has_ordered_node_indices() && rep_field.size() == msg.all_nodes().size())
+            {
+                detail::bulk_parse(rep_field, node_array);
+                return;
+            }
         }
+
+        detail::parse_elementwise(rep_field, msg.all_nodes(), node_array, transformer);
+    }
+
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void parse_node_attribute(const google::protobuf::RepeatedPtrField<source_type> &rep_field,
+                              const graph_message &msg, ogdf::NodeArray<target_type> &node_array,
+                              transformer_type transformer = {})
+    {
+        detail::parse_elementwise(rep_field, msg.all_nodes(), node_array, transformer);
     }
 
-    template <typename source_type, typename target_type>
-    void parse_edge_attribute(
-        const google::protobuf::RepeatedField<source_type> &rep_field, const graph_message &msg,
-        ogdf::EdgeArray<target_type> &edge_array,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
+    /**
+     * @brief Fast path for node coordinates. Reads the coordinates straight from the Protobuf
+     *        messages without constructing temporaries.
+     */
+    inline void parse_node_attribute(
+        const google::protobuf::RepeatedPtrField<graphs::VertexCoordinates> &rep_field,
+        const graph_message &msg, ogdf::NodeArray<node_coordinates> &node_array)
     {
-        for (int idx = 0; idx < rep_field.size(); ++idx)
+        const auto &all_nodes = msg.all_nodes();
+        const int nof_values = std::min<int>(rep_field.size(), all_nodes.size());
+        for (int idx = 0; idx < nof_values; ++idx)
         {
-            const auto &edge = msg.all_edges()[idx];
-            edge_array[edge] = transformer(rep_field.at(idx));
+            const graphs::VertexCoordinates &proto_coords = rep_field.Get(idx);
+            node_coordinates &coords = node_array[all_nodes[idx]];
+
+            coords.m_x = proto_coords.x();
+            coords.m_y = proto_coords.y();
+            coords.m_z = proto_coords.z();
         }
     }
 
-    template <typename source_type, typename target_type>
-    void parse_edge_attribute(
-        const google::protobuf::RepeatedPtrField<source_type> &rep_field, const graph_message &msg,
-        ogdf::EdgeArray<target_type> &edge_array,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void parse_edge_attribute(const google::protobuf::RepeatedField<source_type> &rep_field,
+                              const graph_message &msg, ogdf::EdgeArray<target_type> &edge_array,
+                              transformer_type transformer = {})
     {
-        for (int idx = 0; idx < rep_field.size(); ++idx)
+        if constexpr (detail::is_bulk_copyable_v<source_type, target_type, transformer_type>)
         {
-            const auto &edge = msg.all_edges()[idx];
-            edge_array[edge] = transformer(rep_field.at(idx));
+            // Arrays are sized for the graph, anything else is copied element by element
+            if (msg.has_ordered_edge_indices() && rep_field.size() == msg.all_edges().size())
+            {
+                detail::bulk_parse(rep_field, edge_array);
+                return;
+            }
         }
+
+        detail::parse_elementwise(rep_field, msg.all_edges(), edge_array, transformer);
     }
 
-    template <typename source_type, typename target_type>
-    void serialize_node_attribute(
-        const ogdf::NodeArray<source_type> &node_array, const graph_message &msg,
-        google::protobuf::RepeatedField<target_type> &rep_field,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void parse_edge_attribute(const google::protobuf::RepeatedPtrField<source_type> &rep_field,
+                              const graph_message &msg, ogdf::EdgeArray<target_type> &edge_array,
+                              transformer_type transformer = {})
     {
-        const auto nof_nodes = msg.graph().numberOfNodes();
-        const auto &all_nodes = msg.all_nodes();
+        detail::parse_elementwise(rep_field, msg.all_edges(), edge_array, transformer);
+    }
 
-        rep_field.Reserve(nof_nodes);
-        rep_field.Clear();
-        for (size_t idx = 0; idx < nof_nodes; ++idx)
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void serialize_node_attribute(const ogdf::NodeArray<source_type> &node_array,
+                                  const graph_message &msg,
+                                  google::protobuf::RepeatedField<target_type> &rep_field,
+                                  transformer_type transformer = {})
+    {
+        if constexpr (detail::is_bulk_copyable_v<source_type, target_type, transformer_type>)
         {
-            const auto &value = node_array[all_nodes[idx]];
-            rep_field.AddAlreadyReserved(transformer(value));
+            if (msg.has_ordered_node_indices())
+            {
+                detail::bulk_serialize(node_array, msg.graph().numberOfNodes(), rep_field);
+                return;
+            }
         }
+
+        detail::serialize_elementwise(node_array, msg.all_nodes(), rep_field, transformer);
     }
 
-    template <typename source_type, typename target_type>
-    void serialize_node_attribute(
-        const ogdf::NodeArray<source_type> &node_array, const graph_message &msg,
-        google::protobuf::RepeatedPtrField<target_type> &rep_field,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void serialize_node_attribute(const ogdf::NodeArray<source_type> &node_array,
+                                  const graph_message &msg,
+                                  google::protobuf::RepeatedPtrField<target_type> &rep_field,
+                                  transformer_type transformer = {})
+    {
+        detail::serialize_elementwise(node_array, msg.all_nodes(), rep_field, transformer);
+    }
+
+    /**
+     * @brief Fast path for node coordinates. Writes the coordinates into messages allocated by
+     *        `rep_field` itself instead of copying temporaries.
+     */
+    inline void serialize_node_attribute(
+        const ogdf::NodeArray<node_coordinates> &node_array, const graph_message &msg,
+        google::protobuf::RepeatedPtrField<graphs::VertexCoordinates> &rep_field)
     {
-        const auto nof_nodes = msg.graph().numberOfNodes();
         const auto &all_nodes = msg.all_nodes();
+        const int nof_nodes = all_nodes.size();
 
-        rep_field.Reserve(nof_nodes);
         rep_field.Clear();
-        for (size_t idx = 0; idx < nof_nodes; ++idx)
+        rep_field.Reserve(nof_nodes);
+        for (int idx = 0; idx < nof_nodes; ++idx)
         {
-            const auto &value = node_array[all_nodes[idx]];
-            rep_field.Add(transformer(value));
+            node_array[all_nodes[idx]].to_proto(*rep_field.Add());
         }
     }
 
-    template <typename source_type, typename target_type>
-    void serialize_edge_attribute(
-        const ogdf::EdgeArray<source_type> &edge_array, const graph_message &msg,
-        google::protobuf::RepeatedField<target_type> &rep_field,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void serialize_edge_attribute(const ogdf::EdgeArray<source_type> &edge_array,
+                                  const graph_message &msg,
+                                  google::protobuf::RepeatedField<target_type> &rep_field,
+                                  transformer_type transformer = {})
     {
-        const auto nof_edges = msg.graph().numberOfEdges();
-        const auto &all_edges = msg.all_edges();
-
-        rep_field.Reserve(nof_edges);
-        rep_field.Clear();
-        for (size_t idx = 0; idx < nof_edges; ++idx)
+        if constexpr (detail::is_bulk_copyable_v<source_type, target_type, transformer_type>)
         {
-            const auto &value = edge_array[all_edges[idx]];
-            rep_field.AddAlreadyReserved(transformer(value));
+            if (msg.has_ordered_edge_indices())
+            {
+                detail::bulk_serialize(edge_array, msg.graph().numberOfEdges(), rep_field);
+                return;
+            }
         }
+
+        detail::serialize_elementwise(edge_array, msg.all_edges(), rep_field, transformer);
     }
 
-    template <typename source_type, typename target_type>
-    void serialize_edge_attribute(
-        const ogdf::EdgeArray<source_type> &edge_array, const graph_message &msg,
-        google::protobuf::RepeatedPtrField<target_type> &rep_field,
-        std::function<target_type(const source_type &)> transformer =
-            [](const source_type &source) -> target_type {
-            return source;
-        })
+    template <typename source_type, typename target_type, typename transformer_type = identity>
+    void serialize_edge_attribute(const ogdf::EdgeArray<source_type> &edge_array,
+                                  const graph_message &msg,
+                                  google::protobuf::RepeatedPtrField<target_type> &rep_field,
+                                  transformer_type transformer = {})
     {
-        const auto nof_edges = msg.graph().numberOfEdges();
-        const auto &all_edges = msg.all_edges();
-
-        rep_field.Reserve(nof_edges);
-        rep_field.Clear();
-        for (size_t idx = 0; idx < nof_edges; ++idx)
-        {
-            const auto &value = edge_array[all_edges[idx]];
-            rep_field.Add(transformer(value));
-        }
+        detail::serialize_elementwise(edge_array, msg.all_edges(), rep_field, transformer);
     }
 }  // namespace utils
 }  // namespace server
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <openssl/evp.h>
+
+namespace server {
+
+/**
+ * @brief Read-only memory mapping of a file in the <blob_store>, unmapped on destruction
+ *
+ * The file stays open as long as the mapping exists, so it can also be sent with sendfile().
+ */
+class mapped_blob
+{
+public:
+    mapped_blob() = default;
+
+    /**
+     * @brief Opens and maps a file
+     * @throws std::system_error If the file can not be opened or mapped
+     */
+    explicit mapped_blob(const std::filesystem::path &path);
+
+    /**
+     * @brief Maps an open file, taking ownership of the descriptor
+     * @throws std::system_error If the file can not be mapped
+     */
+    explicit mapped_blob(int fd);
+
+    mapped_blob(mapped_blob &&rhs) noexcept;
+    mapped_blob &operator=(mapped_blob &&rhs) noexcept;
+    ~mapped_blob();
+
+    mapped_blob(const mapped_blob &) = delete;
+    mapped_blob &operator=(const mapped_blob &) = delete;
+
+    const std::byte *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    std::basic_string_view<std::byte> view() const { return {m_data, m_size}; }
+
+    /// Descriptor of the open file
+    int fd() const { return m_fd; }
+
+private:
+    int m_fd{-1};
+    std::byte *m_data{};
+    size_t m_size{};
+};
+
+/**
+ * @brief Content-addressed store for request and response payloads on local disk.
+ *
+ * Payloads of at least blob-store-threshold bytes are kept as files named by the SHA-256 hash of
+ * their content below blob-store-path, instead of in the data table. Identical payloads share a
+ * file. The data table references blobs by their hash, the references are counted by the table
+ * blobs and unreferenced files are removed by <database_wrapper> when jobs are deleted.
+ *
+ * Files are written to a temporary file first and renamed once complete, so a blob is either
+ * missing or complete. The store has no state besides its directory, all methods are thread-safe.
+ */
+class blob_store
+{
+public:
+    /**
+     * @brief A blob being written, which becomes visible under its hash once published. The
+     *  temporary file is removed if the blob is destroyed without being published.
+     */
+    class pending_blob
+    {
+    public:
+        pending_blob(pending_blob &&rhs) noexcept;
+        pending_blob &operator=(pending_blob &&rhs) = delete;
+        ~pending_blob();
+
+        pending_blob(const pending_blob &) = delete;
+        pending_blob &operator=(const pending_blob &) = delete;
+
+        /// Appends data to the blob
+        void append(const std::byte *data, size_t size);
+
+        /// Flushes the blob to disk and computes its hash, no more data can be appended
+        void finish();
+
+        /// Hex encoded SHA-256 hash of the content, available after finish()
+        const std::string &hash() const { return m_hash; }
+
+        /// Number of bytes appended
+        size_t size() const { return m_size; }
+
+        /**
+         * @brief Moves the finished blob to its final location, replacing an existing file with
+         *  the same content. Must be called after the reference to the blob was written to the
+         *  database, see <database_wrapper::remove_blobs>.
+         */
+        void publish();
+
+    private:
+        friend class blob_store;
+        pending_blob(const blob_store &store, std::filesystem::path temporary, int fd);
+
+        struct digest_deleter {
+            void operator()(EVP_MD_CTX *ctx) const { EVP_MD_CTX_free(ctx); }
+        };
+
+        const blob_store &m_store;
+        std::filesystem::path m_temporary;
+        int m_fd;
+        std::unique_ptr<EVP_MD_CTX, digest_deleter> m_digest;
+        std::string m_hash;
+        size_t m_size{};
+        bool m_published{false};
+    };
+
+    /**
+     * @param root Directory of the store, created if it does not exist
+     * @param threshold Minimum size of payloads kept in the store
+     */
+    blob_store(std::filesystem::path root, size_t threshold);
+
+    /**
+     * @brief The store configured by blob-store-path and blob-store-threshold
+     * @return std::shared_ptr<const blob_store> nullptr if no path is configured
+     */
+    static std::shared_ptr<const blob_store> configured();
+
+    const std::filesystem::path &root() const { return m_root; }
+    size_t threshold() const { return m_threshold; }
+
+    /// True if a payload of the given size is kept in the store
+    bool stores(size_t size) const { return size >= m_threshold; }
+
+    /// Starts writing a new blob
+    pending_blob create() const;
+
+    /// Writes a blob at once, it still has to be published
+    pending_blob write(std::basic_string_view<std::byte> data) const;
+
+    /// Maps a published blob
+    mapped_blob map(const std::string &hash) const;
+
+    /// Removes a blob, nothing happens if it does not exist
+    void remove(const std::string &hash) const;
+
+private:
+    std::filesystem::path path(const std::string &hash) const;
+
+    const std::filesystem::path m_root;
+    const size_t m_threshold;
+};
+
+}  // namespace server
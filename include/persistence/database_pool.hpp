@@ -0,0 +1,158 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <persistence/database_wrapper.hpp>
+#include <util/worker_pool.hpp>
+
+namespace server {
+
+/**
+ * @brief Pool of database connections shared by all client and management connections.
+ *
+ * At most db-pool-max-size connections are open at once, further requests wait until a
+ * connection is returned to the pool. Idle connections beyond db-pool-min-size are closed after
+ * db-pool-idle-timeout seconds. Connections idle for longer than db-pool-check-interval seconds
+ * are checked before being handed out and replaced if they are broken.
+ *
+ * Connections are opened and checked outside of the pool lock, by the acquiring thread or, for
+ * coroutines, on the database threads. All methods are thread-safe.
+ *
+ * The queries of coroutines are run on a database thread per connection by
+ * <lease::async_run>, so a slow query never blocks the io threads.
+ */
+class database_pool
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Exclusive use of a pooled connection, which is returned to the pool on destruction
+     */
+    class lease
+    {
+    public:
+        lease() = default;
+        lease(lease &&rhs) noexcept = default;
+        lease &operator=(lease &&rhs) noexcept;
+        ~lease();
+
+        lease(const lease &) = delete;
+        lease &operator=(const lease &) = delete;
+
+        database_wrapper &operator*() const { return *m_database; }
+        database_wrapper *operator->() const { return m_database.get(); }
+
+        /**
+         * @brief Runs a function with the leased connection on a database thread and suspends
+         *  the calling coroutine until it finished. The coroutine is resumed on its own
+         *  executor.
+         *
+         * @param yield Context of the calling coroutine
+         * @param function Function called with the database_wrapper. Exceptions thrown by it are
+         *  rethrown to the caller.
+         * @return The result of function
+         */
+        template <typename Function>
+        std::invoke_result_t<Function, database_wrapper &> async_run(
+            boost::asio::yield_context &yield, Function &&function) const;
+
+    private:
+        friend class database_pool;
+        explicit lease(std::unique_ptr<database_wrapper> database);
+
+        std::unique_ptr<database_wrapper> m_database;
+    };
+
+    static database_pool &instance();
+
+    /**
+     * @brief Acquires a connection, suspending the coroutine while none is available
+     *
+     * @param yield Coroutine to suspend
+     * @param executor Executor of the coroutine (the strand it was spawned on), used to wake it up
+     */
+    lease acquire(boost::asio::yield_context &yield, const boost::asio::any_io_executor &executor);
+
+    /**
+     * @brief Acquires a connection, blocking the calling thread while none is available
+     */
+    lease acquire();
+
+private:
+    database_pool(std::string connection_string, size_t min_size, size_t max_size,
+                  std::chrono::seconds check_interval, std::chrono::seconds idle_timeout);
+
+    struct idle_connection {
+        std::unique_ptr<database_wrapper> database;
+        clock::time_point since;
+    };
+
+    /**
+     * @brief Takes the most recently used idle connection or reserves a slot for a new one, if
+     *  the pool is not exhausted. Requires m_mutex to be locked.
+     *
+     * @return bool False if the pool is exhausted
+     */
+    bool take(idle_connection &taken);
+
+    /// Opens the connection of a reserved slot or checks a taken idle connection
+    lease prepare(idle_connection taken);
+
+    /// Returns a connection to the pool
+    void release(std::unique_ptr<database_wrapper> database);
+
+    /// Frees the slot of a connection that could not be opened
+    void discard();
+
+    /// Wakes up waiting threads and coroutines, must be called without holding m_mutex
+    void notify_waiters();
+
+    const std::string m_connection_string;
+    const size_t m_min_size;
+    const size_t m_max_size;
+    const std::chrono::seconds m_check_interval;
+    const std::chrono::seconds m_idle_timeout;
+
+    /// Guards all members below
+    std::mutex m_mutex;
+
+    /// Signals blocked threads that a connection was returned
+    std::condition_variable m_available;
+
+    /// Idle connections, the most recently used at the back
+    std::deque<idle_connection> m_idle;
+
+    /// Number of open connections, including those being opened and those in use
+    size_t m_size{};
+
+    /// Signals of coroutines waiting for a connection, cancelled to wake them up
+    std::vector<std::weak_ptr<boost::asio::steady_timer>> m_waiters;
+
+    /// Runs the queries of coroutines and opens and checks their connections, one thread per
+    /// connection. Only leased or reserved connections are used on it, so the queue never
+    /// exceeds the pool size.
+    worker_pool m_workers;
+};
+
+template <typename Function>
+std::invoke_result_t<Function, database_wrapper &> database_pool::lease::async_run(
+    boost::asio::yield_context &yield, Function &&function) const
+{
+    database_wrapper &database = *m_database;
+    return database_pool::instance().m_workers.async_run(yield, [&function, &database]() {
+        return function(database);
+    });
+}
+
+}  // namespace server
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <pqxx/pqxx>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <networking/messages/meta_data.hpp>
 #include <networking/responses/response_factory.hpp>
+#include <persistence/blob_store.hpp>
 
 #include "meta.pb.h"
 #include "status.pb.h"
@@ -44,22 +50,129 @@ struct job_entry {
     int response_id;
 };
 
+/**
+ * @brief Struct representing binary data of a request or response as stored in the database table
+ * <data>
+ */
+struct compressed_data {
+    graphs::RequestType type;
+
+    /// Codec the binary data is compressed with
+    graphs::CompressionType compression;
+
+    binary_data binary;
+
+    /// The data if it is kept in the <blob_store>, binary is empty then
+    std::optional<mapped_blob> blob;
+
+    /// Dictionary the binary data is compressed with, see <payload_compression>
+    std::optional<int> dict_id;
+
+    binary_data_view view() const { return blob ? blob->view() : binary_data_view{binary}; }
+};
+
+/**
+ * @brief Position within the jobs of a user, ordered by their last change. Jobs changed after the
+ * position are found by <database_wrapper::get_status_changes>.
+ */
+struct status_cursor {
+    /// ID of the transaction of the last change, see txid_current()
+    int64_t change_xid{};
+    int job_id{};
+};
+
+/**
+ * @brief A page of status information, ordered by the transaction of the last change
+ */
+struct status_page {
+    std::vector<graphs::StatusSingle> states;
+
+    /// Position of the last job in the page, to continue from
+    status_cursor cursor;
+
+    /// True if more changed jobs than the requested number exist
+    bool more{false};
+};
+
 class database_wrapper
 {
 private:
     const std::string m_connection_string;
     pqxx::connection m_database_connection;
+    std::shared_ptr<const blob_store> m_blobs;
     void check_connection();
 
+    /// Maps a payload kept in the blob store
+    mapped_blob map_blob(const std::string &hash) const;
+
+    /**
+     * Deletes the rows of the blobs no longer referenced by the data table after data was
+     * deleted in txn. Their files are kept until txn committed, see remove_blobs().
+     *
+     * @return Hashes of the released blobs
+     */
+    std::vector<std::string> collect_blobs(pqxx::transaction_base &txn);
+
+    /**
+     * Removes the files of blobs released by a committed transaction. Each hash is claimed by
+     * inserting a row without references while its file is removed, so an upload of the same
+     * blob waits and publishes its file afterwards, see <blob_store::pending_blob::publish>.
+     * Blobs referenced again in the meantime are kept. Errors are only logged, the files are
+     * left behind then.
+     */
+    void remove_blobs(const std::vector<std::string> &hashes);
+
+    /// Prepares the statements used for every job or request, needed again after reconnecting
+    void prepare_statements();
+
+    /// Reads a serialized graph of the graph library of a user
+    binary_data get_graph_data(int graph_id, int user_id);
+
+    /// Reads a request of a job which is the base of delta_depth deltas, see get_request_data()
+    std::pair<graphs::RequestType, graphs::RequestContainer> get_request_data(int job_id,
+                                                                              int user_id,
+                                                                              int delta_depth);
+
+    /// Replaces a request referencing a graph of the users graph library with the merged request
+    void resolve_graph(int graph_id, int user_id, graphs::RequestContainer &request_container);
+
+    /**
+     * Replaces a request holding a graphs::GraphDelta with the request it results in. Lists set
+     * by the request replace those of the base, e.g. edgeCosts.
+     *
+     * @param delta_depth Number of deltas based on this request, chains are limited in length
+     */
+    void resolve_delta(int job_id, int user_id, graphs::RequestContainer &request_container,
+                       int delta_depth);
+
 public:
     /**
      * @brief Construct a new database wrapper object
      * 
      * @param connection_string  String with database address and credentials.
      * See pqxx::connection for more information
+     * @param blobs Store for large payloads, all payloads are kept in the database if nullptr
      * 
      */
-    database_wrapper(const std::string &connection_string);
+    database_wrapper(const std::string &connection_string,
+                     std::shared_ptr<const blob_store> blobs = nullptr);
+
+    /**
+     * @brief The store for large payloads, nullptr if all payloads are kept in the database
+     */
+    const std::shared_ptr<const blob_store> &blobs() const;
+
+    /**
+     * @brief Checks if the database can be reached by running a trivial query
+     *
+     * @return bool False if the connection is broken and could not be reestablished
+     */
+    bool check_health();
+
+    /**
+     * @brief The open connection, for callers running their own transactions like <job_upload>
+     */
+    pqxx::connection &connection();
 
     /**
      * Adds the parsed binary data of a request to the database.
@@ -73,6 +186,61 @@ public:
      */
     int add_job(int user_id, const meta_data &meta, binary_data_view binary);
 
+    /**
+     * Inserts a job and the data entry of its request with a single statement, within a
+     * transaction on connection().
+     *
+     * @param txn     Transaction to insert the job in, committed by the caller
+     * @param user_id The ID of the user who scheduled the job
+     * @param meta    Meta data of the job
+     * @param binary  View to binary data that contains the parsed request, empty if it is
+     *                written in chunks by insert_chunk()
+     * @param compression Codec the request and its chunks are compressed with
+     * @param dict_id Dictionary the request and its chunks are compressed with, if any
+     *
+     * @return IDs of the inserted job and of the data entry of its request
+     */
+    std::pair<int, int> insert_job(pqxx::transaction_base &txn, int user_id, const meta_data &meta,
+                                   binary_data_view binary,
+                                   graphs::CompressionType compression =
+                                       graphs::CompressionType::NONE,
+                                   std::optional<int> dict_id = std::nullopt);
+
+    /**
+     * Appends a chunk to the data of a request inserted by insert_job(), within a transaction on
+     * connection().
+     *
+     * @param txn     Transaction to insert the chunk in, committed by the caller
+     * @param data_id The ID of the data entry of the request
+     * @param seq     Position of the chunk within the request
+     * @param chunk   View to the binary data of the chunk, compressed like the request
+     */
+    void insert_chunk(pqxx::transaction_base &txn, int data_id, int seq, binary_data_view chunk);
+
+    /**
+     * Replaces the data of a request inserted by insert_job() by a reference to a finished blob,
+     * within a transaction on connection(). The blob has to be published before committing.
+     * Blobs are not compressed.
+     *
+     * @param txn     Transaction to update the data in, committed by the caller
+     * @param data_id The ID of the data entry of the request
+     * @param blob    The blob holding the request
+     */
+    void set_data_blob(pqxx::transaction_base &txn, int data_id,
+                       const blob_store::pending_blob &blob);
+
+    /**
+     * Adds a graph to the graph library of a user. Graphs are identified by the SHA-256 hash of
+     * their serialization, adding the same graph again returns the existing entry.
+     *
+     * @param user_id The ID of the user who uploaded the graph
+     * @param graph   View to the serialized graphs::GenericRequest holding the graph
+     * @param hash    Hex encoded SHA-256 hash of graph, computed while it was received
+     *
+     * @return ID of the stored graph
+     */
+    int add_graph(int user_id, binary_data_view graph, const std::string &hash);
+
     /**
      * Sets the status of a job to 'waiting', 'in progress', 'finished' or 'aborted'.
      * @param job_id The ID of the job where the status should be changed.
@@ -81,18 +249,28 @@ public:
     void set_status(int job_id, graphs::StatusType status);
 
     /**
-     * Adds the result of a request parsed as binary data to the database.
-     *
-     * @param job_id    The ID of the job where the result should be changed
-     * @param type      The type of the response (will be included in the accompanying meta message)
-     * @param response  A container that contains the parsed response message
-     * @param ogdf_time Runtime of the ogdf call in microseconds
+     * Adds the result of a request parsed as binary data to the database. The response is
+     * compressed once here, so it can be sent to clients without being compressed again.
+     *
+     * @param job_id      The ID of the job where the result should be changed
+     * @param type        The type of the response (will be included in the accompanying meta
+     *                    message)
+     * @param response    A container that contains the parsed response message
+     * @param ogdf_time   Runtime of the ogdf call in microseconds
+     * @param phase_times Returns how long the handler process spent in each phase of the job
+     *                    as microseconds by phase name (see <job_phases>). It is called right
+     *                    before the statement writing the response, so the breakdown includes
+     *                    storing it up to there, and stored with the response in one update.
      */
     void add_response(int job_id, graphs::RequestType type,
-                      const graphs::ResponseContainer &response, long ogdf_time);
+                      const graphs::ResponseContainer &response, long ogdf_time,
+                      const std::function<nlohmann::json()> &phase_times = {});
 
     /**
-     * Reads the parsed data of a request from the database.
+     * Reads the parsed data of a request from the database. If the request references a graph
+     * of the users graph library, the request is merged into the stored graph (see
+     * <server::merge_into_base>). If it is a delta, the delta is applied to its base job or
+     * graph (see <server::apply_graph_delta>) and the request is merged into the result.
      *
      * @param job_id  The ID of the job the request belongs to
      * @param user_id The ID of the user the job belongs to
@@ -114,17 +292,20 @@ public:
                                                                                 int user_id);
 
     /**
-     * @brief Returns the unparsed data of a finished job's response from the database
+     * @brief Returns the unparsed and still compressed data of a finished job's response from the
+     *  database
      *
      * @param job_id  The ID of the job the request belongs to
      * @param user_id The ID of the user the job belongs to
      *
-     * @return A pair of the original RequestType and the binary_data.
+     * @return compressed_data containing the original RequestType, the used compression codec and
+     *  the binary_data, or the mapped blob if the response is kept in the blob store.
      */
-    std::pair<graphs::RequestType, binary_data> get_response_data_raw(int job_id, int user_id);
+    compressed_data get_response_data_raw(int job_id, int user_id);
 
     /**
-     * @brief Get the size of the binary_data stored in the data table associated with the job
+     * @brief Get the size of the data associated with the job, including data kept in the blob
+     *  store
      *
      * @param job_id  The ID of the job the request belongs to
      * @param user_id The ID of the user the job belongs to
@@ -205,11 +386,17 @@ public:
      */
     std::vector<std::pair<int, int>> get_next_jobs(int n);
 
+    /**
+     * @brief Counts the jobs waiting to be scheduled
+     */
+    int64_t count_waiting_jobs();
+
     /**
      * Updates the starting date of a job to the current date.
      * @param job_id The ID of the job entry that should be changed.
+     * @return The handler type of the job and the time it waited since it was received
      */
-    void set_started(int job_id);
+    std::pair<std::string, std::chrono::microseconds> set_started(int job_id);
 
     /**
      * @brief Notifies databse that a job is finished (regardless if successfull or not.).
@@ -219,9 +406,10 @@ public:
      * @param status The new status
      * @param out New entry of field stdout_msg
      * @param err New entry of field error_message
+     * @return The runtime of the algorithm stored by the handler process, zero if it stored none
      */
-    void set_finished(int job_id, graphs::StatusType status, const std::string &out,
-                      const std::string &err);
+    std::chrono::microseconds set_finished(int job_id, graphs::StatusType status,
+                                           const std::string &out, const std::string &err);
 
     /**
      * @brief Gets all status information of a job
@@ -232,6 +420,19 @@ public:
      */
     graphs::StatusSingle get_status_data(int job_id, int user_id);
 
+    /**
+     * @brief Gets the status information of all jobs of a user changed after the cursor with a
+     * single query. Changes of transactions still running, and of those started after any
+     * transaction still running, are left for a later call.
+     *
+     * @param user_id The ID of the user the jobs belong to
+     * @param after Only jobs changed after this position are returned, a default constructed
+     * cursor returns all jobs
+     * @param limit Maximum number of jobs to return, 0 for no limit
+     * @return status_page
+     */
+    status_page get_status_changes(int user_id, const status_cursor &after, size_t limit);
+
     /**
      * @brief Tries to create the user u in the database and writes its database-id into
      * the field user_id.
@@ -311,6 +512,15 @@ public:
      */
     bool set_user_blocked(int user_id, bool blocked);
 
+    /**
+     * @brief Sets the maximum size of a single request a user may upload
+     *
+     * @param user_id Id of the user in the database
+     * @param upload_limit New limit in bytes, or std::nullopt to use the global default
+     * @return true if a user with user_id was found, else if not.
+     */
+    bool set_user_upload_limit(int user_id, std::optional<int64_t> upload_limit);
+
     /**
      * @brief Deletes a user and all of its associated jobs and request/response data
      *
@@ -320,12 +530,64 @@ public:
     bool delete_user(int user_id);
 
     /**
-     * @brief Deletes the jobs that belong to a user including their job data
+     * @brief Deletes a batch of jobs that belong to a user including their job data in one
+     * transaction. Waiting and running jobs of the user are aborted first. All jobs are deleted by
+     * calling this until less than limit jobs are deleted, see <job_maintenance>.
      *
      * @param user_id int representing the ID of the user
-     * @return true if a user with the user_id was found, false if not
+     * @param limit Maximum number of jobs deleted
+     * @return Number of deleted jobs
+     */
+    size_t delete_user_jobs(int user_id, size_t limit);
+
+    /**
+     * @brief Creates the partitions of jobs, data and data_chunks up to the given number of months
+     * ahead, if they do not exist yet
+     */
+    void create_job_partitions(int months_ahead);
+
+    /**
+     * @brief Removes the partitions of jobs, data and data_chunks older than the given number of
+     * months before the current month, see expire_job_partitions() in spanners_tables.pgsql
+     *
+     * @param months Number of full months kept besides the current one
+     * @param detach true to keep removed partitions as plain tables for archiving, false to drop
+     * them including their data
+     * @return Names of the removed partitions of jobs
+     */
+    std::vector<std::string> expire_job_partitions(int months, bool detach);
+
+    /**
+     * @brief Gets the partitions of jobs with an estimate of the number of jobs in each
+     */
+    std::vector<std::pair<std::string, int64_t>> get_job_partitions();
+
+    /**
+     * @brief Gets a dictionary of <payload_compression> from the table payload_dicts
+     */
+    binary_data get_payload_dictionary(int dict_id);
+
+    /**
+     * @brief Gets the ID and the age of the newest dictionary of <payload_compression>, if any
+     */
+    std::optional<std::pair<int, std::chrono::seconds>> get_latest_payload_dictionary();
+
+    /**
+     * @brief Stores a new dictionary of <payload_compression>
+     *
+     * @return ID of the dictionary
+     */
+    int add_payload_dictionary(binary_data_view dictionary);
+
+    /**
+     * @brief Gets the stored requests of the most recent jobs, to train dictionaries of
+     * <payload_compression> on. Requests kept in the blob store or uploaded in more than one
+     * chunk are skipped.
+     *
+     * @param count Maximum number of jobs whose requests are returned
+     * @return The requests, still compressed
      */
-    bool delete_user_jobs(int user_id);
+    std::vector<compressed_data> get_recent_request_payloads(size_t count);
 };
 
 }  // end namespace server
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace server {
+
+class database_wrapper;
+
+/**
+ * @brief Background maintenance of the tables jobs, data and data_chunks, which are partitioned by
+ * the month a job was received in.
+ *
+ * Every job-maintenance-interval seconds a thread creates the partitions of the upcoming months and
+ * removes the partitions of months older than the retention period (job-retention-months). Removed
+ * partitions are either detached and kept as plain tables for archiving, or dropped
+ * (job-retention-mode). The same thread loads and trains the dictionaries of
+ * <payload_compression>.
+ *
+ * Deleting all jobs of a user is queued to the same thread, which deletes them in batches of
+ * job-delete-batch-size jobs in one transaction each. No lock is held for long, so clients and the
+ * scheduler can keep working on the same partitions meanwhile.
+ */
+class job_maintenance
+{
+public:
+    /// What happens to partitions older than the retention period
+    enum class retention_mode { detach, drop };
+
+    static job_maintenance &instance();
+
+    /**
+     * @brief Destroy the job_maintenance object. Stops the thread, queued deletes which are not
+     * done yet are dropped.
+     */
+    ~job_maintenance();
+
+    /**
+     * @brief Starts the maintenance thread, which runs the maintenance right away
+     */
+    void start();
+
+    /**
+     * @brief Set the number of full months whose jobs are kept besides the current month.
+     *
+     * @param months If > 0, older partitions are removed on the next run. Otherwise, jobs are kept
+     * forever.
+     */
+    void set_retention_months(int64_t months);
+    int64_t get_retention_months() const;
+
+    void set_retention_mode(retention_mode mode);
+    retention_mode get_retention_mode() const;
+
+    /**
+     * @brief Creates the partitions of the upcoming months and applies the retention period now,
+     * instead of waiting for the next run of the thread
+     *
+     * @param db Connection to run the maintenance with
+     * @return Names of the removed partitions of jobs
+     */
+    std::vector<std::string> run(database_wrapper &db);
+
+    /**
+     * @brief Queues deleting all jobs of a user in batches
+     *
+     * @param user_id Id of the user in the database
+     * @param delete_user true to delete the user as well once its jobs are deleted
+     */
+    void delete_user_jobs(int user_id, bool delete_user);
+
+    /**
+     * @brief Get the number of users whose jobs are queued for deletion or being deleted
+     */
+    size_t pending_deletes() const;
+
+    static std::string_view to_string(retention_mode mode);
+
+    /**
+     * @throws std::invalid_argument If the name is neither "detach" nor "drop"
+     */
+    static retention_mode parse_retention_mode(std::string_view name);
+
+private:
+    job_maintenance(int64_t retention_months, retention_mode mode, size_t batch_size,
+                    std::chrono::seconds interval);
+
+    struct queued_delete {
+        int user_id;
+        bool delete_user;
+    };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<queued_delete> m_deletes;
+    int64_t m_retention_months;
+    retention_mode m_mode;
+    const size_t m_batch_size;
+    const std::chrono::seconds m_interval;
+    bool m_stop{false};
+
+    // Runs of the thread and of run() must not remove the same partitions concurrently
+    std::mutex m_run_mutex;
+
+    std::thread m_thread;
+
+    void run_thread();
+
+    /**
+     * @brief Deletes the next batch of jobs of a queued user
+     *
+     * @return true if all jobs of the user are deleted
+     */
+    bool delete_batch(const queued_delete &queued);
+
+    job_maintenance(const job_maintenance &) = delete;
+    job_maintenance(job_maintenance &&) = delete;
+    job_maintenance &operator=(const job_maintenance &) = delete;
+    job_maintenance &operator=(job_maintenance &&) = delete;
+
+};  // class job_maintenance
+
+}  // namespace server
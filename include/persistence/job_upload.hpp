@@ -0,0 +1,105 @@
+#pragma once
+
+#include <boost/asio/spawn.hpp>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string>
+#include <vector>
+
+#include <networking/messages/meta_data.hpp>
+#include <persistence/blob_store.hpp>
+#include <persistence/database_pool.hpp>
+#include <persistence/database_wrapper.hpp>
+#include <persistence/payload_compression.hpp>
+#include <persistence/upload_spool.hpp>
+
+namespace server {
+
+/**
+ * @brief Receives the request data of a new job in fixed size chunks and stores it in the
+ * database once complete, so the request never has to be held in memory at once.
+ *
+ * While the data is received, full chunks are compressed and spooled to an <upload_spool>, see
+ * <payload_compression>. If a <blob_store> is configured, requests larger than a chunk or
+ * blob-store-threshold are written to a blob instead. Both happens on <upload_spool::threads>,
+ * suspending the receiving coroutine.
+ *
+ * No database connection is held while receiving, so slow clients can not exhaust the connection
+ * pool. commit() inserts the job and copies the spooled chunks within a single transaction on a
+ * leased connection, the job is invisible to the scheduler until then. If the upload is destroyed
+ * before being committed, the spool file and an unpublished blob are removed.
+ */
+class job_upload
+{
+public:
+    /**
+     * @param user_id The ID of the user who scheduled the job
+     * @param meta Meta data of the job
+     */
+    job_upload(int user_id, meta_data meta);
+
+    job_upload(const job_upload &) = delete;
+    job_upload(job_upload &&) = delete;
+    job_upload &operator=(const job_upload &) = delete;
+    job_upload &operator=(job_upload &&) = delete;
+
+    /**
+     * @brief Appends data to the request. Full chunks are spooled right away.
+     *
+     * @param yield Context of the receiving coroutine
+     * @param data Pointer to the data to append
+     * @param size Size of the data in bytes
+     */
+    void append(boost::asio::yield_context &yield, const char *data, size_t size);
+
+    /**
+     * @brief Inserts the job with all data appended and commits it
+     *
+     * @param yield Context of the receiving coroutine
+     * @param database Connection to insert the job with
+     * @param inserted Called with the ID of the job right before committing, i.e. before the
+     *  scheduler can see the job. Runs on a database thread.
+     * @return ID of the inserted job
+     */
+    int commit(boost::asio::yield_context &yield, const database_pool::lease &database,
+               const std::function<void(int)> &inserted = {});
+
+    /**
+     * @brief Number of bytes appended so far
+     */
+    size_t size() const;
+
+private:
+    /// Spools or writes the buffered data to the blob, last is true if no more data follows
+    void write_chunk(bool last);
+
+    const int m_user_id;
+    const meta_data m_meta;
+
+    size_t m_size{};
+
+    /// Data not yet spooled, at most one chunk
+    binary_data m_buffer;
+
+    /// Compression of the chunks, the same for all chunks of the request
+    payload_compression::encoding m_encoding;
+
+    /// The compressed chunk being spooled or inserted
+    binary_data m_compressed;
+
+    /// The compressed chunks back to back
+    upload_spool m_spool;
+
+    /// Compressed sizes of the spooled chunks
+    std::vector<size_t> m_chunk_sizes;
+
+    /// Store of blobs, nullptr if none is configured
+    const std::shared_ptr<const blob_store> m_blobs;
+
+    /// Blob the request is written to instead of data_chunks
+    std::optional<blob_store::pending_blob> m_blob;
+};
+
+}  // namespace server
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include <persistence/database_wrapper.hpp>
+
+namespace server {
+
+/// A trained zstd dictionary, defined in the source since zstd is an optional dependency
+struct payload_dictionary;
+
+/**
+ * @brief Compression of request payloads at rest in the data table.
+ *
+ * Requests are compressed with zstd (payload-compression-level), using a dictionary trained on
+ * recently stored requests. Graph payloads repeat the same field tags, uids and indices, which a
+ * dictionary captures even for small requests. Dictionaries are stored in the table payload_dicts
+ * and referenced by the dict_id of the data they compressed, so data can always be decompressed
+ * with the dictionary it was written with. A new dictionary is trained every
+ * payload-dict-interval seconds by <job_maintenance>.
+ *
+ * Every payload, e.g. every chunk of an upload, is compressed into an independent zstd frame.
+ * Concatenated frames decompress as a whole, so chunks are decompressed in one pass after reading
+ * them in order.
+ *
+ * Without zstd support in the build, payloads are stored uncompressed and compressed payloads can
+ * not be read. All methods are thread-safe.
+ */
+class payload_compression
+{
+public:
+    /**
+     * @brief How the payloads of a data entry are compressed. Taken once per data entry, so all of
+     * its chunks are compressed with the same dictionary.
+     */
+    struct encoding {
+        graphs::CompressionType codec{graphs::CompressionType::NONE};
+
+        /// Dictionary to compress with, nullptr to compress without one
+        std::shared_ptr<const payload_dictionary> dictionary;
+
+        /// ID of the dictionary in the table payload_dicts
+        std::optional<int> dict_id() const;
+    };
+
+    static payload_compression &instance();
+
+    /**
+     * @param level zstd compression level, payloads are stored uncompressed if zero or negative
+     * @param train_interval Minimum time between training dictionaries, no dictionaries are
+     * trained if zero or negative
+     * @param samples Maximum number of recent requests to train dictionaries on
+     * @param dict_size Maximum size of trained dictionaries in bytes
+     */
+    payload_compression(int level, std::chrono::seconds train_interval, size_t samples,
+                        size_t dict_size);
+
+    /**
+     * @brief The encoding of new payloads, using the newest dictionary loaded by maintain()
+     */
+    encoding current() const;
+
+    /**
+     * @brief Compresses a payload into an independent frame
+     *
+     * @param enc Encoding of the data entry the payload belongs to
+     * @param data The uncompressed payload
+     * @param out Buffer the stored payload is appended to
+     */
+    void encode(const encoding &enc, binary_data_view data, binary_data &out) const;
+
+    /**
+     * @brief Decompresses a stored payload, which may consist of several frames. Dictionaries not
+     * used before are loaded from the database.
+     *
+     * @param codec Codec the payload is compressed with
+     * @param dict_id Dictionary the payload is compressed with, if any
+     * @param data The stored payload, returned as is if it is not compressed
+     * @param db Connection to load the dictionary with, no transaction may be open on it
+     * @throws std::runtime_error If the payload can not be decompressed
+     */
+    binary_data decode(graphs::CompressionType codec, std::optional<int> dict_id,
+                       binary_data data, database_wrapper &db);
+
+    /**
+     * @brief Loads the newest dictionary and trains a new one if it is older than
+     * payload-dict-interval, see <job_maintenance>
+     *
+     * @param db Connection to load and store dictionaries with
+     */
+    void maintain(database_wrapper &db);
+
+private:
+    /// Loads a dictionary from the database, or gets it if it is loaded already
+    std::shared_ptr<const payload_dictionary> load(int dict_id, database_wrapper &db);
+
+    const int m_level;
+    const std::chrono::seconds m_train_interval;
+    const size_t m_samples;
+    const size_t m_dict_size;
+
+    /// Guards all members below
+    mutable std::mutex m_mutex;
+
+    std::shared_ptr<const payload_dictionary> m_current;
+
+    /// Dictionaries loaded so far by their ID, only a few are trained per year
+    std::unordered_map<int, std::shared_ptr<const payload_dictionary>> m_loaded;
+};
+
+}  // namespace server
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/types.h>
+
+#include <persistence/blob_store.hpp>
+#include <persistence/database_wrapper.hpp>
+#include <util/worker_pool.hpp>
+
+namespace server {
+
+/**
+ * @brief Anonymous temporary file holding the data of an upload while it is received, so
+ * neither the data nor a database connection has to be held until the upload is complete.
+ *
+ * The file is created in the temporary directory on the first write and removed by the file
+ * system once the spool is destroyed. Writes block, they are meant to be run on threads().
+ */
+class upload_spool
+{
+public:
+    upload_spool() = default;
+    ~upload_spool();
+
+    upload_spool(const upload_spool &) = delete;
+    upload_spool(upload_spool &&) = delete;
+    upload_spool &operator=(const upload_spool &) = delete;
+    upload_spool &operator=(upload_spool &&) = delete;
+
+    /**
+     * @brief Threads writing to spools, upload-threads many
+     */
+    static worker_pool &threads();
+
+    /**
+     * @brief Appends data to the file
+     * @throws std::system_error If the file can not be created or written
+     */
+    void write(binary_data_view data);
+
+    /**
+     * @brief Reads a part of the file
+     *
+     * @param offset Position of the first byte to read
+     * @param size Number of bytes to read
+     * @param out Buffer the data is stored in, replacing its content
+     * @throws std::system_error If the file can not be read
+     */
+    void read(off_t offset, size_t size, binary_data &out) const;
+
+    /**
+     * @brief Maps the file, which stays valid after the spool is destroyed
+     */
+    mapped_blob map() const;
+
+    /// Number of bytes written
+    size_t size() const { return m_size; }
+
+private:
+    /// -1 until the first write
+    int m_fd{-1};
+    size_t m_size{};
+};
+
+}  // namespace server
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <pqxx/pqxx>
 #include <string>
 
@@ -27,6 +28,13 @@ struct user {
     bool blocked;
     user_role role;
 
+    /**
+     * @brief Maximum size of a single uploaded request in bytes (after decompression). If empty,
+     * the global default of the server is used
+     *
+     */
+    std::optional<int64_t> upload_limit;
+
     nlohmann::json to_json() const;
 
     /**
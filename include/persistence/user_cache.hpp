@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <persistence/user.hpp>
+
+namespace server {
+
+/**
+ * @brief Users looked up by name for authentication, so most requests authenticate without a
+ * database query.
+ *
+ * <database_wrapper> invalidates the entry of a user whenever it changes the user. Entries also
+ * expire after user-cache-ttl seconds, which bounds how long changes made to the database by
+ * other means stay unnoticed. Expired entries are dropped from time to time.
+ *
+ * Lookups that raced with an invalidation are not cached, see generation(). All methods are
+ * thread-safe.
+ */
+class user_cache
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    static user_cache &instance();
+
+    /**
+     * @param ttl Time entries stay valid, the cache is disabled if zero or negative
+     */
+    explicit user_cache(clock::duration ttl);
+
+    /**
+     * @brief Gets the user with the given name if it is cached and not expired
+     */
+    std::optional<user> find(const std::string &name);
+
+    /**
+     * @brief Number of invalidations so far. Taken before loading a user from the database and
+     * passed to insert(), so a user changed meanwhile is not cached.
+     */
+    uint64_t generation();
+
+    /**
+     * @brief Caches a user loaded from the database
+     *
+     * @param u The loaded user
+     * @param generation Result of generation() before the user was loaded
+     */
+    void insert(const user &u, uint64_t generation);
+
+    /**
+     * @brief Drops the entry of a user, must be called after changes to the user are committed
+     */
+    void invalidate(int user_id);
+
+private:
+    struct entry {
+        user cached;
+        clock::time_point expires;
+    };
+
+    const clock::duration m_ttl;
+
+    /// Guards all members below
+    std::mutex m_mutex;
+
+    std::unordered_map<std::string, entry> m_users;
+
+    /// Names of the cached users by their ID
+    std::unordered_map<int, std::string> m_names;
+
+    uint64_t m_generation{};
+
+    /// Number of entries at which expired entries are dropped next
+    size_t m_sweep_size;
+};
+
+}  // namespace server
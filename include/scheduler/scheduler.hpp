@@ -4,8 +4,10 @@
 #include <boost/asio.hpp>
 #include <boost/process.hpp>
 #include <chrono>
+#include <optional>
 #include <persistence/database_wrapper.hpp>
 #include <unordered_set>
+#include <util/tracing.hpp>
 
 namespace server {
 
@@ -26,6 +28,11 @@ struct job_process {
      * 
      */
     int user_id;
+    /**
+     * @brief Handler type of the job, to record metrics by handler
+     * 
+     */
+    std::string handler_type;
     /**
      * @brief boost::asio::io_service to catch output
      * 
@@ -51,6 +58,11 @@ struct job_process {
      * 
      */
     time_point start;
+    /**
+     * @brief Trace of the job, if it was submitted while tracing
+     * 
+     */
+    std::optional<tracing::trace> trace;
 };
 
 class scheduler
@@ -152,7 +164,7 @@ public:
 
     /**
      * @brief Cancels all running jobs of the user with id user_id. No updates are written into the
-     * database.
+     * database, but the traces of the user's jobs are ended as aborted.
      *
      * @param user_id
      */
@@ -183,6 +195,29 @@ private:
 
     void run_thread();
 
+    /**
+     * @brief Pushes the current status of a job to the subscriptions of its user. Requires
+     * m_mutex to be locked.
+     */
+    void notify_status(int job_id, int user_id);
+
+    /**
+     * @brief Records the metrics and spans of a job leaving the scheduler
+     *
+     * @param process The process of the job
+     * @param status The status the job finished with
+     * @param ogdf_runtime Runtime of the algorithm as stored by the handler process
+     */
+    static void record_finished(const job_process &process, graphs::StatusType status,
+                                std::chrono::microseconds ogdf_runtime);
+
+    /**
+     * @brief Ends the trace of a job aborted before the scheduler started it
+     *
+     * @param job_trace The trace taken from <tracing>
+     */
+    static void record_aborted_waiting(const tracing::trace &job_trace);
+
     //Rule of five
 
     scheduler(const scheduler &) = delete;
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+#include <nlohmann/json.hpp>
+
+namespace server {
+
+/**
+ * @brief Breakdown of the time a handler process spends on a job, stored in jobs.phase_times and
+ * returned in the status of the job.
+ *
+ * Phases are accumulated per thread, since a handler process handles its job on a single thread.
+ * The code of each phase records itself, e.g. the parsing of graphs in <graph_message>, so the
+ * breakdown stays the same no matter which handler runs.
+ */
+class job_phases
+{
+public:
+    enum phase : size_t {
+        /// Loading meta data and request from the database, including decompression
+        LOAD,
+        /// Parsing the request from the container
+        PARSE,
+        /// Building the graph of the request
+        GRAPH,
+        /// Parsing costs, coordinates and other attributes of the request
+        ATTRIBUTES,
+        /// Preparing the algorithm call in the handler
+        PREPARE,
+        /// The algorithm call, as measured by the handler
+        ALGORITHM,
+        /// Building the result graph and the response of the handler
+        RESULT,
+        /// Serializing and compressing the response
+        SERIALIZE,
+        /// Writing the response, up to the statement which also stores these phase times
+        STORE,
+        NOF_PHASES
+    };
+
+    /**
+     * @brief Adds the time from its construction until its destruction to a phase of the
+     * calling thread
+     */
+    class scope
+    {
+    public:
+        explicit scope(phase p)
+            : m_phase{p}
+            , m_start{std::chrono::steady_clock::now()}
+        {
+        }
+
+        scope(const scope &) = delete;
+        scope &operator=(const scope &) = delete;
+
+        ~scope() { current().add(m_phase, std::chrono::steady_clock::now() - m_start); }
+
+    private:
+        const phase m_phase;
+        const std::chrono::steady_clock::time_point m_start;
+    };
+
+    /// The phases recorded by the calling thread
+    static job_phases &current();
+
+    void add(phase p, std::chrono::steady_clock::duration duration);
+    std::chrono::microseconds get(phase p) const { return m_durations[p]; }
+
+    /// Name of a phase, as used in the breakdown
+    static const char *name(phase p);
+
+    /**
+     * @brief The breakdown as JSON object of microseconds by phase name, e.g. {"load": 1200}.
+     * Phases which did not occur, e.g. graph parsing for requests without graph, are omitted.
+     */
+    nlohmann::json to_json() const;
+
+private:
+    std::array<std::chrono::microseconds, NOF_PHASES> m_durations{};
+};
+
+}  // namespace server
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+/**
+ * @brief Monotonically increasing count, e.g. of sent bytes
+ */
+class counter
+{
+public:
+    void add(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{};
+};
+
+/**
+ * @brief Value which may go up and down, e.g. the number of waiting jobs
+ */
+class gauge
+{
+public:
+    void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value{};
+};
+
+/**
+ * @brief Distribution of durations with a fixed relative precision, like an HDR histogram.
+ *
+ * Durations are counted in microseconds, in buckets covering each power of two with 16 linear
+ * sub-buckets, so they are resolved to about 6% from one microsecond up to days. Recording is
+ * lock-free and does not allocate.
+ */
+class histogram
+{
+public:
+    void record(std::chrono::steady_clock::duration duration);
+
+    /**
+     * @brief Counts the durations shorter than each of the given bounds, from one snapshot
+     *
+     * @param bits Exponents of the bounds of 2^bits microseconds, ascending and from 4 to 39,
+     *  where bounds fall on bucket boundaries so the counts are exact
+     * @return Cumulative counts for the bounds followed by the count of all durations
+     */
+    std::vector<uint64_t> counts_below(const std::vector<int> &bits) const;
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    std::chrono::microseconds sum() const
+    {
+        return std::chrono::microseconds{m_sum.load(std::memory_order_relaxed)};
+    }
+
+private:
+    static constexpr const int SUB_BUCKET_BITS = 4;
+    static constexpr const uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+
+    /// Longer durations (about 12 days) are counted in the last bucket
+    static constexpr const int MAX_BITS = 40;
+    static constexpr const size_t BUCKETS = SUB_BUCKETS * (MAX_BITS - SUB_BUCKET_BITS + 1);
+
+    static size_t bucket(uint64_t micros);
+
+    std::array<std::atomic<uint64_t>, BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_count{};
+    std::atomic<uint64_t> m_sum{};
+};
+
+/**
+ * @brief Measures the time from its construction until it is recorded to a histogram
+ */
+class stopwatch
+{
+public:
+    stopwatch()
+        : m_start{std::chrono::steady_clock::now()}
+    {
+    }
+
+    std::chrono::steady_clock::duration elapsed() const
+    {
+        return std::chrono::steady_clock::now() - m_start;
+    }
+
+    void record(histogram &target) const { target.record(elapsed()); }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @brief Registry of the metrics of the server, exported in the Prometheus text format by
+ * <metrics_server> and the management API.
+ *
+ * Metrics are identified by their name and labels and created on first use. They are never
+ * removed, so references to them stay valid and can be kept by callers recording on hot paths.
+ * Histograms are exported as Prometheus histograms with cumulative buckets of 2^k microseconds for
+ * the even k from 4 to 36 (16 us to about 19 hours), so quantiles over any time window can be
+ * computed with histogram_quantile(). All methods are thread-safe.
+ */
+class metrics
+{
+public:
+    using labels = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+    static metrics &instance();
+
+    /**
+     * @param name Name of the metric without the "spanners_" prefix
+     * @param help Description of the metric, taken from its first use
+     * @param label_values Label names and values distinguishing metrics of the same name
+     */
+    counter &get_counter(std::string_view name, std::string_view help, labels label_values = {});
+    gauge &get_gauge(std::string_view name, std::string_view help, labels label_values = {});
+    histogram &get_histogram(std::string_view name, std::string_view help,
+                             labels label_values = {});
+
+    /**
+     * @brief Exports all metrics in the Prometheus text exposition format
+     */
+    std::string to_prometheus() const;
+
+private:
+    metrics() = default;
+
+    template <typename Metric>
+    struct family {
+        std::string help;
+
+        /// Metrics by their rendered labels, e.g. {type="GENERIC"}
+        std::map<std::string, std::unique_ptr<Metric>, std::less<>> series;
+    };
+
+    template <typename Metric>
+    using families = std::map<std::string, family<Metric>, std::less<>>;
+
+    template <typename Metric>
+    Metric &get(families<Metric> &all, std::string_view name, std::string_view help,
+                labels label_values);
+
+    /// Guards all members below
+    mutable std::mutex m_mutex;
+
+    families<counter> m_counters;
+    families<gauge> m_gauges;
+    families<histogram> m_histograms;
+};
+
+}  // namespace server
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace server {
+
+/**
+ * @brief Spans of the timeline of jobs, from receiving them over waiting in the database and
+ * running their handler process until the scheduler reaps it.
+ *
+ * Every job submitted while tracing gets a random trace ID. Spans are appended to a file in the
+ * Chrome trace event format as async events with the trace ID as global ID, so each job becomes
+ * one track in Perfetto (ui.perfetto.dev) or chrome://tracing, even though its spans are recorded
+ * by the server and the handler process. The server passes the file and the trace ID to handler
+ * processes as arguments. Timestamps are taken from the monotonic clock, which is the same for
+ * all processes of a machine.
+ *
+ * Tracing is started with the option trace-file or at runtime through the management API. The
+ * file is only appended to, the closing bracket of the JSON array is optional in this format.
+ * All methods are thread-safe.
+ */
+class tracing
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief A job submitted while tracing, which the scheduler did not start yet
+     */
+    struct trace {
+        uint64_t id;
+
+        /// Start of receiving the job
+        clock::time_point start;
+
+        /// Commit of the job, i.e. the start of waiting for the scheduler
+        clock::time_point submitted;
+
+        /// User the job belongs to, so traces of deleted users can be taken
+        int user_id{};
+    };
+
+    /**
+     * @brief Records the time from its construction until its destruction as span
+     */
+    class span
+    {
+    public:
+        span(uint64_t trace_id, std::string_view name)
+            : m_trace_id{trace_id}
+            , m_name{name}
+            , m_start{clock::now()}
+        {
+        }
+
+        span(const span &) = delete;
+        span &operator=(const span &) = delete;
+
+        ~span() { instance().record(m_trace_id, m_name, m_start, clock::now()); }
+
+    private:
+        const uint64_t m_trace_id;
+        const std::string_view m_name;
+        const clock::time_point m_start;
+    };
+
+    static tracing &instance();
+
+    ~tracing();
+
+    /**
+     * @brief Starts appending spans to a file, which is created if it does not exist. Tracing to
+     * another file is stopped.
+     *
+     * @throws std::runtime_error If the file can not be opened
+     */
+    void start(const std::string &path);
+
+    /**
+     * @brief Stops tracing, jobs already submitted are no longer traced either
+     */
+    void stop();
+
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    /// File spans are written to, empty if tracing is stopped
+    std::string file() const;
+
+    /// Number of traced jobs waiting for the scheduler
+    size_t pending() const;
+
+    /**
+     * @brief Creates the ID of a new trace
+     *
+     * @return Random nonzero ID, zero if tracing is stopped
+     */
+    uint64_t new_trace() const;
+
+    /**
+     * @brief Remembers the trace of a submitted job for the scheduler, see take()
+     */
+    void submitted(int job_id, const trace &job_trace);
+
+    /**
+     * @brief Takes the trace of a job started by the scheduler
+     *
+     * @return The trace, std::nullopt if the job was not submitted while tracing
+     */
+    std::optional<trace> take(int job_id);
+
+    /**
+     * @brief Takes the traces of all jobs of a user which the scheduler did not start yet, e.g.
+     * when they are aborted
+     *
+     * @return Traces by job ID
+     */
+    std::vector<std::pair<int, trace>> take_user(int user_id);
+
+    /**
+     * @brief Writes a span, ignored for the trace ID zero or if tracing is stopped
+     *
+     * @param trace_id Trace the span belongs to
+     * @param name Name of the span, e.g. "queue"
+     * @param args Additional values shown with the span, e.g. the status of a job
+     */
+    void record(uint64_t trace_id, std::string_view name, clock::time_point start,
+                clock::time_point end, const nlohmann::json &args = nlohmann::json::object());
+
+    /**
+     * @brief Writes the start of a span which ends in another place, e.g. the span of a whole
+     * job. Spans starting at the same time nest in the order they are written.
+     */
+    void begin(uint64_t trace_id, std::string_view name, clock::time_point start,
+               const nlohmann::json &args = nlohmann::json::object());
+
+    /**
+     * @brief Writes the end of a span started by begin(), args are added to those of the start
+     */
+    void end(uint64_t trace_id, std::string_view name, clock::time_point end,
+             const nlohmann::json &args = nlohmann::json::object());
+
+private:
+    tracing() = default;
+
+    /// Appends events in one write, so events of other processes are not interleaved
+    void write(const std::string &events);
+
+    std::atomic<bool> m_enabled{false};
+
+    /// Guards all members below
+    mutable std::mutex m_mutex;
+
+    std::string m_file;
+    int m_fd{-1};
+
+    std::unordered_map<int, trace> m_pending;
+};
+
+}  // namespace server
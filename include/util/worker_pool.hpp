@@ -0,0 +1,150 @@
+#pragma once
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/execution.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/system/system_error.hpp>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace server {
+
+/**
+ * @brief Fixed size pool of threads executing blocking or CPU heavy tasks off the io threads.
+ *
+ * The queue of pending tasks is bounded, so a flood of submissions is rejected early instead of
+ * piling up unbounded work.
+ */
+class worker_pool
+{
+public:
+    /**
+     * @brief Starts the worker threads of the pool
+     *
+     * @param nof_threads Number of worker threads (at least one thread is started)
+     * @param queue_limit Maximum number of tasks waiting for a free worker
+     */
+    worker_pool(size_t nof_threads, size_t queue_limit);
+
+    /**
+     * @brief Stops the pool. Already queued tasks are still executed before the workers join.
+     */
+    ~worker_pool();
+
+    worker_pool(const worker_pool &) = delete;
+    worker_pool(worker_pool &&) = delete;
+    worker_pool &operator=(const worker_pool &) = delete;
+    worker_pool &operator=(worker_pool &&) = delete;
+
+    /**
+     * @brief Enqueues a task without waiting for its execution
+     *
+     * @param task Task to execute on one of the worker threads
+     * @return bool False if the queue limit is reached and the task was rejected, else true
+     */
+    bool try_submit(std::function<void()> task);
+
+    /**
+     * @brief Runs a function on the pool and suspends the calling coroutine until it finished.
+     *  The coroutine is resumed on its own executor, so no io thread is blocked in between.
+     *
+     * @param yield Context of the calling coroutine
+     * @param function Function to execute. Exceptions thrown by it are rethrown to the caller.
+     * @return The result of function
+     * @throws boost::system::system_error with boost::asio::error::would_block if the queue limit
+     *  is reached
+     */
+    template <typename Function>
+    std::invoke_result_t<Function> async_run(boost::asio::yield_context &yield,
+                                             Function &&function);
+
+private:
+    void run_worker();
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::function<void()>> m_queue;
+    const size_t m_queue_limit;
+    bool m_stopped{false};
+    std::vector<std::thread> m_threads;
+};
+
+template <typename Function>
+std::invoke_result_t<Function> worker_pool::async_run(boost::asio::yield_context &yield,
+                                                      Function &&function)
+{
+    using result_type = std::invoke_result_t<Function>;
+    using storage_type = std::conditional_t<std::is_void_v<result_type>, bool, result_type>;
+
+    // Both live on the stack of the suspended coroutine until the completion handler resumed it
+    std::optional<storage_type> result;
+    std::exception_ptr exception;
+
+    boost::system::error_code error;
+    auto token = yield[error];
+    boost::asio::async_initiate<boost::asio::yield_context, void(boost::system::error_code)>(
+        [this, &function, &result, &exception](auto handler) {
+            using handler_type = decltype(handler);
+
+            // Keep the executor of the coroutine busy while the task is executed
+            auto executor = boost::asio::prefer(boost::asio::get_associated_executor(handler),
+                                                boost::asio::execution::outstanding_work.tracked);
+            auto shared_handler = std::make_shared<handler_type>(std::move(handler));
+
+            const auto complete = [executor, shared_handler](boost::system::error_code ec) {
+                boost::asio::post(executor, [shared_handler, ec]() { (*shared_handler)(ec); });
+            };
+
+            const bool submitted = try_submit([&function, &result, &exception, complete]() {
+                try
+                {
+                    if constexpr (std::is_void_v<result_type>)
+                    {
+                        function();
+                        result.emplace(true);
+                    }
+                    else
+                    {
+                        result.emplace(function());
+                    }
+                }
+                catch (...)
+                {
+                    exception = std::current_exception();
+                }
+                complete(boost::system::error_code{});
+            });
+
+            if (!submitted)
+            {
+                complete(boost::asio::error::would_block);
+            }
+        },
+        token);
+
+    if (error)
+    {
+        throw boost::system::system_error{error};
+    }
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+
+    if constexpr (!std::is_void_v<result_type>)
+    {
+        return std::move(*result);
+    }
+}
+
+}  // namespace server
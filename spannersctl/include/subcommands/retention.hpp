@@ -0,0 +1,10 @@
+#pragma once
+
+#include "subcommands/constants.hpp"
+#include "util/span.hpp"
+
+namespace cli {
+namespace retention {
+    exit_code handle(span<std::string_view> args);
+}  // namespace retention
+}  // namespace cli
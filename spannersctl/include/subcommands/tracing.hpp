@@ -0,0 +1,10 @@
+#pragma once
+
+#include "subcommands/constants.hpp"
+#include "util/span.hpp"
+
+namespace cli {
+namespace tracing {
+    exit_code handle(span<std::string_view> args);
+}  // namespace tracing
+}  // namespace cli
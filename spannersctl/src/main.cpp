@@ -2,7 +2,10 @@
 
 #include "subcommands/constants.hpp"
 #include "subcommands/job.hpp"
+#include "subcommands/metrics.hpp"
+#include "subcommands/retention.hpp"
 #include "subcommands/scheduler.hpp"
+#include "subcommands/tracing.hpp"
 #include "subcommands/user.hpp"
 #include "util/span.hpp"
 
@@ -10,7 +13,7 @@ void print_help()
 {
     // clang-format off
     static const std::string_view HELP_TEXT =
-        "Usage: spannersctl { job | user | scheduler } ...\n"
+        "Usage: spannersctl { job | user | scheduler | retention | metrics | tracing } ...\n"
         "Use any of the subcommands to get further help about a specific subcommand.";
     // clang-format on
 
@@ -42,6 +45,18 @@ int main(int argc, const char **argv)
     {
         ec = cli::user::handle(args.tail());
     }
+    else if (command == "retention")
+    {
+        ec = cli::retention::handle(args.tail());
+    }
+    else if (command == "metrics")
+    {
+        ec = cli::metrics::handle(args.tail());
+    }
+    else if (command == "tracing")
+    {
+        ec = cli::tracing::handle(args.tail());
+    }
     else
     {
         print_help();
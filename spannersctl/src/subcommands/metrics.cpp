@@ -0,0 +1,117 @@
+#include "subcommands/metrics.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "io/io.hpp"
+#include "subcommands/constants.hpp"
+#include "util/json.hpp"
+#include "util/span.hpp"
+
+using nlohmann::json;
+
+namespace cli {
+
+namespace {
+    namespace detail {
+        json make_request(std::string_view cmd)
+        {
+            json req;
+            req["type"] = "metrics";
+            req["cmd"] = std::string{cmd};
+
+            return req;
+        }
+    }  // namespace detail
+
+    void print_help()
+    {
+        // clang-format off
+        static const std::string_view HELP_TEXT =
+            "Available metrics commands: spannersctl metrics { show [name] }\n"
+            "    show [name] -- print the metrics of the server in the Prometheus text format, optionally only\n"
+            "                   those whose name starts with the given prefix, e.g. spanners_request_duration.\n"
+            "The same metrics are served at http://<metrics-address>:<metrics-port>/metrics.";
+        // clang-format on
+
+        std::cout << HELP_TEXT << std::endl;
+    }
+
+    exit_code show(span<std::string_view> args)
+    {
+        io::instance().send(detail::make_request("show"));
+        const auto msg = io::instance().receive();
+
+        if (msg.at("status") != "ok")
+        {
+            std::cerr << "A server error occurred:\n";
+            util::print(std::cerr, msg.at("error"));
+            return exit_code::ERROR;
+        }
+
+        // The text format is printed as is, so it can be piped into other tools
+        const auto text = msg.at("message").get<std::string>();
+        if (args.empty())
+        {
+            std::cout << text;
+            return exit_code::OK;
+        }
+
+        // Comments are printed along with the samples of the selected metrics
+        const auto &prefix = args.front();
+        std::istringstream lines{text};
+        for (std::string line; std::getline(lines, line);)
+        {
+            std::string_view name{line};
+            if (name.rfind("# HELP ", 0) == 0 || name.rfind("# TYPE ", 0) == 0)
+            {
+                name.remove_prefix(7);
+            }
+
+            if (name.substr(0, prefix.size()) == prefix)
+            {
+                std::cout << line << '\n';
+            }
+        }
+
+        return exit_code::OK;
+    }
+}  // namespace
+
+namespace metrics {
+    exit_code handle(span<std::string_view> args)
+    {
+        if (args.empty())
+        {
+            print_help();
+            return exit_code::OK;
+        }
+
+        const auto &sc = args.front();
+        exit_code ec;
+        try
+        {
+            if (sc == "show")
+            {
+                ec = show(args.tail());
+            }
+            else
+            {
+                print_help();
+                return exit_code::ERROR;
+            }
+        }
+        catch (json::exception &error)
+        {
+            std::cerr << "Server sent invalid data" << std::endl;
+            return exit_code::ERROR;
+        }
+
+        return ec;
+    }
+}  // namespace metrics
+
+}  // namespace cli
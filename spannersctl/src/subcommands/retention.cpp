@@ -0,0 +1,174 @@
+#include "subcommands/retention.hpp"
+
+#include <charconv>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "io/io.hpp"
+#include "subcommands/constants.hpp"
+#include "util/json.hpp"
+#include "util/span.hpp"
+
+using nlohmann::json;
+
+namespace cli {
+
+namespace {
+    namespace detail {
+        json make_request(std::string_view cmd, json arg = {})
+        {
+            json req;
+            req["type"] = "retention";
+            req["cmd"] = std::string{cmd};
+            req["arg"] = std::move(arg);
+
+            return req;
+        }
+
+        int64_t parse_months(std::string_view arg)
+        {
+            int64_t months{};
+            const auto [ptr, err] = std::from_chars(arg.data(), arg.data() + arg.size(), months);
+
+            if ((err != std::errc{}) || (ptr != arg.data() + arg.size()))
+            {
+                throw std::invalid_argument{std::string{arg} + " could not be parsed to a number"};
+            }
+
+            return months;
+        }
+
+        exit_code send(json req, bool print_message)
+        {
+            io::instance().send(std::move(req));
+            const auto msg = io::instance().receive();
+
+            if (msg.at("status") != "ok")
+            {
+                std::cerr << "A server error occurred:\n";
+                util::print(std::cerr, msg.at("error"));
+                return exit_code::ERROR;
+            }
+
+            if (print_message)
+            {
+                util::print(std::cout, msg.at("message"));
+            }
+
+            return exit_code::OK;
+        }
+    }  // namespace detail
+
+    void print_help()
+    {
+        // clang-format off
+        static const std::string_view HELP_TEXT =
+            "Available retention commands: spannersctl retention { info | months [value] | mode [detach|drop] | apply }\n"
+            "Jobs are stored in partitions by the month they were received in. Partitions older than the\n"
+            "retention period are removed periodically by the server.\n"
+            "    info           -- show the retention policy, the partitions and the number of users whose jobs are being deleted.\n"
+            "    months [value] -- number of full months jobs are kept besides the current month, 0 keeps jobs forever.\n"
+            "    mode [value]   -- detach keeps removed partitions as plain tables for archiving, drop deletes them.\n"
+            "    apply          -- remove expired partitions now and list them.\n"
+            "If the optional argument is omitted, the current value of the selected option is fetched.\n"
+            "Changed values only last until the server is restarted, set them in the config file to keep them.";
+        // clang-format on
+
+        std::cout << HELP_TEXT << std::endl;
+    }
+
+    exit_code info(span<std::string_view> /*args*/)
+    {
+        return detail::send(detail::make_request("info"), true);
+    }
+
+    exit_code months(span<std::string_view> args)
+    {
+        if (args.empty())
+        {
+            return detail::send(detail::make_request("months"), true);
+        }
+
+        try
+        {
+            return detail::send(
+                detail::make_request("months", detail::parse_months(args.front())), false);
+        }
+        catch (std::invalid_argument const &ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            return exit_code::ERROR;
+        }
+    }
+
+    exit_code mode(span<std::string_view> args)
+    {
+        if (args.empty())
+        {
+            return detail::send(detail::make_request("mode"), true);
+        }
+
+        if (args.front() != "detach" && args.front() != "drop")
+        {
+            print_help();
+            return exit_code::ERROR;
+        }
+
+        return detail::send(detail::make_request("mode", std::string{args.front()}), false);
+    }
+
+    exit_code apply(span<std::string_view> /*args*/)
+    {
+        return detail::send(detail::make_request("apply"), true);
+    }
+}  // namespace
+
+namespace retention {
+    exit_code handle(span<std::string_view> args)
+    {
+        if (args.empty())
+        {
+            print_help();
+            return exit_code::OK;
+        }
+
+        const auto &sc = args.front();
+        exit_code ec;
+        try
+        {
+            if (sc == "info")
+            {
+                ec = info(args.tail());
+            }
+            else if (sc == "months")
+            {
+                ec = months(args.tail());
+            }
+            else if (sc == "mode")
+            {
+                ec = mode(args.tail());
+            }
+            else if (sc == "apply")
+            {
+                ec = apply(args.tail());
+            }
+            else
+            {
+                print_help();
+                return exit_code::ERROR;
+            }
+        }
+        catch (json::exception &error)
+        {
+            std::cerr << "Server sent invalid data" << std::endl;
+            return exit_code::ERROR;
+        }
+
+        return ec;
+    }
+}  // namespace retention
+
+}  // namespace cli
@@ -0,0 +1,123 @@
+#include "subcommands/tracing.hpp"
+
+#include <iostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "io/io.hpp"
+#include "subcommands/constants.hpp"
+#include "util/json.hpp"
+#include "util/span.hpp"
+
+using nlohmann::json;
+
+namespace cli {
+
+namespace {
+    namespace detail {
+        json make_request(std::string_view cmd, json arg = {})
+        {
+            json req;
+            req["type"] = "tracing";
+            req["cmd"] = std::string{cmd};
+            req["arg"] = std::move(arg);
+
+            return req;
+        }
+
+        exit_code send(json req)
+        {
+            io::instance().send(std::move(req));
+            const auto msg = io::instance().receive();
+
+            if (msg.at("status") != "ok")
+            {
+                std::cerr << "A server error occurred:\n";
+                util::print(std::cerr, msg.at("error"));
+                return exit_code::ERROR;
+            }
+
+            util::print(std::cout, msg.at("message"));
+            return exit_code::OK;
+        }
+    }  // namespace detail
+
+    void print_help()
+    {
+        // clang-format off
+        static const std::string_view HELP_TEXT =
+            "Available tracing commands: spannersctl tracing { info | start [file] | stop }\n"
+            "Traced jobs are followed from receiving them until their handler process finished. Their spans are\n"
+            "appended to a file in the Chrome trace event format, which can be opened in https://ui.perfetto.dev.\n"
+            "    info         -- show whether jobs are traced, the trace file and the number of traced jobs waiting.\n"
+            "    start [file] -- trace new jobs, appending to the given file or the configured trace-file.\n"
+            "    stop         -- stop tracing, the file is kept.";
+        // clang-format on
+
+        std::cout << HELP_TEXT << std::endl;
+    }
+
+    exit_code info(span<std::string_view> /*args*/)
+    {
+        return detail::send(detail::make_request("info"));
+    }
+
+    exit_code start(span<std::string_view> args)
+    {
+        if (args.empty())
+        {
+            return detail::send(detail::make_request("start"));
+        }
+
+        return detail::send(detail::make_request("start", std::string{args.front()}));
+    }
+
+    exit_code stop(span<std::string_view> /*args*/)
+    {
+        return detail::send(detail::make_request("stop"));
+    }
+}  // namespace
+
+namespace tracing {
+    exit_code handle(span<std::string_view> args)
+    {
+        if (args.empty())
+        {
+            print_help();
+            return exit_code::OK;
+        }
+
+        const auto &sc = args.front();
+        exit_code ec;
+        try
+        {
+            if (sc == "info")
+            {
+                ec = info(args.tail());
+            }
+            else if (sc == "start")
+            {
+                ec = start(args.tail());
+            }
+            else if (sc == "stop")
+            {
+                ec = stop(args.tail());
+            }
+            else
+            {
+                print_help();
+                return exit_code::ERROR;
+            }
+        }
+        catch (json::exception &error)
+        {
+            std::cerr << "Server sent invalid data" << std::endl;
+            return exit_code::ERROR;
+        }
+
+        return ec;
+    }
+}  // namespace tracing
+
+}  // namespace cli
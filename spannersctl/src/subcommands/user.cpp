@@ -1,6 +1,8 @@
 #include "subcommands/user.hpp"
 
 #include <iostream>
+#include <optional>
+#include <string>
 
 #include <nlohmann/json.hpp>
 
@@ -100,17 +102,37 @@ namespace {
 
             return resp;
         }
+
+        json set_upload_limit(std::string_view name_or_id, std::optional<int64_t> limit)
+        {
+            auto req = [name_or_id, limit] {
+                json req;
+                req["type"] = "user";
+                req["cmd"] = "upload-limit";
+                req["arg"]["user"] = std::string{name_or_id};
+                req["arg"]["limit"] = limit ? json(*limit) : json(nullptr);
+
+                return req;
+            }();
+
+            io::instance().send(std::move(req));
+            auto resp = io::instance().receive();
+
+            return resp;
+        }
     }  // namespace detail
 
     void print_help()
     {
         // clang-format off
         static const std::string_view HELP_TEXT =
-            "Available user commands: spannersctl user { block <user> | delete <user> | list | info <user> }\n"
+            "Available user commands: spannersctl user { block <user> | unblock <user> | upload-limit <bytes|default> <user> | delete <user> | list | info <user> }\n"
             "Users can be identified by their name or ID.\n"
             "    block <user>   -- block the user from submitting any further requests.\n"
             "    unblock <user> -- unblock the user from submitting any further requests.\n"
-            "    delete <user>  -- deletes the user and all associated jobs.\n"
+            "    upload-limit <bytes|default> <user>\n"
+            "                   -- set the maximum size of the decompressed request of a new job.\n"
+            "    delete <user>  -- blocks the user, then deletes it and all associated jobs in the background.\n"
             "    list           -- list all users.\n"
             "    info <user>    -- print detailed information about a single user.";
         // clang-format on
@@ -218,6 +240,41 @@ namespace {
 
         return exit_code::OK;
     }
+
+    exit_code upload_limit(span<std::string_view> args)
+    {
+        if (args.size() < 2)
+        {
+            print_help();
+            return exit_code::ERROR;
+        }
+
+        std::optional<int64_t> limit;
+        if (args.front() != "default")
+        {
+            try
+            {
+                limit = std::stoll(std::string{args.front()});
+            }
+            catch (std::logic_error &)
+            {
+                std::cerr << "Invalid upload limit: " << args.front() << std::endl;
+                return exit_code::ERROR;
+            }
+        }
+
+        const auto name_or_id = util::join(args.tail());
+        const auto msg = detail::set_upload_limit(name_or_id, limit);
+
+        if (msg.at("status") != "ok")
+        {
+            std::cerr << "A server error occurred:\n";
+            util::print(std::cerr, msg.at("error"));
+            return exit_code::ERROR;
+        }
+
+        return exit_code::OK;
+    }
 }  // namespace
 
 namespace user {
@@ -253,6 +310,10 @@ namespace user {
             {
                 ec = unblock(args.tail());
             }
+            else if (sc == "upload-limit")
+            {
+                ec = upload_limit(args.tail());
+            }
             else
             {
                 print_help();
@@ -1,9 +1,19 @@
 #include <auth/auth_utils.hpp>
 
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <array>
+#include <charconv>
 #include <limits>
 #include <random>
+#include <stdexcept>
 #include "argon2.h"
 
+#include <config/config.hpp>
+#include <util/worker_pool.hpp>
+
 namespace server {
 
 namespace auth_utils {
@@ -14,6 +24,68 @@ namespace auth_utils {
         constexpr const uint32_t PASSES = 2;
         constexpr const uint32_t MEM_USE = (1 << 16);  // 64 MB
         constexpr const uint32_t THREADS = 1;
+
+        constexpr const size_t TOKEN_KEY_LENGTH = 32;
+        constexpr const char TOKEN_SEPARATOR = '.';
+
+        using token_key = std::array<unsigned char, TOKEN_KEY_LENGTH>;
+        using token_mac = std::array<unsigned char, EVP_MAX_MD_SIZE>;
+
+        worker_pool &hashing_pool()
+        {
+            static worker_pool pool{config()[config_options::AUTH_THREADS].as<size_t>(),
+                                    config()[config_options::AUTH_QUEUE_LIMIT].as<size_t>()};
+            return pool;
+        }
+
+        const token_key &session_token_key()
+        {
+            static const token_key key = []() {
+                token_key key;
+                if (RAND_bytes(key.data(), key.size()) != 1)
+                {
+                    throw std::runtime_error("Can not generate session token key");
+                }
+                return key;
+            }();
+            return key;
+        }
+
+        /// The signed payload consists of the public token part and the users password hash
+        unsigned int sign_session_token(const std::string &payload, const user &user,
+                                        token_mac &mac)
+        {
+            const auto &key = session_token_key();
+            std::string message = payload;
+            message.append(reinterpret_cast<const char *>(user.pw_hash.data()),
+                           user.pw_hash.size());
+
+            unsigned int mac_length = 0;
+            HMAC(EVP_sha256(), key.data(), key.size(),
+                 reinterpret_cast<const unsigned char *>(message.data()), message.size(),
+                 mac.data(), &mac_length);
+            return mac_length;
+        }
+
+        std::string to_hex(const unsigned char *data, size_t length)
+        {
+            constexpr const char *const digits = "0123456789abcdef";
+
+            std::string hex(2 * length, '0');
+            for (size_t i = 0; i < length; ++i)
+            {
+                hex[2 * i] = digits[data[i] >> 4];
+                hex[2 * i + 1] = digits[data[i] & 0x0f];
+            }
+            return hex;
+        }
+
+        int64_t seconds_since_epoch()
+        {
+            return std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
     }  // namespace
 
     bool check_password(const std::string &password, const binary_data &salt,
@@ -57,6 +129,79 @@ namespace auth_utils {
         }
     }
 
+    bool async_check_password(boost::asio::yield_context &yield, const std::string &password,
+                              const binary_data &salt, const binary_data &correct_hash)
+    {
+        return hashing_pool().async_run(yield, [&]() {
+            return check_password(password, salt, correct_hash);
+        });
+    }
+
+    bool async_hash_password(boost::asio::yield_context &yield, const std::string &pw,
+                             binary_data &hashed_pw, binary_data &salt)
+    {
+        return hashing_pool().async_run(yield, [&]() {
+            return hash_password(pw, hashed_pw, salt);
+        });
+    }
+
+    std::string issue_session_token(const user &user, std::chrono::seconds lifetime)
+    {
+        // Format: <user id>.<expiration as unix time>.<hex encoded HMAC-SHA256>
+        const int64_t expires = seconds_since_epoch() + lifetime.count();
+        std::string token = std::to_string(user.user_id) + TOKEN_SEPARATOR +
+                            std::to_string(expires) + TOKEN_SEPARATOR;
+
+        token_mac mac;
+        const unsigned int mac_length = sign_session_token(token, user, mac);
+        token += to_hex(mac.data(), mac_length);
+
+        return token;
+    }
+
+    bool check_session_token(const std::string &token, const user &user)
+    {
+        const auto id_end = token.find(TOKEN_SEPARATOR);
+        if (id_end == std::string::npos)
+        {
+            return false;
+        }
+        const auto expires_end = token.find(TOKEN_SEPARATOR, id_end + 1);
+        if (expires_end == std::string::npos)
+        {
+            return false;
+        }
+
+        int user_id = 0;
+        int64_t expires = 0;
+        const char *const begin = token.data();
+        if (const auto [ptr, ec] = std::from_chars(begin, begin + id_end, user_id);
+            ec != std::errc{} || ptr != begin + id_end)
+        {
+            return false;
+        }
+        if (const auto [ptr, ec] =
+                std::from_chars(begin + id_end + 1, begin + expires_end, expires);
+            ec != std::errc{} || ptr != begin + expires_end)
+        {
+            return false;
+        }
+
+        if (user_id != user.user_id || expires < seconds_since_epoch())
+        {
+            return false;
+        }
+
+        token_mac mac;
+        const unsigned int mac_length =
+            sign_session_token(token.substr(0, expires_end + 1), user, mac);
+        const std::string expected = to_hex(mac.data(), mac_length);
+        const std::string_view received = std::string_view{token}.substr(expires_end + 1);
+
+        return received.size() == expected.size() &&
+               CRYPTO_memcmp(received.data(), expected.data(), expected.size()) == 0;
+    }
+
 }  // namespace auth_utils
 
 }  // namespace server
@@ -54,12 +54,92 @@ void config_parser::set_options()
         };
 
         add(config_options::SERVER_PORT, static_cast<unsigned short>(4711), "server port");
+        add(config_options::SERVER_THREADS, size_t{0},
+            "number of threads serving client connections (if zero, the number of hardware "
+            "threads is used)");
+        add(config_options::CONNECTION_IDLE_TIMEOUT, int64_t{60},
+            "seconds after which idle client connections are closed (if zero or negative, idle "
+            "connections are kept open)");
+        add(config_options::CONNECTION_PIPELINE_LIMIT, size_t{16},
+            "maximum number of concurrently handled requests of a single client connection");
+        add(config_options::CONNECTION_LIMIT, size_t{1024},
+            "maximum number of concurrent client connections, further clients wait in the listen "
+            "backlog (if zero, the number of connections is not limited)");
+        add(config_options::CONNECTION_READ_TIMEOUT, int64_t{30},
+            "seconds a client may take for the TLS handshake, to send the rest of a started "
+            "request or the next chunk of a job upload (if zero or negative, reads never time "
+            "out)");
+        add(config_options::CONNECTION_RATE_LIMIT, 20.0,
+            "new connections per second accepted from a single address, allowing bursts of one "
+            "second (if zero or negative, connections are not rate limited)");
+        add(config_options::REQUEST_RATE_LIMIT, 100.0,
+            "requests per second read from a single address, allowing bursts of one second; "
+            "further requests are delayed (if zero or negative, requests are not rate limited)");
+        add(config_options::PAYLOAD_MEMORY_BUDGET, size_t{1} << 30,
+            "maximum number of bytes of received requests held in memory by all connections "
+            "together, reading pauses while it is exhausted (if zero, memory is not limited)");
+        add(config_options::REQUEST_SIZE_LIMIT, size_t{16} << 20,
+            "maximum size in bytes of a received container, except for new jobs");
+        add(config_options::UPLOAD_LIMIT, int64_t{1} << 30,
+            "default maximum size in bytes of the decompressed request of a new job or of an "
+            "uploaded graph (can be overridden per user)");
+        add(config_options::UPLOAD_TIMEOUT, int64_t{600},
+            "seconds a client may take to send the whole request of a new job (if zero or "
+            "negative, uploads never time out)");
+        add(config_options::UPLOAD_THREADS, size_t{2},
+            "number of threads compressing and spooling the requests of new jobs and uploaded "
+            "graphs while they are received");
         add(config_options::DB_HOST, std::string{"localhost"}, "database host");
         add(config_options::DB_PORT, 5432, "database port");
         add(config_options::DB_USER, std::string{"spanner_user"}, "database user");
         add(config_options::DB_NAME, std::string{"spanner_db"}, "database name");
         add(config_options::DB_PASSWORD, std::string{"pwd"}, "database password");
         add(config_options::DB_TIMEOUT, 10, "database timeout in seconds");
+        add(config_options::DB_POOL_MIN_SIZE, size_t{2},
+            "number of database connections kept open for client and management requests");
+        add(config_options::DB_POOL_MAX_SIZE, size_t{16},
+            "maximum number of database connections used for client and management requests, "
+            "further requests wait for a free connection (job uploads hold one while receiving)");
+        add(config_options::DB_POOL_CHECK_INTERVAL, int64_t{30},
+            "seconds after which an idle pooled database connection is checked before reuse");
+        add(config_options::DB_POOL_IDLE_TIMEOUT, int64_t{300},
+            "seconds after which idle pooled database connections beyond the minimum are closed");
+        add(config_options::BLOB_STORE_PATH, std::string{},
+            "directory of the content-addressed store for request and response payloads (if "
+            "empty, all payloads are stored in the database)");
+        add(config_options::BLOB_STORE_THRESHOLD, size_t{64} << 10,
+            "minimum size in bytes of payloads kept in the blob store instead of the database");
+        add(config_options::JOB_RETENTION_MONTHS, int64_t{0},
+            "number of full months jobs are kept besides the current month (if zero or negative, "
+            "jobs are kept forever)");
+        add(config_options::JOB_RETENTION_MODE, std::string{"detach"},
+            "what happens to the jobs of expired months: 'detach' keeps them in plain tables for "
+            "archiving, 'drop' deletes them");
+        add(config_options::JOB_DELETE_BATCH_SIZE, size_t{1000},
+            "number of jobs deleted per transaction when deleting all jobs of a user");
+        add(config_options::JOB_MAINTENANCE_INTERVAL, int64_t{3600},
+            "seconds between creating upcoming job partitions and removing expired ones");
+        add(config_options::USER_CACHE_TTL, int64_t{60},
+            "seconds users stay cached for authentication, which bounds how long direct changes "
+            "to the database go unnoticed (if zero or negative, users are not cached)");
+        add(config_options::PAYLOAD_COMPRESSION_LEVEL, int{3},
+            "zstd level requests are compressed with in the database (if zero or negative, or "
+            "the server was built without zstd, requests are stored uncompressed)");
+        add(config_options::PAYLOAD_DICT_INTERVAL, int64_t{86400},
+            "seconds between training new dictionaries for compressing requests (if zero or "
+            "negative, requests are compressed without dictionaries)");
+        add(config_options::PAYLOAD_DICT_SAMPLES, size_t{1000},
+            "number of recent requests dictionaries for compressing requests are trained on");
+        add(config_options::PAYLOAD_DICT_SIZE, size_t{112640},
+            "maximum size in bytes of dictionaries for compressing requests");
+        add(config_options::METRICS_ADDRESS, std::string{"127.0.0.1"},
+            "address the metrics endpoint listens on for Prometheus scrapes");
+        add(config_options::METRICS_PORT, static_cast<unsigned short>(4712),
+            "port of the metrics endpoint (if zero, metrics are only available through "
+            "spannersctl)");
+        add(config_options::TRACE_FILE, std::string{""},
+            "file spans of jobs are appended to in the Chrome trace event format (if empty, "
+            "tracing is only started through spannersctl)");
         add(config_options::SCHEDULER_EXEC_PATH, std::string{"./src/handler_process"},
             "absolute path to the handler_process executable");
         add(config_options::SCHEDULER_PROCESS_LIMIT, size_t{4},
@@ -72,6 +152,16 @@ void config_parser::set_options()
         add(config_options::SCHEDULER_SLEEP, int64_t{1000}, "scheduler sleep in milliseconds");
         add(config_options::TLS_CERT_PATH, std::string{}, "path to signed TLS certificate");
         add(config_options::TLS_KEY_PATH, std::string{}, "path to key file");
+        add(config_options::TLS_KERNEL_OFFLOAD, true,
+            "let the kernel encrypt sent data after the TLS handshake (kTLS) if supported by the "
+            "kernel and the negotiated cipher");
+        add(config_options::AUTH_THREADS, size_t{2},
+            "number of threads verifying passwords (each hash uses 64 MB of memory)");
+        add(config_options::AUTH_QUEUE_LIMIT, size_t{32},
+            "maximum number of password checks waiting for a free thread before new login "
+            "attempts are rejected");
+        add(config_options::SESSION_TOKEN_LIFETIME, int64_t{3600},
+            "lifetime of issued session tokens in seconds");
     }
 
     m_cmdline_options.add(m_generic_options).add(m_configuration_options);
@@ -145,12 +235,52 @@ void config_parser::parse_environment_variables()
               [](const std::string &env_var) {
                   static const std::unordered_map<std::string, std::string> env_to_cfg{
                       {config_env_vars::SERVER_PORT, config_options::SERVER_PORT},
+                      {config_env_vars::SERVER_THREADS, config_options::SERVER_THREADS},
+                      {config_env_vars::CONNECTION_IDLE_TIMEOUT,
+                       config_options::CONNECTION_IDLE_TIMEOUT},
+                      {config_env_vars::CONNECTION_PIPELINE_LIMIT,
+                       config_options::CONNECTION_PIPELINE_LIMIT},
+                      {config_env_vars::CONNECTION_LIMIT, config_options::CONNECTION_LIMIT},
+                      {config_env_vars::CONNECTION_READ_TIMEOUT,
+                       config_options::CONNECTION_READ_TIMEOUT},
+                      {config_env_vars::CONNECTION_RATE_LIMIT,
+                       config_options::CONNECTION_RATE_LIMIT},
+                      {config_env_vars::REQUEST_RATE_LIMIT, config_options::REQUEST_RATE_LIMIT},
+                      {config_env_vars::PAYLOAD_MEMORY_BUDGET,
+                       config_options::PAYLOAD_MEMORY_BUDGET},
+                      {config_env_vars::REQUEST_SIZE_LIMIT, config_options::REQUEST_SIZE_LIMIT},
+                      {config_env_vars::UPLOAD_LIMIT, config_options::UPLOAD_LIMIT},
+                      {config_env_vars::UPLOAD_TIMEOUT, config_options::UPLOAD_TIMEOUT},
+                      {config_env_vars::UPLOAD_THREADS, config_options::UPLOAD_THREADS},
                       {config_env_vars::DB_HOST, config_options::DB_HOST},
                       {config_env_vars::DB_PORT, config_options::DB_PORT},
                       {config_env_vars::DB_USER, config_options::DB_USER},
                       {config_env_vars::DB_NAME, config_options::DB_NAME},
                       {config_env_vars::DB_PASSWORD, config_options::DB_PASSWORD},
                       {config_env_vars::DB_TIMEOUT, config_options::DB_TIMEOUT},
+                      {config_env_vars::DB_POOL_MIN_SIZE, config_options::DB_POOL_MIN_SIZE},
+                      {config_env_vars::DB_POOL_MAX_SIZE, config_options::DB_POOL_MAX_SIZE},
+                      {config_env_vars::DB_POOL_CHECK_INTERVAL,
+                       config_options::DB_POOL_CHECK_INTERVAL},
+                      {config_env_vars::DB_POOL_IDLE_TIMEOUT, config_options::DB_POOL_IDLE_TIMEOUT},
+                      {config_env_vars::BLOB_STORE_PATH, config_options::BLOB_STORE_PATH},
+                      {config_env_vars::BLOB_STORE_THRESHOLD, config_options::BLOB_STORE_THRESHOLD},
+                      {config_env_vars::JOB_RETENTION_MONTHS, config_options::JOB_RETENTION_MONTHS},
+                      {config_env_vars::JOB_RETENTION_MODE, config_options::JOB_RETENTION_MODE},
+                      {config_env_vars::JOB_DELETE_BATCH_SIZE,
+                       config_options::JOB_DELETE_BATCH_SIZE},
+                      {config_env_vars::JOB_MAINTENANCE_INTERVAL,
+                       config_options::JOB_MAINTENANCE_INTERVAL},
+                      {config_env_vars::USER_CACHE_TTL, config_options::USER_CACHE_TTL},
+                      {config_env_vars::PAYLOAD_COMPRESSION_LEVEL,
+                       config_options::PAYLOAD_COMPRESSION_LEVEL},
+                      {config_env_vars::PAYLOAD_DICT_INTERVAL,
+                       config_options::PAYLOAD_DICT_INTERVAL},
+                      {config_env_vars::PAYLOAD_DICT_SAMPLES, config_options::PAYLOAD_DICT_SAMPLES},
+                      {config_env_vars::PAYLOAD_DICT_SIZE, config_options::PAYLOAD_DICT_SIZE},
+                      {config_env_vars::METRICS_ADDRESS, config_options::METRICS_ADDRESS},
+                      {config_env_vars::METRICS_PORT, config_options::METRICS_PORT},
+                      {config_env_vars::TRACE_FILE, config_options::TRACE_FILE},
                       {config_env_vars::SCHEDULER_EXEC_PATH, config_options::SCHEDULER_EXEC_PATH},
                       {config_env_vars::SCHEDULER_PROCESS_LIMIT,
                        config_options::SCHEDULER_PROCESS_LIMIT},
@@ -159,7 +289,12 @@ void config_parser::parse_environment_variables()
                        config_options::SCHEDULER_RESOURCE_LIMIT},
                       {config_env_vars::SCHEDULER_SLEEP, config_options::SCHEDULER_SLEEP},
                       {config_env_vars::TLS_CERT_PATH, config_options::TLS_CERT_PATH},
-                      {config_env_vars::TLS_CERT_PATH, config_options::TLS_KEY_PATH}};
+                      {config_env_vars::TLS_CERT_PATH, config_options::TLS_KEY_PATH},
+                      {config_env_vars::TLS_KERNEL_OFFLOAD, config_options::TLS_KERNEL_OFFLOAD},
+                      {config_env_vars::AUTH_THREADS, config_options::AUTH_THREADS},
+                      {config_env_vars::AUTH_QUEUE_LIMIT, config_options::AUTH_QUEUE_LIMIT},
+                      {config_env_vars::SESSION_TOKEN_LIFETIME,
+                       config_options::SESSION_TOKEN_LIFETIME}};
 
                   if (auto it = env_to_cfg.find(env_var); it != env_to_cfg.end())
                   {
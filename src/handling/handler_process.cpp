@@ -2,10 +2,15 @@
 #include <unistd.h>
 #include <handling/handler_utilities.hpp>
 #include <iostream>
+#include <memory>
 #include <networking/messages/meta_data.hpp>
+#include <optional>
+#include <persistence/blob_store.hpp>
 #include <persistence/database_wrapper.hpp>
 #include <scheduler/process_flags.hpp>
 #include <string>
+#include <util/job_phases.hpp>
+#include <util/tracing.hpp>
 #include <vector>
 
 #include <google/protobuf/util/time_util.h>
@@ -16,7 +21,8 @@ using namespace server;
  * @brief Process to handle a single job with id job_id of user with id user_id
  *
  * @param argc
- * @param argv (job_id, user_id, db_connection_string[, memory limit])
+ * @param argv (job_id, user_id, db_connection_string, memory limit, blob store path (empty if
+ *  disabled), blob store threshold, trace file (empty if the job is not traced), trace id)
  * @return int
  */
 int main(int argc, char *argv[])
@@ -24,7 +30,7 @@ int main(int argc, char *argv[])
     //an alternative to using args could be: boost.org/doc/libs/1_76_0/doc/html/interprocess/sharedmemorybetweenprocesses.html
     // Just give on arg as name of shared memory and store other arguments an/or returns there
 
-    if (argc != 5)
+    if (argc != 9)
     {
         std::cerr << "Wrong number of arguments" << std::endl;
         return process_flags::GENERAL_ERROR;
@@ -85,13 +91,53 @@ int main(int argc, char *argv[])
         }
     }
 
-    database_wrapper database(argv[3]);
+    std::shared_ptr<const blob_store> blobs;
+    try
+    {
+        if (argv[5][0] != '\0')
+        {
+            blobs = std::make_shared<blob_store>(argv[5], std::stoull(argv[6]));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Could not open blob store: " << e.what() << std::endl;
+        return process_flags::GENERAL_ERROR;
+    }
+
+    // Spans are appended to the trace of the job, see <tracing>. A job is not worth failing
+    // for its trace, and anything written to stderr would end up in the job.
+    uint64_t trace_id = 0;
+    if (argv[7][0] != '\0')
+    {
+        try
+        {
+            trace_id = std::stoull(argv[8]);
+            tracing::instance().start(argv[7]);
+        }
+        catch (const std::exception &e)
+        {
+            trace_id = 0;
+        }
+    }
+
+    database_wrapper database(argv[3], blobs);
+    std::optional<job_phases::scope> load_phase{job_phases::LOAD};
+    std::optional<tracing::span> load_span{std::in_place, trace_id, "load"};
     meta_data meta = database.get_meta_data(job_id, user_id);
     auto [type, request] = database.get_request_data(job_id, user_id);
+    load_span.reset();
+    load_phase.reset();
 
+    std::optional<tracing::span> handle_span{std::in_place, trace_id, "handle"};
     auto response = server::handle(meta, request);
+    handle_span.reset();
 
-    database.add_response(job_id, type, response.response_proto, response.ogdf_time);
+    {
+        const tracing::span store_span{trace_id, "store"};
+        database.add_response(job_id, type, response.response_proto, response.ogdf_time,
+                              [] { return job_phases::current().to_json(); });
+    }
 
     return process_flags::SUCCESS;
 }
@@ -1,20 +1,20 @@
 #include <handling/handler_utilities.hpp>
+#include <algorithm>
+#include <chrono>
 #include <handling/handlers/dijkstra_handler.hpp>
 #include <iostream>
 #include <networking/exceptions.hpp>
 #include <networking/requests/request_factory.hpp>
 #include <networking/responses/available_handlers_response.hpp>
 #include <networking/responses/generic_response.hpp>
+#include <util/job_phases.hpp>
 
 namespace server {
 
-void copy_static_attributes(const graphs::RequestContainer &request_container,
+void copy_static_attributes(const std::unordered_map<std::string, std::string> &static_attributes,
                             generic_response &response)
 {
-    graphs::GenericRequest proto_request;
-    request_container.request().UnpackTo(&proto_request);
-
-    response.m_static_attributes = proto_request.staticattributes();
+    response.m_static_attributes = {static_attributes.begin(), static_attributes.end()};
 }
 
 handle_return handle(const meta_data &meta, graphs::RequestContainer &requestData)
@@ -30,12 +30,29 @@ handle_return handle(const meta_data &meta, graphs::RequestContainer &requestDat
                 throw std::runtime_error("handler_utilities: dynamic_cast failed!");
             }
 
+            // The request is moved into the handler, so its static attributes are taken before
+            auto static_attributes = handler_name_finder->static_attributes();
+
             auto &factories = handler_utilities::handler_factories();
             const auto factory = factories.at(meta.handler_type).get();
             auto handler = factory->produce(std::move(request));
 
+            // Handlers only measure their algorithm call and record building the result, the rest
+            // of their time is spent preparing the call
+            auto &phases = job_phases::current();
+            const auto result_before = phases.get(job_phases::RESULT);
+            const auto start = std::chrono::steady_clock::now();
+
             response = handler->handle();
 
+            const auto algorithm = std::chrono::microseconds{response.ogdf_time};
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+            const auto result = phases.get(job_phases::RESULT) - result_before;
+            phases.add(job_phases::ALGORITHM, algorithm);
+            phases.add(job_phases::PREPARE,
+                       std::max(elapsed - algorithm - result, std::chrono::microseconds::zero()));
+
             if (!response.response_abstract)
             {
                 throw response_error("response_abstract is nullptr!",
@@ -49,7 +66,9 @@ handle_return handle(const meta_data &meta, graphs::RequestContainer &requestDat
 
                 // We need to manually copy over static attributes because we cannot rely on the handler
                 // doing so
-                copy_static_attributes(requestData, *response_generic);
+                copy_static_attributes(static_attributes, *response_generic);
+
+                const job_phases::scope serialize_phase{job_phases::SERIALIZE};
                 response.response_proto =
                     response_factory::build_response(std::move(response.response_abstract));
                 response.response_abstract = nullptr;
@@ -38,6 +38,7 @@ handle_return dijkstra_handler::handle()
 
     auto stop = std::chrono::high_resolution_clock::now();
     long ogdf_time = (std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count();
+    const job_phases::scope result_phase{job_phases::RESULT};
 
     // Build shortest path graph from origin to index
     auto spg = std::make_unique<ogdf::Graph>();
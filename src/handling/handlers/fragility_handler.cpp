@@ -59,6 +59,7 @@ handle_return fragility_handler::handle()
 
     auto stop = std::chrono::high_resolution_clock::now();
     long ogdf_time = (std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count();
+    const job_phases::scope result_phase{job_phases::RESULT};
 
     server::generic_response::attribute_map<std::string> graph_attributes;
     graph_attributes["avgFragility"] = std::to_string(std::get<0>(graph_fragility));
@@ -55,6 +55,7 @@ handle_return yao_graph_euclid_handler::handle()
     yao_graph_algorithm.call(ga, stretch, *spanner, in_spanner);
     auto stop = std::chrono::high_resolution_clock::now();
     long ogdf_time = (std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count();
+    const job_phases::scope result_phase{job_phases::RESULT};
 
     const auto &og_node_uids = graph_message->node_uids();
     auto spanner_node_uids = std::make_unique<ogdf::NodeArray<server::uid_t>>(*spanner);
@@ -82,6 +82,7 @@ handle_return kruskal_handler::handle()
 
     auto stop = std::chrono::high_resolution_clock::now();
     long ogdf_time = (std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count();
+    const job_phases::scope result_phase{job_phases::RESULT};
 
     server::generic_response::attribute_map<std::string> graph_attributes;
     graph_attributes["totalWeight"] = std::to_string(total_weight);
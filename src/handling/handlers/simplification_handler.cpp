@@ -42,6 +42,7 @@ handle_return simplification_handler::handle()
     auto simple_graph = std::make_unique<ogdf::GraphSimplification>(ga);
     auto stop = std::chrono::high_resolution_clock::now();
     long ogdf_time = (std::chrono::duration_cast<std::chrono::microseconds>(stop - start)).count();
+    const job_phases::scope result_phase{job_phases::RESULT};
 
     ogdf::GraphAttributes ga_simple = simple_graph->getGraphAttributes();
 
@@ -2,22 +2,33 @@
 
 #include <boost/asio/completion_condition.hpp>
 #include <boost/endian/conversion.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filtering_streambuf.hpp>
+#include <sys/sendfile.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include <iostream>
-#include <iterator>
 #include <string>
 #include "argon2.h"
 
 #include <auth/auth_utils.hpp>
 #include <config/config.hpp>
 #include <handling/handler_utilities.hpp>
+#include <networking/io/compression.hpp>
 #include <networking/io/connection_handler.hpp>
+#include <networking/io/job_subscriptions.hpp>
+#include <networking/io/memory_budget.hpp>
 #include <networking/io/request_handling.hpp>
 #include <networking/requests/request_factory.hpp>
 #include <persistence/database_wrapper.hpp>
+#include <persistence/job_upload.hpp>
+#include <persistence/upload_spool.hpp>
 #include <persistence/user.hpp>
+#include <persistence/user_cache.hpp>
 #include <scheduler/scheduler.hpp>
+#include <util/metrics.hpp>
+#include <util/tracing.hpp>
 
 #include <result.pb.h>
 
@@ -39,196 +50,857 @@ namespace server {
 
 namespace {
     constexpr int LENGTH_FIELD_SIZE = 8;
+
+    /// Size of the buffer job and graph uploads are read into from the socket
+    constexpr size_t UPLOAD_BUFFER_SIZE = 64 * 1024;
+
+    /// Decompressed data of an uploaded graph is written to the spool in pieces of this size
+    constexpr size_t GRAPH_SPOOL_BUFFER_SIZE = 1 << 20;  // 1 MB
+
+    /// Maximum size of the meta data of a request, which holds only a few short fields
+    constexpr size_t META_SIZE_LIMIT = 64 * 1024;
+
+    /// All requests not listed here create a new job
+    bool is_new_job(RequestType type)
+    {
+        switch (type)
+        {
+            case RequestType::AUTH:
+            case RequestType::AVAILABLE_HANDLERS:
+            case RequestType::STATUS:
+            case RequestType::RESULT:
+            case RequestType::ABORT_JOB:
+            case RequestType::DELETE_JOB:
+            case RequestType::ORIGIN_GRAPH:
+            case RequestType::CREATE_USER:
+            case RequestType::SUBSCRIBE:
+            case RequestType::UPLOAD_GRAPH:
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    counter &received_bytes()
+    {
+        static counter &bytes = metrics::instance().get_counter(
+            "client_received_bytes_total", "Bytes received from clients, including framing");
+        return bytes;
+    }
+
+    counter &sent_bytes()
+    {
+        static counter &bytes = metrics::instance().get_counter(
+            "client_sent_bytes_total", "Bytes sent to clients, including framing");
+        return bytes;
+    }
+
+    /// Time from reading a request until its response is queued, by the type of the request
+    histogram &request_duration(RequestType type)
+    {
+        return metrics::instance().get_histogram(
+            "request_duration_seconds", "Time taken to handle client requests",
+            {{"type", graphs::RequestType_Name(type)}});
+    }
+
+    /**
+     * @brief Input stream reading a container of known size from the socket, suspending the
+     *  coroutine while waiting for data. At most one buffer of data is held in memory.
+     *  Every read from the socket is guarded by a deadline, cancelled once the read finished.
+     */
+    template <typename Stream>
+    class socket_input_stream : public google::protobuf::io::ZeroCopyInputStream
+    {
+    public:
+        socket_input_stream(Stream &stream, boost::asio::yield_context &yield, size_t size,
+                            boost::asio::steady_timer &deadline,
+                            std::function<void()> start_deadline)
+            : m_stream{stream}
+            , m_yield{yield}
+            , m_remaining{size}
+            , m_buffer(std::min(size, UPLOAD_BUFFER_SIZE))
+            , m_deadline{deadline}
+            , m_start_deadline{std::move(start_deadline)}
+        {
+        }
+
+        bool Next(const void **data, int *size) override
+        {
+            if (m_position == m_filled)
+            {
+                if (!fill())
+                {
+                    return false;
+                }
+            }
+
+            *data = m_buffer.data() + m_position;
+            *size = static_cast<int>(m_filled - m_position);
+            m_byte_count += m_filled - m_position;
+            m_position = m_filled;
+            return true;
+        }
+
+        void BackUp(int count) override
+        {
+            m_position -= count;
+            m_byte_count -= count;
+        }
+
+        bool Skip(int count) override
+        {
+            const void *data;
+            int size;
+            while (count > 0 && Next(&data, &size))
+            {
+                if (size > count)
+                {
+                    BackUp(size - count);
+                    return true;
+                }
+                count -= size;
+            }
+            return count == 0;
+        }
+
+        int64_t ByteCount() const override { return m_byte_count; }
+
+        /// Number of bytes of the container that were not read from the socket yet
+        size_t remaining() const { return m_remaining; }
+
+        /// Reads and discards the rest of the container, so the next frame can be read
+        bool skip_remaining()
+        {
+            while (!m_failed && m_remaining > 0)
+            {
+                fill();
+            }
+            m_position = m_filled;
+            return !m_failed;
+        }
+
+        /// True if reading from the socket failed
+        bool failed() const { return m_failed; }
+
+    private:
+        bool fill()
+        {
+            if (m_failed || m_remaining == 0)
+            {
+                return false;
+            }
+
+            error_code error;
+            const auto read_size = std::min(m_remaining, m_buffer.size());
+            m_start_deadline();
+            m_filled = m_stream.async_read_some(buffer(m_buffer.data(), read_size), m_yield[error]);
+            m_deadline.cancel();
+            m_position = 0;
+            m_remaining -= m_filled;
+            received_bytes().add(m_filled);
+
+            if (error)
+            {
+                std::cout << "[CONNECTION] Read error: " << error << '\n';
+                m_failed = true;
+                m_filled = 0;
+                return false;
+            }
+            return true;
+        }
+
+        Stream &m_stream;
+        boost::asio::yield_context &m_yield;
+        size_t m_remaining;
+        std::vector<char> m_buffer;
+        size_t m_position{};
+        size_t m_filled{};
+        int64_t m_byte_count{};
+        bool m_failed{false};
+        boost::asio::steady_timer &m_deadline;
+        std::function<void()> m_start_deadline;
+    };
 }  // namespace
 
 client_connection::client_connection(size_t id, connection_handler<client_connection> &handler,
-                                     socket_ptr sock)
+                                     socket_ptr sock, boost::asio::ip::address source,
+                                     rate_limiter &request_limiter)
     : m_identifier{id}
     , m_handler{handler}
     , m_sock{std::move(sock)}
+    , m_writer_signal{m_sock->get_executor()}
+    , m_reader_signal{m_sock->get_executor()}
+    , m_idle_timer{m_sock->get_executor()}
+    , m_read_deadline{m_sock->get_executor()}
+    , m_upload_deadline{m_sock->get_executor()}
+    , m_source{std::move(source)}
+    , m_request_limiter{request_limiter}
 {
-#ifndef SPANNERS_UNENCRYPTED_CONNECTION
-    error_code error;
-    m_sock->handshake(boost::asio::ssl::stream_base::server, error);
-    if (error)
-    {
-        throw std::runtime_error{"Failed to perform handshake"};
-    }
-#endif
 }
 
 void client_connection::handle()
 {
     boost::asio::spawn(m_sock->get_executor(), [this](boost::asio::yield_context yield) {
+#ifndef SPANNERS_UNENCRYPTED_CONNECTION
+        error_code error;
+        start_read_deadline();
+        m_sock->async_handshake(boost::asio::ssl::stream_base::server, yield[error]);
+        m_read_deadline.cancel();
+        if (error)
+        {
+            std::cout << "[ERROR] Connection to client failed: " << error.message() << '\n';
+            m_handler.remove(m_identifier);
+            return;
+        }
+#endif
+
+        // The writer owns the end of the connection, it deregisters it once everything is sent
+        boost::asio::spawn(m_sock->get_executor(), [this](boost::asio::yield_context yield) {
+            write_responses(yield);
+        });
+
+        read_requests(yield);
+    });
+}
+
+void client_connection::read_requests(boost::asio::yield_context &yield)
+{
+    const auto pipeline_limit =
+        std::max(config()[config_options::CONNECTION_PIPELINE_LIMIT].as<size_t>(), size_t{1});
+    const auto request_size_limit = config()[config_options::REQUEST_SIZE_LIMIT].as<size_t>();
+
+    while (true)
+    {
+        restart_idle_timer();
+
+        // Read size of meta message
+        size_t recv_size;
+        if (!direct_read(yield, reinterpret_cast<char *const>(&recv_size), LENGTH_FIELD_SIZE))
+        {
+            break;
+        }
+        boost::endian::big_to_native_inplace(recv_size);
+
+        // Clients sending too many requests are slowed down before the request is read
+        throttle(yield);
+
         try
         {
-            handle_internal(yield);
+            // Read and parse meta message, once started the rest of the frame has to arrive in
+            // time
+            start_read_deadline();
+            auto meta_proto = std::make_shared<MetaData>(read_meta_data(yield, recv_size));
+            m_read_deadline.cancel();
+
+            if (is_new_job(meta_proto->type()) || meta_proto->type() == RequestType::UPLOAD_GRAPH)
+            {
+                // Job and graph uploads may be as large as the upload limit of the user. They are
+                // spooled while they are received, so they are handled right here instead of
+                // being buffered for a separate coroutine.
+                const bool received = is_new_job(meta_proto->type())
+                                          ? receive_job(yield, *meta_proto)
+                                          : receive_graph(yield, *meta_proto);
+                if (!received)
+                {
+                    break;
+                }
+                continue;
+            }
+
+            if (meta_proto->containersize() > request_size_limit)
+            {
+                // Not worth reading, the stream can not be resynchronized without doing so
+                respond_error(*meta_proto, ResponseContainer::INVALID_REQUEST_ERROR);
+                break;
+            }
+
+            // Reading pauses while the payloads of all connections exhaust the memory budget
+            auto reservation = memory_budget::instance().reserve(yield, m_sock->get_executor(),
+                                                                 meta_proto->containersize());
+
+            // Read the still compressed container, it is decompressed by the request handling
+            std::vector<char> container(meta_proto->containersize());
+            start_read_deadline();
+            if (!direct_read(yield, container.data(), container.size()))
+            {
+                break;
+            }
+            m_read_deadline.cancel();
+
+            // Handle the request concurrently, so the next one can be read in the meantime. The
+            // container stays reserved until it is released with the handling coroutine.
+            ++m_pending_requests;
+            boost::asio::spawn(m_sock->get_executor(),
+                               [this, meta_proto, container = std::move(container),
+                                reservation = std::move(reservation)](
+                                   boost::asio::yield_context yield) {
+                                   const stopwatch watch;
+                                   handle_request(yield, *meta_proto, container);
+                                   watch.record(request_duration(meta_proto->type()));
+
+                                   --m_pending_requests;
+                                   m_reader_signal.cancel();
+                                   m_writer_signal.cancel();
+                               });
         }
         catch (ResponseContainer::StatusCode &error)
         {
+            // The stream can not be resynchronized after a broken frame
             std::cout << "[ERROR] " << error << '\n';
-            respond_error(yield, error);
+            respond_error(MetaData{}, error);
+            break;
         }
-        catch (ErrorType &error)
+
+        // Limit the number of concurrently handled requests
+        while (m_pending_requests >= pipeline_limit)
         {
-            std::cout << "[ERROR] " << error << '\n';
-            respond_error(yield, error);
+            error_code error;
+            m_reader_signal.expires_at(boost::asio::steady_timer::time_point::max());
+            m_reader_signal.async_wait(yield[error]);
         }
-        catch (graphs::ErrorMessage &error)
+    }
+
+    m_read_deadline.cancel();
+    m_reading_finished = true;
+    m_writer_signal.cancel();
+}
+
+void client_connection::write_responses(boost::asio::yield_context &yield)
+{
+    bool write_failed = false;
+    while (true)
+    {
+        while (!m_outbox.empty())
         {
-            std::cout << "[ERROR] " << error.type() << '\n';
-            respond(yield, meta_data{graphs::RequestType::ERROR}, error);
+            // Keep the frame in the queue while it is written, so the queue may grow meanwhile
+            if (!write_failed && !write_frame(yield, m_outbox.front()))
+            {
+                // Stop reading as well, the client would not receive any further response
+                write_failed = true;
+                error_code error;
+                m_sock->lowest_layer().close(error);
+            }
+            m_outbox.pop_front();
+        }
+
+        if (m_reading_finished && m_pending_requests == 0)
+        {
+            break;
+        }
+
+        error_code error;
+        m_writer_signal.expires_at(boost::asio::steady_timer::time_point::max());
+        m_writer_signal.async_wait(yield[error]);
+    }
+
+    // Connection finished, ending the subscription first so nothing is pushed anymore
+    m_subscription.reset();
+    m_idle_timer.cancel();
+    m_read_deadline.cancel();
+    m_upload_deadline.cancel();
+    m_handler.remove(m_identifier);
+}
+
+void client_connection::restart_idle_timer()
+{
+    const auto idle_timeout = config()[config_options::CONNECTION_IDLE_TIMEOUT].as<int64_t>();
+    if (idle_timeout <= 0)
+    {
+        return;
+    }
+
+    m_idle_timer.expires_after(std::chrono::seconds{idle_timeout});
+    m_idle_timer.async_wait([this, alive = std::weak_ptr<const bool>{m_alive}](
+                                const error_code &error) {
+        if (error || alive.expired())
+        {
+            // Restarted or connection finished
             return;
         }
-        catch (std::exception &ex)
+
+        if (m_pending_requests > 0 || !m_outbox.empty() || m_subscription)
         {
-            std::cout << "[ERROR] " << ex.what() << '\n';
-            respond_error(yield, ResponseContainer::ERROR);
+            // Not idle, still busy with requests or waiting for status changes to push
+            restart_idle_timer();
+            return;
         }
 
-        // Connection finished
-        m_handler.remove(m_identifier);
+        std::cout << "[CONNECTION] Closing idle connection " << m_identifier << '\n';
+        error_code close_error;
+        m_sock->lowest_layer().close(close_error);
     });
 }
 
-void client_connection::handle_internal(boost::asio::yield_context &yield)
+void client_connection::start_read_deadline()
 {
-    // Read size of meta message
-    size_t recv_size;
-    if (!direct_read(yield, reinterpret_cast<char *const>(&recv_size), LENGTH_FIELD_SIZE))
+    const auto read_timeout = config()[config_options::CONNECTION_READ_TIMEOUT].as<int64_t>();
+    if (read_timeout <= 0)
     {
-        throw ResponseContainer::READ_ERROR;
+        return;
     }
-    boost::endian::big_to_native_inplace(recv_size);
 
-    // Read and parse meta message
-    MetaData meta_proto = read_message<MetaData>(yield, recv_size);
+    m_read_deadline.expires_after(std::chrono::seconds{read_timeout});
+    m_read_deadline.async_wait([this, alive = std::weak_ptr<const bool>{m_alive}](
+                                   const error_code &error) {
+        if (error || alive.expired())
+        {
+            // Read finished in time, restarted or connection finished
+            return;
+        }
 
-    // User authentication
-    std::string connection_string = server::get_db_connection_string();
-    database_wrapper database(connection_string);
+        std::cout << "[CONNECTION] Read timed out, closing connection " << m_identifier << '\n';
+        error_code close_error;
+        m_sock->lowest_layer().close(close_error);
+    });
+}
 
-    const auto user = database.get_user(meta_proto.user().name());
-    if (!user || user->blocked)
+void client_connection::start_upload_deadline()
+{
+    const auto upload_timeout = config()[config_options::UPLOAD_TIMEOUT].as<int64_t>();
+    if (upload_timeout <= 0)
     {
-        // Check if user creation or unauthorized user
-        if (meta_proto.type() == RequestType::CREATE_USER)
+        return;
+    }
+
+    m_upload_deadline.expires_after(std::chrono::seconds{upload_timeout});
+    m_upload_deadline.async_wait([this, alive = std::weak_ptr<const bool>{m_alive}](
+                                     const error_code &error) {
+        if (error || alive.expired())
         {
-            // If the user is unknown and the request type is USER_CREATION create new user
-            auto [response_meta, response] = handle_user_creation(database, meta_proto);
-            respond(yield, response_meta, response);
+            // Upload finished in time or connection finished
             return;
         }
-        else
+
+        std::cout << "[CONNECTION] Upload timed out, closing connection " << m_identifier << '\n';
+        error_code close_error;
+        m_sock->lowest_layer().close(close_error);
+    });
+}
+
+void client_connection::throttle(boost::asio::yield_context &yield)
+{
+    const auto delay = m_request_limiter.acquire(m_source);
+    if (delay == rate_limiter::clock::duration::zero())
+    {
+        return;
+    }
+
+    // The reader signal is also cancelled by finished requests, so wait until the time is over
+    const auto until = rate_limiter::clock::now() + delay;
+    while (rate_limiter::clock::now() < until)
+    {
+        error_code error;
+        m_reader_signal.expires_at(until);
+        m_reader_signal.async_wait(yield[error]);
+    }
+}
+
+database_pool::lease client_connection::database(boost::asio::yield_context &yield)
+{
+    return database_pool::instance().acquire(yield, m_sock->get_executor());
+}
+
+template <typename Handler>
+void client_connection::handle_errors(const MetaData &meta_proto, Handler &&handler)
+{
+    try
+    {
+        handler();
+    }
+    catch (ResponseContainer::StatusCode &error)
+    {
+        std::cout << "[ERROR] " << error << '\n';
+        respond_error(meta_proto, error);
+    }
+    catch (ErrorType &error)
+    {
+        std::cout << "[ERROR] " << error << '\n';
+        respond_error(meta_proto, error);
+    }
+    catch (graphs::ErrorMessage &error)
+    {
+        std::cout << "[ERROR] " << error.type() << '\n';
+        respond(meta_proto, meta_data{graphs::RequestType::ERROR}, error);
+    }
+    catch (std::exception &ex)
+    {
+        std::cout << "[ERROR] " << ex.what() << '\n';
+        respond_error(meta_proto, ResponseContainer::ERROR);
+    }
+}
+
+void client_connection::handle_request(boost::asio::yield_context &yield,
+                                       const MetaData &meta_proto,
+                                       const std::vector<char> &container)
+{
+    handle_errors(meta_proto, [&] {
+        handle_internal(yield, meta_proto, container);
+    });
+}
+
+user client_connection::authenticate(boost::asio::yield_context &yield,
+                                     const MetaData &meta_proto)
+{
+    auto &cache = user_cache::instance();
+    auto user = cache.find(meta_proto.user().name());
+    if (!user)
+    {
+        // The connection is returned before the password check, which may take a while
+        const auto generation = cache.generation();
+        user = database(yield).async_run(yield, [&](database_wrapper &db) {
+            return db.get_user(meta_proto.user().name());
+        });
+        if (user)
         {
-            // TODO: Log this incident
-            throw ErrorType::UNAUTHORIZED;
+            cache.insert(*user, generation);
         }
     }
-    else if (meta_proto.type() == RequestType::CREATE_USER)
+    if (!user || user->blocked)
     {
-        // Do not allow user creation if a existing user with the same name is found
-        ErrorMessage error;
-        error.set_type(ErrorType::USER_CREATION);
-        error.set_message("User already exists.");
-        throw error;
+        // TODO: Log this incident
+        throw ErrorType::UNAUTHORIZED;
     }
 
-    // Check login credentials
-    if (!auth_utils::check_password(meta_proto.user().password(), user->salt, user->pw_hash))
+    // Check login credentials. A valid session token avoids the expensive password hashing.
+    const bool has_valid_token = !meta_proto.sessiontoken().empty() &&
+                                 auth_utils::check_session_token(meta_proto.sessiontoken(), *user);
+    if (!has_valid_token && !auth_utils::async_check_password(yield, meta_proto.user().password(),
+                                                              user->salt, user->pw_hash))
     {
         // TODO: Log this incident
         throw ErrorType::UNAUTHORIZED;
     }
 
+    return *user;
+}
+
+void client_connection::handle_internal(boost::asio::yield_context &yield,
+                                        const MetaData &meta_proto,
+                                        const std::vector<char> &container)
+{
+    if (!compression::is_supported(meta_proto.compression()))
+    {
+        throw ResponseContainer::INVALID_REQUEST_ERROR;
+    }
+
+    if (meta_proto.type() == RequestType::CREATE_USER)
+    {
+        auto database = this->database(yield);
+        if (database.async_run(yield, [&](database_wrapper &db) {
+                return db.get_user(meta_proto.user().name()).has_value();
+            }))
+        {
+            // Do not allow user creation if a existing user with the same name is found
+            ErrorMessage error;
+            error.set_type(ErrorType::USER_CREATION);
+            error.set_message("User already exists.");
+            throw error;
+        }
+
+        auto [response_meta, response] = handle_user_creation(database, meta_proto, yield);
+        respond(meta_proto, response_meta, response);
+        return;
+    }
+
+    // User authentication
+    const auto user = authenticate(yield, meta_proto);
+
+    // Held until the request is handled. The handlers run on a database thread.
+    auto database = this->database(yield);
+
     // Reuquest handling
     switch (meta_proto.type())
     {
         case RequestType::AUTH: {
+            const std::chrono::seconds token_lifetime{
+                config()[config_options::SESSION_TOKEN_LIFETIME].as<int64_t>()};
+
+            meta_data response_meta{RequestType::AUTH};
+            response_meta.session_token = auth_utils::issue_session_token(user, token_lifetime);
+
             ResponseContainer response;
             response.set_status(ResponseContainer::OK);
-            respond(yield, meta_data{RequestType::AUTH}, response);
+            respond(meta_proto, response_meta, response);
             break;
         }
         case RequestType::AVAILABLE_HANDLERS: {
             auto [response_meta, response] = handle_available_handlers();
-            respond(yield, response_meta, response);
+            respond(meta_proto, response_meta, response);
             break;
         }
         case RequestType::STATUS: {
-            auto [response_meta, response] = handle_status(database, *user);
-            respond(yield, response_meta, response);
+            // Older clients send no container at all
+            const auto request = container.empty()
+                                     ? RequestContainer{}
+                                     : parse_container<RequestContainer>(meta_proto, container);
+
+            auto [response_meta, response] =
+                database.async_run(yield, [&](database_wrapper &db) {
+                    return handle_status(db, request, user);
+                });
+            respond(meta_proto, response_meta, response);
+            break;
+        }
+        case RequestType::SUBSCRIBE: {
+            // Status changes of the users jobs are pushed until the connection is closed, always
+            // on the strand of this connection. A second subscription replaces the first one.
+            m_subscription = job_subscriptions::instance().subscribe(
+                user.user_id, m_sock->get_executor(),
+                [this, request = meta_proto](const graphs::StatusSingle &status) {
+                    respond(request, meta_data{RequestType::SUBSCRIBE}, status);
+                });
+
+            // The current states are sent as a starting point for the pushed changes
+            auto [response_meta, response] =
+                database.async_run(yield, [&](database_wrapper &db) {
+                    return handle_status(db, RequestContainer{}, user);
+                });
+            response_meta.request_type = RequestType::SUBSCRIBE;
+            respond(meta_proto, response_meta, response);
             break;
         }
         case RequestType::RESULT: {
-            RequestContainer request =
-                read_message<RequestContainer>(yield, meta_proto.containersize());
+            const auto request = parse_container<RequestContainer>(meta_proto, container);
 
-            auto [response_meta, response] = handle_result(database, meta_proto, request, *user);
-            respond(yield, response_meta, response);
+            auto result = database.async_run(yield, [&](database_wrapper &db) {
+                return handle_result(db, meta_proto, request, user);
+            });
+            respond_stored(meta_proto, result.meta, std::move(result.response), result.status);
             break;
         }
         case RequestType::ABORT_JOB: {
-            RequestContainer request =
-                read_message<RequestContainer>(yield, meta_proto.containersize());
+            const auto request = parse_container<RequestContainer>(meta_proto, container);
 
-            auto [response_meta, response] = handle_abort_job(request, *user);
-            respond(yield, response_meta, response);
+            // Aborting writes the new status through the scheduler
+            auto [response_meta, response] = database.async_run(yield, [&](database_wrapper &) {
+                return handle_abort_job(request, user);
+            });
+            respond(meta_proto, response_meta, response);
             break;
         }
         case RequestType::DELETE_JOB: {
-            RequestContainer request =
-                read_message<RequestContainer>(yield, meta_proto.containersize());
+            const auto request = parse_container<RequestContainer>(meta_proto, container);
 
-            auto [response_meta, response] = handle_delete_job(database, request, *user);
-            respond(yield, response_meta, response);
+            auto [response_meta, response] =
+                database.async_run(yield, [&](database_wrapper &db) {
+                    return handle_delete_job(db, request, user);
+                });
+            respond(meta_proto, response_meta, response);
             break;
         }
         case RequestType::ORIGIN_GRAPH: {
-            RequestContainer request =
-                read_message<RequestContainer>(yield, meta_proto.containersize());
+            const auto request = parse_container<RequestContainer>(meta_proto, container);
 
-            auto [response_meta, response] = handle_origin_graph(database, request, *user);
-            respond(yield, response_meta, response);
+            auto [response_meta, response] =
+                database.async_run(yield, [&](database_wrapper &db) {
+                    return handle_origin_graph(db, request, user);
+                });
+            respond(meta_proto, response_meta, response);
             break;
         }
         default: {
-            std::vector<char> buffer;
-            buffer.resize(meta_proto.containersize());
-            if (!direct_read(yield, buffer.data(), buffer.size()))
+            // New jobs are received by receive_job()
+            throw ResponseContainer::INVALID_REQUEST_ERROR;
+        }
+    }
+}
+
+bool client_connection::receive_streamed(
+    boost::asio::yield_context &yield, const MetaData &meta_proto,
+    const std::function<void(const user &, const upload_reader &)> &receive)
+{
+    // Counts as a pending request, so the connection is not closed as idle during the upload
+    ++m_pending_requests;
+    const stopwatch watch;
+
+    // Only the upload buffer is held in memory, but that is needed for the whole upload
+    const auto reservation = memory_budget::instance().reserve(
+        yield, m_sock->get_executor(),
+        std::min<size_t>(meta_proto.containersize(), UPLOAD_BUFFER_SIZE));
+
+    socket_input_stream input{*m_sock, yield, meta_proto.containersize(), m_read_deadline,
+                              [this] {
+                                  start_read_deadline();
+                              }};
+
+    // Reads are only timed individually, a client trickling data must not keep the upload open
+    // for good
+    start_upload_deadline();
+    handle_errors(meta_proto, [&] {
+        if (!compression::is_supported(meta_proto.compression()))
+        {
+            throw ResponseContainer::INVALID_REQUEST_ERROR;
+        }
+
+        const auto user = authenticate(yield, meta_proto);
+        const auto upload_limit = static_cast<size_t>(std::max<int64_t>(
+            user.upload_limit.value_or(config()[config_options::UPLOAD_LIMIT].as<int64_t>()), 0));
+
+        ErrorMessage limit_error;
+        limit_error.set_type(ErrorType::UPLOAD_LIMIT);
+        limit_error.set_message("Upload limit of " + std::to_string(upload_limit) +
+                                " bytes exceeded.");
+
+        // Uncompressed data can be rejected before reading it
+        if (meta_proto.compression() == graphs::CompressionType::NONE &&
+            meta_proto.containersize() > upload_limit)
+        {
+            throw limit_error;
+        }
+
+        receive(user, [&](const upload_consumer &consumer) {
+            size_t received = 0;
+            bool limit_exceeded = false;
+            const bool success = compression::decompress(
+                meta_proto.compression(), input, [&](const char *data, size_t size) {
+                    if (received + size > upload_limit)
+                    {
+                        limit_exceeded = true;
+                        return false;
+                    }
+                    received += size;
+                    consumer(data, size);
+                    return true;
+                });
+
+            m_upload_deadline.cancel();
+            if (input.failed())
+            {
+                // Nobody to respond to
+                return false;
+            }
+            if (limit_exceeded)
+            {
+                throw limit_error;
+            }
+            if (!success)
             {
                 throw ResponseContainer::READ_ERROR;
             }
+            return true;
+        });
+    });
+    m_upload_deadline.cancel();
 
-            auto [response_meta, response] = handle_new_job(database, meta_proto, buffer, *user);
-            respond(yield, response_meta, response);
-            break;
-        }
+    --m_pending_requests;
+    m_writer_signal.cancel();
+    watch.record(request_duration(meta_proto.type()));
+
+    // Draining a rejected upload is only worth it up to the size of a regular request, larger
+    // ones close the connection instead
+    if (input.remaining() > config()[config_options::REQUEST_SIZE_LIMIT].as<size_t>())
+    {
+        return false;
     }
+    return input.skip_remaining();
 }
 
-template <typename MESSAGE_TYPE>
-MESSAGE_TYPE client_connection::read_message(boost::asio::yield_context &yield, size_t len)
+bool client_connection::receive_job(boost::asio::yield_context &yield,
+                                    const MetaData &meta_proto)
 {
+    tracing::trace job_trace{tracing::instance().new_trace(), tracing::clock::now(), {}};
+
+    return receive_streamed(yield, meta_proto, [&](const user &user, const upload_reader &read) {
+        // Decompressed chunks are spooled as they arrive, the request is never held in memory as
+        // a whole. A database connection is only taken to commit the upload.
+        job_upload upload{user.user_id, meta_data{meta_proto.type(), meta_proto.handlertype(),
+                                                  meta_proto.jobname()}};
+        if (!read([&](const char *data, size_t size) {
+                upload.append(yield, data, size);
+            }))
+        {
+            return;
+        }
+
+        // Handed to the scheduler before committing, which makes the job visible to it. Spans of
+        // a trace must nest, so receiving ends where waiting for the scheduler begins. The span
+        // of the whole job is ended by the scheduler.
+        const auto submit_trace = [&job_trace, &user](int job_id) {
+            auto &traces = tracing::instance();
+            job_trace.submitted = tracing::clock::now();
+            job_trace.user_id = user.user_id;
+            traces.begin(job_trace.id, "job", job_trace.start, {{"job_id", job_id}});
+            traces.record(job_trace.id, "receive", job_trace.start, job_trace.submitted);
+            traces.submitted(job_id, job_trace);
+        };
+
+        auto [response_meta, response] =
+            handle_new_job(upload, database(yield), yield, submit_trace);
+        respond(meta_proto, response_meta, response);
+    });
+}
+
+bool client_connection::receive_graph(boost::asio::yield_context &yield,
+                                      const MetaData &meta_proto)
+{
+    return receive_streamed(yield, meta_proto, [&](const user &user, const upload_reader &read) {
+        // The decompressed container is spooled, only the graph within it is stored
+        upload_spool spool;
+        binary_data buffer;
+        buffer.reserve(GRAPH_SPOOL_BUFFER_SIZE);
+        const auto flush = [&] {
+            upload_spool::threads().async_run(yield, [&]() {
+                spool.write(buffer);
+            });
+            buffer.clear();
+        };
+
+        if (!read([&](const char *data, size_t size) {
+                buffer.append(reinterpret_cast<const std::byte *>(data), size);
+                if (buffer.size() >= GRAPH_SPOOL_BUFFER_SIZE)
+                {
+                    flush();
+                }
+            }))
+        {
+            return;
+        }
+        flush();
+
+        // Scanning and hashing the graph takes a while for large graphs, so it is done before
+        // taking a database connection
+        const auto container = spool.map();
+        const auto graph = upload_spool::threads().async_run(yield, [&]() {
+            return read_uploaded_graph(container.view());
+        });
+
+        auto [response_meta, response] =
+            database(yield).async_run(yield, [&](database_wrapper &db) {
+                return handle_upload_graph(db, graph, user);
+            });
+        respond(meta_proto, response_meta, response);
+    });
+}
+
+MetaData client_connection::read_meta_data(boost::asio::yield_context &yield, size_t len)
+{
+    if (len > META_SIZE_LIMIT)
+    {
+        // Not worth reading, a valid frame never has meta data this large
+        throw ResponseContainer::INVALID_REQUEST_ERROR;
+    }
+
     std::vector<char> recv_buffer(len);
     if (!direct_read(yield, recv_buffer.data(), recv_buffer.size()))
     {
         throw ResponseContainer::READ_ERROR;
     }
 
-    if constexpr (!std::is_same_v<MESSAGE_TYPE, MetaData>)
+    MetaData msg;
+    if (!msg.ParseFromArray(recv_buffer.data(), recv_buffer.size()))
     {
-        // Other messages are compressed using GZIP compression
-        namespace io = boost::iostreams;
-
-        io::filtering_streambuf<io::input> in_str_buf;
-        in_str_buf.push(io::gzip_decompressor{});
-        in_str_buf.push(io::array_source{recv_buffer.data(), recv_buffer.size()});
-        recv_buffer.assign(std::istreambuf_iterator<char>{&in_str_buf}, {});
+        throw ResponseContainer::PROTO_PARSING_ERROR;
     }
+    return msg;
+}
 
+template <typename MESSAGE_TYPE>
+MESSAGE_TYPE client_connection::parse_container(const MetaData &meta_proto,
+                                                const std::vector<char> &container)
+{
+    // Decompression is done while parsing, without an intermediate buffer
     MESSAGE_TYPE msg;
-    if (!msg.ParseFromArray(recv_buffer.data(), recv_buffer.size()))
+    if (!compression::parse(meta_proto.compression(), container.data(), container.size(), msg))
     {
         throw ResponseContainer::PROTO_PARSING_ERROR;
     }
@@ -236,125 +908,202 @@ MESSAGE_TYPE client_connection::read_message(boost::asio::yield_context &yield,
 }
 
 template <class Serializable>
-void client_connection::respond(boost::asio::yield_context &yield, const meta_data &meta_info,
+void client_connection::respond(const MetaData &request, const meta_data &meta_info,
                                 const Serializable &message)
 {
-    namespace io = boost::iostreams;
+    MetaData meta_proto = build_response_meta(request, meta_info);
 
-    MetaData meta_proto;
-    meta_proto.set_type(meta_info.request_type);
-    meta_proto.set_handlertype(meta_info.handler_type);
-    meta_proto.set_jobname(meta_info.job_name);
-    std::vector<char> message_data;
+    outgoing_frame frame;
+    compression::serialize(meta_proto.compression(), message, frame.container);
 
-    {
-        // Generate uncompressed buffer from protobuf message
-        std::vector<char> uncompressed;
-        uncompressed.resize(message.ByteSizeLong());
-        message.SerializeToArray(uncompressed.data(), uncompressed.size());
+    enqueue_response(meta_proto, std::move(frame));
+}
 
-        // Boost gzip compression
-        io::filtering_streambuf<io::input> in_str_buf;
-        in_str_buf.push(io::gzip_compressor{});
-        in_str_buf.push(io::array_source{uncompressed.data(), uncompressed.size()});
+void client_connection::respond_stored(const MetaData &request, const meta_data &meta_info,
+                                       compressed_data stored,
+                                       const ResponseContainer &appended)
+{
+    MetaData meta_proto = build_response_meta(request, meta_info);
 
-        // Copy compressed data into the compressed buffer
-        std::copy(std::istreambuf_iterator<char>{&in_str_buf}, {},
-                  std::back_inserter(message_data));
-        meta_proto.set_containersize(message_data.size());
+    outgoing_frame frame;
+    const auto data = stored.view();
+    if (stored.compression == meta_proto.compression())
+    {
+        // Blobs stay mapped until the frame is sent
+        if (stored.blob)
+        {
+            frame.stored_blob = std::move(stored.blob);
+        }
+        else
+        {
+            frame.stored_part = std::move(stored.binary);
+        }
+    }
+    else if (stored.compression == graphs::CompressionType::NONE)
+    {
+        compression::compress(meta_proto.compression(), reinterpret_cast<const char *>(data.data()),
+                              data.size(), frame.container);
+    }
+    else
+    {
+        // Only recompress if the client asked for another codec than the stored one
+        std::vector<char> uncompressed;
+        if (!compression::decompress(stored.compression,
+                                     reinterpret_cast<const char *>(data.data()), data.size(),
+                                     uncompressed))
+        {
+            throw ResponseContainer::ERROR;
+        }
+        compression::compress(meta_proto.compression(), uncompressed.data(), uncompressed.size(),
+                              frame.container);
     }
 
-    uint64_t len = boost::endian::native_to_big(meta_proto.ByteSizeLong());
+    // Sent as a separate gzip member or zstd frame. Decompressing the whole container yields the
+    // concatenated serializations, which protobuf parses as merged messages.
+    compression::serialize(meta_proto.compression(), appended, frame.container);
 
-    std::vector<char> meta_data;
-    meta_data.resize(meta_proto.GetCachedSize());
-    meta_proto.SerializeToArray(meta_data.data(), meta_data.size());
+    enqueue_response(meta_proto, std::move(frame));
+}
 
-    // Send data to client
-    direct_write(yield, reinterpret_cast<const char *>(&len), LENGTH_FIELD_SIZE);
-    direct_write(yield, meta_data.data(), meta_data.size());
-    direct_write(yield, message_data.data(), message_data.size());
+void client_connection::respond_error(const MetaData &request, ResponseContainer::StatusCode code)
+{
+    ResponseContainer response;
+    response.set_status(code);
+    respond(request, meta_data{RequestType::ERROR}, response);
 }
 
-void client_connection::respond(boost::asio::yield_context &yield, const meta_data &meta_info,
-                                const binary_data &binary)
+void client_connection::respond_error(const MetaData &request, ErrorType error_type)
 {
-    namespace io = boost::iostreams;
+    ErrorMessage msg;
+    msg.set_type(error_type);
+    respond(request, meta_data{RequestType::ERROR}, msg);
+}
 
+MetaData client_connection::build_response_meta(const MetaData &request,
+                                                const meta_data &meta_info)
+{
     MetaData meta_proto;
     meta_proto.set_type(meta_info.request_type);
     meta_proto.set_handlertype(meta_info.handler_type);
     meta_proto.set_jobname(meta_info.job_name);
-    std::vector<char> container_data;
-
-    {
-        std::vector<char> uncompressed(
-            reinterpret_cast<const char *>(binary.data()),
-            reinterpret_cast<const char *>(binary.data() + binary.size()));
-
-        // Boost gzip compression
-        io::filtering_streambuf<io::input> in_str_buf;
-        in_str_buf.push(io::gzip_compressor{});
-        in_str_buf.push(io::array_source{uncompressed.data(), uncompressed.size()});
+    meta_proto.set_sessiontoken(meta_info.session_token);
+    meta_proto.set_requestid(request.requestid());
 
-        // Copy compressed data into the compressed buffer
-        std::copy(std::istreambuf_iterator<char>{&in_str_buf}, {},
-                  std::back_inserter(container_data));
-        meta_proto.set_containersize(container_data.size());
-    }
-
-    uint64_t len = boost::endian::native_to_big(meta_proto.ByteSizeLong());
-
-    std::vector<char> meta_data;
-    meta_data.resize(meta_proto.GetCachedSize());
-    meta_proto.SerializeToArray(meta_data.data(), meta_data.size());
-
-    // Send data to client
-    direct_write(yield, reinterpret_cast<const char *>(&len), LENGTH_FIELD_SIZE);
-    direct_write(yield, meta_data.data(), meta_data.size());
-    direct_write(yield, container_data.data(), container_data.size());
+    // Respond with the codec of the request, fall back to gzip if it is not supported
+    meta_proto.set_compression(compression::is_supported(request.compression())
+                                   ? request.compression()
+                                   : graphs::CompressionType::GZIP);
+    return meta_proto;
 }
 
-void client_connection::respond_error(boost::asio::yield_context &yield,
-                                      ResponseContainer::StatusCode code)
+void client_connection::enqueue_response(MetaData &meta_proto, outgoing_frame frame)
 {
-    ResponseContainer response;
-    response.set_status(code);
-    respond(yield, meta_data{RequestType::ERROR}, response);
-}
+    meta_proto.set_containersize(frame.stored_size() + frame.container.size());
+    const size_t meta_size = meta_proto.ByteSizeLong();
+    const uint64_t len = boost::endian::native_to_big(static_cast<uint64_t>(meta_size));
 
-void client_connection::respond_error(boost::asio::yield_context &yield, ErrorType error_type)
-{
-    ErrorMessage msg;
-    msg.set_type(error_type);
-    respond(yield, meta_data{RequestType::ERROR}, msg);
+    // Length field and meta data are sent in front of the container
+    frame.header.resize(LENGTH_FIELD_SIZE + meta_size);
+    std::memcpy(frame.header.data(), &len, LENGTH_FIELD_SIZE);
+    meta_proto.SerializeWithCachedSizesToArray(
+        reinterpret_cast<uint8_t *>(frame.header.data() + LENGTH_FIELD_SIZE));
+
+    m_outbox.push_back(std::move(frame));
+    m_writer_signal.cancel();
 }
 
 bool client_connection::direct_read(boost::asio::yield_context &yield, char *const data,
                                     size_t length)
 {
     error_code error;
-    async_read(*m_sock, buffer(data, length), transfer_exactly(length), yield[error]);
-    if (error)
+    received_bytes().add(
+        async_read(*m_sock, buffer(data, length), transfer_exactly(length), yield[error]));
+    // End of file is the regular end of a persistent connection
+    if (error && error != boost::asio::error::eof)
         std::cout << "[CONNECTION] Read error: " << error << '\n';
     return !error;
 }
 
-void client_connection::direct_write(boost::asio::yield_context &yield, const char *data,
-                                     size_t length)
+bool client_connection::write_frame(boost::asio::yield_context &yield,
+                                    const outgoing_frame &frame)
 {
-    do
+    error_code error;
+    size_t bytes_sent = 0;
+    if (frame.stored_blob && file_socket())
     {
-        error_code error;
-        size_t bytes_sent = async_write(*m_sock, buffer(data, length), yield[error]);
+        // Blobs are sent from the page cache, unless they would have to be encrypted here
+        bytes_sent += async_write(*m_sock, buffer(frame.header), yield[error]);
+        if (!error)
+        {
+            bytes_sent += send_file(yield, *frame.stored_blob, error);
+        }
         if (!error)
         {
-            data += bytes_sent;
-            length -= bytes_sent;
+            bytes_sent += async_write(*m_sock, buffer(frame.container), yield[error]);
+        }
+    }
+    else
+    {
+        // Gather write, the container parts are sent from where they were compressed into
+        const binary_data_view stored =
+            frame.stored_blob ? frame.stored_blob->view() : binary_data_view{frame.stored_part};
+        const std::array<boost::asio::const_buffer, 3> buffers{
+            buffer(frame.header), buffer(stored.data(), stored.size()), buffer(frame.container)};
+
+        bytes_sent = async_write(*m_sock, buffers, yield[error]);
+    }
+
+    sent_bytes().add(bytes_sent);
+    if (error)
+    {
+        std::cout << "[CONNECTION] Write error: " << error << '\n';
+        return false;
+    }
+
+    std::cout << "[CONNECTION] Sent " << bytes_sent << " bytes" << std::endl;
+    return true;
+}
+
+tcp::socket *client_connection::file_socket()
+{
+#ifndef SPANNERS_UNENCRYPTED_CONNECTION
+    return m_sock->kernel_tls_send() ? &m_sock->next_layer() : nullptr;
+#else
+    return m_sock.get();
+#endif
+}
+
+size_t client_connection::send_file(boost::asio::yield_context &yield, const mapped_blob &blob,
+                                    error_code &error)
+{
+    tcp::socket &socket = *file_socket();
+    socket.non_blocking(true, error);
+
+    off_t offset = 0;
+    while (!error && static_cast<size_t>(offset) < blob.size())
+    {
+        const ssize_t sent = ::sendfile(socket.native_handle(), blob.fd(), &offset,
+                                        blob.size() - static_cast<size_t>(offset));
+        if (sent > 0)
+        {
+            continue;
+        }
 
-            std::cout << "[CONNECTION] Sent " << bytes_sent << " bytes" << std::endl;
+        if (sent == 0)
+        {
+            // The file was truncated
+            error = boost::asio::error::eof;
         }
-    } while (length > 0);
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            socket.async_wait(tcp::socket::wait_write, yield[error]);
+        }
+        else if (errno != EINTR)
+        {
+            error = error_code{errno, boost::system::system_category()};
+        }
+    }
+    return static_cast<size_t>(offset);
 }
 
 }  // namespace server
@@ -1,9 +1,11 @@
 #include <networking/io/client_server.hpp>
 
 #include <boost/asio/spawn.hpp>
-#include <chrono>
+#include <boost/asio/strand.hpp>
 #include <iostream>
 
+#include <config/config.hpp>
+#include <handling/handler_utilities.hpp>
 #include <networking/io/client_connection.hpp>
 
 namespace server {
@@ -13,30 +15,68 @@ using boost::asio::ssl::stream;
 using boost::system::error_code;
 
 #ifdef SPANNERS_UNENCRYPTED_CONNECTION
-client_server::client_server(unsigned short listening_port)
-    : io_server{}
+client_server::client_server(unsigned short listening_port, size_t nof_threads)
+    : io_server{nof_threads}
     , m_acceptor{m_ctx, tcp::endpoint{tcp::v6(), listening_port}}
     , m_connections{}
+    , m_accept_signal{boost::asio::make_strand(m_ctx)}
+    , m_connection_limiter{config()[config_options::CONNECTION_RATE_LIMIT].as<double>(),
+                           config()[config_options::CONNECTION_RATE_LIMIT].as<double>()}
+    , m_request_limiter{config()[config_options::REQUEST_RATE_LIMIT].as<double>(),
+                        config()[config_options::REQUEST_RATE_LIMIT].as<double>()}
 {
+    // Wake up the accept loop if it waits for a free connection slot
+    m_connections.on_remove([this] {
+        boost::asio::post(m_accept_signal.get_executor(), [this] {
+            m_accept_signal.cancel();
+        });
+    });
+
+    // Register all handlers before connections are served concurrently
+    handler_utilities::init_handlers();
 }
 #else
 client_server::client_server(unsigned short listening_port, const std::string &cert_path,
-                             const std::string &key_path)
-    : io_server{}
+                             const std::string &key_path, size_t nof_threads)
+    : io_server{nof_threads}
     , m_ssl_ctx{boost::asio::ssl::context::tls}
     , m_acceptor{m_ctx, tcp::endpoint{tcp::v6(), listening_port}}
     , m_connections{}
+    , m_accept_signal{boost::asio::make_strand(m_ctx)}
+    , m_connection_limiter{config()[config_options::CONNECTION_RATE_LIMIT].as<double>(),
+                           config()[config_options::CONNECTION_RATE_LIMIT].as<double>()}
+    , m_request_limiter{config()[config_options::REQUEST_RATE_LIMIT].as<double>(),
+                        config()[config_options::REQUEST_RATE_LIMIT].as<double>()}
 {
+    // Wake up the accept loop if it waits for a free connection slot
+    m_connections.on_remove([this] {
+        boost::asio::post(m_accept_signal.get_executor(), [this] {
+            m_accept_signal.cancel();
+        });
+    });
+
     // Configure ssl context
     m_ssl_ctx.set_options(boost::asio::ssl::context::default_workarounds);
     m_ssl_ctx.use_certificate_chain_file(cert_path);
     m_ssl_ctx.use_private_key_file(key_path, boost::asio::ssl::context::pem);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    // OpenSSL falls back to encrypting in user space if the kernel does not support kTLS
+    if (config()[config_options::TLS_KERNEL_OFFLOAD].as<bool>())
+    {
+        m_ssl_ctx.set_options(SSL_OP_ENABLE_KTLS);
+    }
+#endif
+
+    // Register all handlers before connections are served concurrently
+    handler_utilities::init_handlers();
 }
 #endif
 
 void client_server::handle()
 {
-    boost::asio::spawn(m_ctx, [this](boost::asio::yield_context yield) {
+    // Runs on the strand of m_accept_signal, so removed connections can signal it
+    boost::asio::spawn(m_accept_signal.get_executor(), [this](boost::asio::yield_context yield) {
 #ifdef SPANNERS_UNENCRYPTED_CONNECTION
         std::cout << "[INFO] Listening for unencrypted connections from clients on "
                   << m_acceptor.local_endpoint().port() << '\n';
@@ -45,37 +85,55 @@ void client_server::handle()
                   << m_acceptor.local_endpoint().port() << '\n';
 #endif
 
+        const auto connection_limit = config()[config_options::CONNECTION_LIMIT].as<size_t>();
+
         while (m_status == RUNNING)
         {
+            // Backpressure, further clients wait in the listen backlog until a connection ends
+            while (connection_limit > 0 && m_connections.size() >= connection_limit)
+            {
+                error_code error;
+                m_accept_signal.expires_at(boost::asio::steady_timer::time_point::max());
+                m_accept_signal.async_wait(yield[error]);
+            }
+
+            // Every connection gets its own strand so its handlers never run concurrently
 #ifndef SPANNERS_UNENCRYPTED_CONNECTION
             client_connection::socket_ptr sock =
-                std::make_unique<boost::asio::ssl::stream<boost::asio::ip::tcp::socket>>(m_ctx,
-                                                                                         m_ssl_ctx);
+                std::make_unique<tls_stream>(boost::asio::make_strand(m_ctx), m_ssl_ctx);
             error_code err;
             m_acceptor.async_accept(sock->next_layer(), yield[err]);
 #else
             client_connection::socket_ptr sock =
-                std::make_unique<boost::asio::ip::tcp::socket>(m_ctx);
+                std::make_unique<boost::asio::ip::tcp::socket>(boost::asio::make_strand(m_ctx));
             error_code err;
             m_acceptor.async_accept(*sock, yield[err]);
 #endif
 
-            if (!err)
+            if (err)
+            {
+                continue;
+            }
+
+            const auto source = sock->lowest_layer().remote_endpoint(err).address();
+            if (err)
+            {
+                // Already disconnected
+                sock->lowest_layer().close(err);
+                continue;
+            }
+            if (!m_connection_limiter.try_acquire(source))
             {
-                using namespace std::chrono;
-                size_t id =
-                    duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-                try
-                {
-                    m_connections.add(id, std::make_unique<client_connection>(id, m_connections,
-                                                                              std::move(sock)));
-                }
-                catch (std::runtime_error &err)
-                {
-                    std::cout << "[ERROR] Connection to client failed: " << err.what() << '\n';
-                    // No error handling needed. Just catch the failed connection establishment
-                }
+                std::cout << "[CONNECTION] Rejected connection from " << source
+                          << ", connection rate limit exceeded\n";
+                sock->lowest_layer().close(err);
+                continue;
             }
+
+            const size_t id = m_next_connection_id++;
+            m_connections.add(id, std::make_unique<client_connection>(
+                                      id, m_connections, std::move(sock), source,
+                                      m_request_limiter));
         }
     });
 }
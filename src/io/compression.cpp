@@ -0,0 +1,437 @@
+#include <networking/io/compression.hpp>
+
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#ifdef SPANNERS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+using google::protobuf::io::ArrayInputStream;
+using google::protobuf::io::GzipInputStream;
+using google::protobuf::io::GzipOutputStream;
+using google::protobuf::io::ZeroCopyInputStream;
+using google::protobuf::io::ZeroCopyOutputStream;
+
+namespace server {
+
+namespace compression {
+
+    namespace {
+        constexpr const size_t MIN_CHUNK_SIZE = 4096;
+        constexpr const size_t MAX_CHUNK_SIZE = 1 << 22;  // 4 MB
+
+        /// Gzip level 1 compresses roughly three times faster than the default level 6, while
+        /// the generated graph data hardly compresses any better at higher levels
+        constexpr const int GZIP_LEVEL = 1;
+
+        /**
+         * @brief ZeroCopyOutputStream appending to a std::vector. Every chunk handed out doubles
+         *        the size of the vector, up to a maximum chunk size.
+         */
+        class vector_output_stream final : public ZeroCopyOutputStream
+        {
+        public:
+            explicit vector_output_stream(std::vector<char> &out)
+                : m_out{out}
+                , m_initial_size{out.size()}
+            {
+            }
+
+            bool Next(void **data, int *size) override
+            {
+                const size_t old_size = m_out.size();
+                const size_t chunk_size =
+                    std::clamp(old_size - m_initial_size, MIN_CHUNK_SIZE, MAX_CHUNK_SIZE);
+
+                m_out.resize(old_size + chunk_size);
+                *data = m_out.data() + old_size;
+                *size = static_cast<int>(chunk_size);
+                return true;
+            }
+
+            void BackUp(int count) override
+            {
+                m_out.resize(m_out.size() - count);
+            }
+
+            int64_t ByteCount() const override
+            {
+                return static_cast<int64_t>(m_out.size() - m_initial_size);
+            }
+
+        private:
+            std::vector<char> &m_out;
+            const size_t m_initial_size;
+        };
+
+#ifdef SPANNERS_WITH_ZSTD
+        constexpr const int ZSTD_LEVEL = 3;
+
+        /**
+         * @brief ZeroCopyInputStream decompressing zstd frames read from another stream
+         */
+        class zstd_input_stream final : public ZeroCopyInputStream
+        {
+        public:
+            explicit zstd_input_stream(ZeroCopyInputStream &source)
+                : m_ctx{ZSTD_createDCtx()}
+                , m_source{source}
+                , m_buffer(ZSTD_DStreamOutSize())
+            {
+            }
+
+            ~zstd_input_stream() override
+            {
+                ZSTD_freeDCtx(m_ctx);
+            }
+
+            bool Next(const void **data, int *size) override
+            {
+                if (m_backed_up > 0)
+                {
+                    *data = m_buffer.data() + m_chunk_size - m_backed_up;
+                    *size = m_backed_up;
+                    m_byte_count += m_backed_up;
+                    m_backed_up = 0;
+                    return true;
+                }
+
+                ZSTD_outBuffer out{m_buffer.data(), m_buffer.size(), 0};
+                while (out.pos == 0)
+                {
+                    if (m_in.pos == m_in.size)
+                    {
+                        const void *source_data;
+                        int source_size;
+                        if (m_source.Next(&source_data, &source_size))
+                        {
+                            m_in = ZSTD_inBuffer{source_data, static_cast<size_t>(source_size), 0};
+                        }
+                    }
+
+                    // Also called with exhausted input, since zstd may still hold buffered output
+                    const size_t input_pos = m_in.pos;
+                    const size_t result = ZSTD_decompressStream(m_ctx, &out, &m_in);
+                    if (ZSTD_isError(result))
+                    {
+                        m_ok = false;
+                        return false;
+                    }
+                    if (out.pos == 0 && m_in.pos == input_pos)
+                    {
+                        // No progress anymore, the data is truncated if the frame did not end
+                        m_ok = m_frame_finished;
+                        return false;
+                    }
+                    m_frame_finished = (result == 0);
+                }
+
+                m_chunk_size = static_cast<int>(out.pos);
+                *data = m_buffer.data();
+                *size = m_chunk_size;
+                m_byte_count += m_chunk_size;
+                return true;
+            }
+
+            void BackUp(int count) override
+            {
+                m_backed_up = count;
+                m_byte_count -= count;
+            }
+
+            bool Skip(int count) override
+            {
+                const void *data;
+                int size;
+                while (count > 0 && Next(&data, &size))
+                {
+                    if (size > count)
+                    {
+                        BackUp(size - count);
+                        return true;
+                    }
+                    count -= size;
+                }
+                return count == 0;
+            }
+
+            int64_t ByteCount() const override
+            {
+                return m_byte_count;
+            }
+
+            bool ok() const
+            {
+                return m_ok;
+            }
+
+        private:
+            ZSTD_DCtx *const m_ctx;
+            ZeroCopyInputStream &m_source;
+            ZSTD_inBuffer m_in{nullptr, 0, 0};
+            std::vector<char> m_buffer;
+            int m_chunk_size{};
+            int m_backed_up{};
+            int64_t m_byte_count{};
+            bool m_frame_finished{false};
+            bool m_ok{true};
+        };
+
+        /**
+         * @brief ZeroCopyOutputStream compressing into a zstd frame appended to a std::vector
+         */
+        class zstd_output_stream final : public ZeroCopyOutputStream
+        {
+        public:
+            explicit zstd_output_stream(std::vector<char> &out)
+                : m_ctx{ZSTD_createCCtx()}
+                , m_out{out}
+                , m_buffer(ZSTD_CStreamInSize())
+            {
+                ZSTD_CCtx_setParameter(m_ctx, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+            }
+
+            ~zstd_output_stream() override
+            {
+                ZSTD_freeCCtx(m_ctx);
+            }
+
+            bool Next(void **data, int *size) override
+            {
+                if (!compress_pending(ZSTD_e_continue))
+                {
+                    return false;
+                }
+
+                m_pending = m_buffer.size();
+                m_byte_count += m_pending;
+                *data = m_buffer.data();
+                *size = static_cast<int>(m_pending);
+                return true;
+            }
+
+            void BackUp(int count) override
+            {
+                m_pending -= count;
+                m_byte_count -= count;
+            }
+
+            int64_t ByteCount() const override
+            {
+                return m_byte_count;
+            }
+
+            /// Finishes the zstd frame
+            bool Close()
+            {
+                return compress_pending(ZSTD_e_end);
+            }
+
+        private:
+            bool compress_pending(ZSTD_EndDirective mode)
+            {
+                ZSTD_inBuffer in{m_buffer.data(), m_pending, 0};
+                size_t remaining;
+                do
+                {
+                    const size_t old_size = m_out.size();
+                    m_out.resize(old_size + ZSTD_CStreamOutSize());
+
+                    ZSTD_outBuffer out{m_out.data() + old_size, ZSTD_CStreamOutSize(), 0};
+                    remaining = ZSTD_compressStream2(m_ctx, &out, &in, mode);
+                    m_out.resize(old_size + out.pos);
+
+                    if (ZSTD_isError(remaining))
+                    {
+                        return false;
+                    }
+                } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+
+                m_pending = 0;
+                return true;
+            }
+
+            ZSTD_CCtx *const m_ctx;
+            std::vector<char> &m_out;
+            std::vector<char> m_buffer;
+            size_t m_pending{};
+            int64_t m_byte_count{};
+        };
+#endif
+
+        /// Runs function with a stream decompressing the data read from source
+        template <typename Function>
+        bool with_input_stream(codec type, ZeroCopyInputStream &source, Function &&function)
+        {
+            switch (type)
+            {
+                case codec::NONE:
+                    return function(source);
+                case codec::GZIP: {
+                    GzipInputStream gzip_stream{&source, GzipInputStream::GZIP};
+                    return function(gzip_stream) && gzip_stream.ZlibErrorCode() >= 0;
+                }
+#ifdef SPANNERS_WITH_ZSTD
+                case codec::ZSTD: {
+                    zstd_input_stream zstd_stream{source};
+                    return function(zstd_stream) && zstd_stream.ok();
+                }
+#endif
+                default:
+                    return false;
+            }
+        }
+
+        /// Runs function with a stream decompressing the given data
+        template <typename Function>
+        bool with_input_stream(codec type, const char *data, size_t size, Function &&function)
+        {
+            if (size > static_cast<size_t>(std::numeric_limits<int>::max()))
+            {
+                return false;
+            }
+            ArrayInputStream array_stream{data, static_cast<int>(size)};
+
+            return with_input_stream(type, array_stream, std::forward<Function>(function));
+        }
+
+        /// Runs function with a stream compressing into out
+        template <typename Function>
+        void with_output_stream(codec type, std::vector<char> &out, Function &&function)
+        {
+            switch (type)
+            {
+                case codec::NONE: {
+                    vector_output_stream vector_stream{out};
+                    function(vector_stream);
+                    break;
+                }
+                case codec::GZIP: {
+                    vector_output_stream vector_stream{out};
+                    GzipOutputStream::Options options;
+                    options.format = GzipOutputStream::GZIP;
+                    options.compression_level = GZIP_LEVEL;
+
+                    GzipOutputStream gzip_stream{&vector_stream, options};
+                    function(gzip_stream);
+                    if (!gzip_stream.Close())
+                    {
+                        throw std::runtime_error("Gzip compression failed");
+                    }
+                    break;
+                }
+#ifdef SPANNERS_WITH_ZSTD
+                case codec::ZSTD: {
+                    zstd_output_stream zstd_stream{out};
+                    function(zstd_stream);
+                    if (!zstd_stream.Close())
+                    {
+                        throw std::runtime_error("Zstd compression failed");
+                    }
+                    break;
+                }
+#endif
+                default:
+                    throw std::invalid_argument("Unsupported compression codec");
+            }
+        }
+    }  // namespace
+
+    bool is_supported(codec type)
+    {
+        switch (type)
+        {
+            case codec::NONE:
+            case codec::GZIP:
+                return true;
+#ifdef SPANNERS_WITH_ZSTD
+            case codec::ZSTD:
+                return true;
+#endif
+            default:
+                return false;
+        }
+    }
+
+    bool parse(codec type, const char *data, size_t size, google::protobuf::MessageLite &message)
+    {
+        return with_input_stream(type, data, size, [&message](ZeroCopyInputStream &in) {
+            return message.ParseFromZeroCopyStream(&in);
+        });
+    }
+
+    void serialize(codec type, const google::protobuf::MessageLite &message,
+                   std::vector<char> &out)
+    {
+        with_output_stream(type, out, [&message](ZeroCopyOutputStream &os) {
+            if (!message.SerializeToZeroCopyStream(&os))
+            {
+                throw std::runtime_error("Serialization failed");
+            }
+        });
+    }
+
+    void compress(codec type, const char *data, size_t size, std::vector<char> &out)
+    {
+        with_output_stream(type, out, [data, size](ZeroCopyOutputStream &os) mutable {
+            void *chunk;
+            int chunk_size;
+            while (size > 0 && os.Next(&chunk, &chunk_size))
+            {
+                const size_t copied = std::min(size, static_cast<size_t>(chunk_size));
+                std::memcpy(chunk, data, copied);
+                if (copied < static_cast<size_t>(chunk_size))
+                {
+                    os.BackUp(chunk_size - static_cast<int>(copied));
+                }
+                data += copied;
+                size -= copied;
+            }
+        });
+    }
+
+    bool decompress(codec type, const char *data, size_t size, std::vector<char> &out)
+    {
+        return with_input_stream(type, data, size, [&out](ZeroCopyInputStream &in) {
+            const void *chunk;
+            int chunk_size;
+            while (in.Next(&chunk, &chunk_size))
+            {
+                const char *const begin = static_cast<const char *>(chunk);
+                out.insert(out.end(), begin, begin + chunk_size);
+            }
+            return true;
+        });
+    }
+
+    bool with_decompressed(codec type, const char *data, size_t size,
+                           const std::function<bool(ZeroCopyInputStream &)> &reader)
+    {
+        return with_input_stream(type, data, size, reader);
+    }
+
+    bool decompress(codec type, ZeroCopyInputStream &compressed,
+                    const std::function<bool(const char *, size_t)> &consumer)
+    {
+        return with_input_stream(type, compressed, [&consumer](ZeroCopyInputStream &in) {
+            const void *chunk;
+            int chunk_size;
+            while (in.Next(&chunk, &chunk_size))
+            {
+                if (!consumer(static_cast<const char *>(chunk), chunk_size))
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+}  // namespace compression
+
+}  // namespace server
@@ -1,16 +1,20 @@
 #include <networking/io/io_server.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 namespace server {
 
+io_server::io_server(size_t nof_threads)
+    : m_nof_threads{std::max(nof_threads, size_t{1})}
+    , m_ctx{static_cast<int>(m_nof_threads)}
+{
+}
+
 io_server::~io_server()
 {
     m_ctx.stop();
-    if (m_future.valid())
-    {
-        m_future.get();
-    }
+    join_threads();
 }
 
 void io_server::run()
@@ -19,7 +23,11 @@ void io_server::run()
     {
         m_status = RUNNING;
         this->handle();
+
+        // The calling thread is one of the io threads
+        spawn_threads(m_nof_threads - 1);
         m_ctx.run();
+        join_threads();
     }
 }
 
@@ -27,11 +35,10 @@ bool io_server::start()
 {
     if (m_status != RUNNING)
     {
-        m_future = std::async(std::launch::async, [this]() {
-            m_status = RUNNING;
-            this->handle();
-            m_ctx.run();
-        });
+        m_status = RUNNING;
+        m_ctx.restart();
+        this->handle();
+        spawn_threads(m_nof_threads);
 
         return true;
     }
@@ -43,7 +50,7 @@ bool io_server::stop()
     if (m_status == RUNNING)
     {
         m_ctx.stop();
-        m_future.get();
+        join_threads();
 
         m_status = STOPPED;
         return true;
@@ -51,4 +58,26 @@ bool io_server::stop()
     return false;
 }
 
+void io_server::spawn_threads(size_t nof_threads)
+{
+    for (size_t i = 0; i < nof_threads; ++i)
+    {
+        m_futures.push_back(std::async(std::launch::async, [this]() {
+            m_ctx.run();
+        }));
+    }
+}
+
+void io_server::join_threads()
+{
+    for (auto &future : m_futures)
+    {
+        if (future.valid())
+        {
+            future.get();
+        }
+    }
+    m_futures.clear();
+}
+
 }  // namespace server
@@ -0,0 +1,73 @@
+#include <networking/io/job_subscriptions.hpp>
+
+#include <boost/asio/post.hpp>
+#include <vector>
+
+namespace server {
+
+job_subscriptions &job_subscriptions::instance()
+{
+    static job_subscriptions instance;
+    return instance;
+}
+
+std::shared_ptr<job_subscriptions::subscription> job_subscriptions::subscribe(
+    int user_id, boost::asio::any_io_executor executor, push_function push)
+{
+    auto sub = std::make_shared<subscription>(subscription{std::move(executor), std::move(push)});
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    remove_expired(user_id);
+    m_subscriptions.emplace(user_id, sub);
+    return sub;
+}
+
+bool job_subscriptions::has_subscribers(int user_id)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    remove_expired(user_id);
+    return m_subscriptions.count(user_id) > 0;
+}
+
+void job_subscriptions::notify(int user_id, const graphs::StatusSingle &status)
+{
+    std::vector<std::weak_ptr<subscription>> subs;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        remove_expired(user_id);
+
+        const auto [begin, end] = m_subscriptions.equal_range(user_id);
+        for (auto it = begin; it != end; ++it)
+        {
+            subs.push_back(it->second);
+        }
+    }
+
+    for (auto &weak_sub : subs)
+    {
+        const auto sub = weak_sub.lock();
+        if (!sub)
+        {
+            continue;
+        }
+
+        // The subscription is checked again on its executor, it may have ended in the meantime
+        boost::asio::post(sub->executor, [weak_sub = std::move(weak_sub), status] {
+            if (const auto sub = weak_sub.lock())
+            {
+                sub->push(status);
+            }
+        });
+    }
+}
+
+void job_subscriptions::remove_expired(int user_id)
+{
+    const auto [begin, end] = m_subscriptions.equal_range(user_id);
+    for (auto it = begin; it != end;)
+    {
+        it = it->second.expired() ? m_subscriptions.erase(it) : std::next(it);
+    }
+}
+
+}  // namespace server
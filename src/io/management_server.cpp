@@ -6,9 +6,13 @@
 #include <string>
 
 #include <config/config.hpp>
+#include <persistence/database_pool.hpp>
 #include <persistence/database_wrapper.hpp>
+#include <persistence/job_maintenance.hpp>
 #include <persistence/user.hpp>
 #include <scheduler/scheduler.hpp>
+#include <util/metrics.hpp>
+#include <util/tracing.hpp>
 
 #include "status.pb.h"
 
@@ -24,10 +28,8 @@ namespace server {
 
 namespace {
 
-    json handle_user_cmd(std::string_view cmd, const json &arg)
+    json handle_user_cmd(database_wrapper &db, std::string_view cmd, const json &arg)
     {
-        database_wrapper db{get_db_connection_string()};
-
         json message{};
         if (cmd == "delete")
         {
@@ -39,8 +41,10 @@ namespace {
                 throw std::invalid_argument{"User not found"};
             }
 
-            db.delete_user_jobs(user->user_id);
-            db.delete_user(user->user_id);
+            // Deleting all jobs at once could lock their partitions for long. The user is blocked
+            // right away and deleted in the background.
+            db.set_user_blocked(user->user_id, true);
+            job_maintenance::instance().delete_user_jobs(user->user_id, true);
         }
         else if (cmd == "block")
         {
@@ -66,6 +70,22 @@ namespace {
 
             db.set_user_blocked(user->user_id, false);
         }
+        else if (cmd == "upload-limit")
+        {
+            // Resolve user
+            std::string_view name_or_id = arg.at("user").get<std::string>();
+            std::optional<user> user = db.resolve_user(name_or_id);
+            if (!user)
+            {
+                throw std::invalid_argument{"User not found"};
+            }
+
+            // A null limit resets the user to the configured default
+            const auto &limit = arg.at("limit");
+            db.set_user_upload_limit(user->user_id, limit.is_null()
+                                                       ? std::nullopt
+                                                       : std::optional{limit.get<int64_t>()});
+        }
         else if (cmd == "list")
         {
             json user_list = json::array();
@@ -104,10 +124,8 @@ namespace {
         return message;
     }
 
-    json handle_job_cmd(std::string_view cmd, const json &arg)
+    json handle_job_cmd(database_wrapper &db, std::string_view cmd, const json &arg)
     {
-        database_wrapper db{get_db_connection_string()};
-
         json message{};
         if (cmd == "delete")
         {
@@ -223,6 +241,92 @@ namespace {
         return message;
     }
 
+    json handle_retention_cmd(database_wrapper &db, std::string_view cmd, const json &arg)
+    {
+        auto &maintenance = job_maintenance::instance();
+
+        json message{};
+        if (cmd == "months")
+        {
+            if (arg.is_number_integer())
+            {
+                maintenance.set_retention_months(arg.get<int64_t>());
+                modify_config(config_options::JOB_RETENTION_MONTHS,
+                              variable_value{arg.get<int64_t>(), true});
+            }
+            message["months"] = maintenance.get_retention_months();
+        }
+        else if (cmd == "mode")
+        {
+            if (arg.is_string())
+            {
+                maintenance.set_retention_mode(
+                    job_maintenance::parse_retention_mode(arg.get<std::string>()));
+                modify_config(config_options::JOB_RETENTION_MODE,
+                              variable_value{arg.get<std::string>(), true});
+            }
+            message["mode"] =
+                std::string{job_maintenance::to_string(maintenance.get_retention_mode())};
+        }
+        else if (cmd == "apply")
+        {
+            message["removed"] = maintenance.run(db);
+        }
+        else if (cmd == "info")
+        {
+            message["months"] = maintenance.get_retention_months();
+            message["mode"] =
+                std::string{job_maintenance::to_string(maintenance.get_retention_mode())};
+            message["pending-deletes"] = maintenance.pending_deletes();
+
+            json partitions = json::array();
+            for (const auto &[name, jobs] : db.get_job_partitions())
+            {
+                partitions.push_back({{"name", name}, {"jobs", jobs}});
+            }
+            message["partitions"] = std::move(partitions);
+        }
+        else
+        {
+            throw std::invalid_argument{"Invalid cmd"};
+        }
+
+        return message;
+    }
+
+    json handle_tracing_cmd(std::string_view cmd, const json &arg)
+    {
+        auto &traces = tracing::instance();
+
+        json message{};
+        if (cmd == "start")
+        {
+            // Without a file, the configured one is used
+            const auto file = arg.is_string()
+                                  ? arg.get<std::string>()
+                                  : config(config_options::TRACE_FILE).as<std::string>();
+            if (file.empty())
+            {
+                throw std::invalid_argument{"No trace file given"};
+            }
+            traces.start(file);
+            modify_config(config_options::TRACE_FILE, variable_value{file, true});
+        }
+        else if (cmd == "stop")
+        {
+            traces.stop();
+        }
+        else if (cmd != "info")
+        {
+            throw std::invalid_argument{"Invalid cmd"};
+        }
+
+        message["enabled"] = traces.enabled();
+        message["file"] = traces.file();
+        message["pending"] = traces.pending();
+        return message;
+    }
+
 }  // namespace
 
 management_server::management_server(std::string_view descriptor)
@@ -295,19 +399,42 @@ void management_server::handle_request(yield_context &yield,
 {
     json response{};
     std::string request_type = request.at("type").get<std::string>();
+
+    // Commands using the database run on a database thread, so the management API keeps serving
+    // other requests meanwhile
+    const auto with_database = [&](auto handler) {
+        auto db = database_pool::instance().acquire(yield, m_ctx.get_executor());
+        return db.async_run(yield, [&](database_wrapper &database) {
+            return handler(database, request.at("cmd").get<std::string>(), request["arg"]);
+        });
+    };
+
     if (request_type == "user")
     {
-        response["message"] = handle_user_cmd(request.at("cmd").get<std::string>(), request["arg"]);
+        response["message"] = with_database(handle_user_cmd);
     }
     else if (request_type == "job")
     {
-        response["message"] = handle_job_cmd(request.at("cmd").get<std::string>(), request["arg"]);
+        response["message"] = with_database(handle_job_cmd);
     }
     else if (request_type == "scheduler")
     {
         response["message"] =
             handle_scheduler_cmd(request.at("cmd").get<std::string>(), request["arg"]);
     }
+    else if (request_type == "retention")
+    {
+        response["message"] = with_database(handle_retention_cmd);
+    }
+    else if (request_type == "metrics")
+    {
+        response["message"] = metrics::instance().to_prometheus();
+    }
+    else if (request_type == "tracing")
+    {
+        response["message"] =
+            handle_tracing_cmd(request.at("cmd").get<std::string>(), request["arg"]);
+    }
 
     response["status"] = "ok";
     respond_json(yield, sender, response);
@@ -0,0 +1,105 @@
+#include <networking/io/memory_budget.hpp>
+
+#include <boost/asio/post.hpp>
+#include <iostream>
+#include <utility>
+
+#include <config/config.hpp>
+
+namespace server {
+
+memory_budget::reservation::reservation(size_t size)
+    : m_size{size}
+{
+}
+
+memory_budget::reservation::reservation(reservation &&rhs) noexcept
+    : m_size{std::exchange(rhs.m_size, 0)}
+{
+}
+
+memory_budget::reservation &memory_budget::reservation::operator=(reservation &&rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        if (m_size > 0)
+        {
+            memory_budget::instance().release(m_size);
+        }
+        m_size = std::exchange(rhs.m_size, 0);
+    }
+    return *this;
+}
+
+memory_budget::reservation::~reservation()
+{
+    if (m_size > 0)
+    {
+        memory_budget::instance().release(m_size);
+    }
+}
+
+memory_budget &memory_budget::instance()
+{
+    static memory_budget instance;
+    return instance;
+}
+
+memory_budget::memory_budget()
+    : m_limit{config()[config_options::PAYLOAD_MEMORY_BUDGET].as<size_t>()}
+{
+}
+
+memory_budget::reservation memory_budget::reserve(boost::asio::yield_context &yield,
+                                                  const boost::asio::any_io_executor &executor,
+                                                  size_t size)
+{
+    std::shared_ptr<boost::asio::steady_timer> signal;
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_limit == 0 || m_used == 0 || m_used + size <= m_limit)
+            {
+                m_used += size;
+                return reservation{size};
+            }
+
+            if (!signal)
+            {
+                std::cout << "[CONNECTION] Payload memory budget exhausted, pausing reading\n";
+                signal = std::make_shared<boost::asio::steady_timer>(executor);
+            }
+            m_waiters.push_back(signal);
+        }
+
+        // Released memory is signalled on the executor of this coroutine, so the signal can not
+        // get lost before the coroutine is suspended
+        boost::system::error_code error;
+        signal->expires_at(boost::asio::steady_timer::time_point::max());
+        signal->async_wait(yield[error]);
+    }
+}
+
+void memory_budget::release(size_t size)
+{
+    std::vector<std::weak_ptr<boost::asio::steady_timer>> waiters;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_used -= size;
+        waiters.swap(m_waiters);
+    }
+
+    // Wake up all waiting coroutines, those not fitting into the budget wait again
+    for (auto &weak_signal : waiters)
+    {
+        if (auto signal = weak_signal.lock())
+        {
+            boost::asio::post(signal->get_executor(), [signal] {
+                signal->cancel();
+            });
+        }
+    }
+}
+
+}  // namespace server
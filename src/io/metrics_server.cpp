@@ -0,0 +1,106 @@
+#include <networking/io/metrics_server.hpp>
+
+#include <array>
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+#include <util/metrics.hpp>
+
+namespace server {
+
+using boost::asio::ip::tcp;
+using boost::system::error_code;
+
+namespace {
+    // Scrapers send short requests, anything longer is no scrape
+    constexpr const size_t MAX_REQUEST_SIZE = 8 << 10;  // 8 KB
+    constexpr const std::chrono::seconds READ_TIMEOUT{5};
+}  // namespace
+
+metrics_server::metrics_server(const std::string &address, unsigned short port)
+    : io_server{1}
+    , m_acceptor{m_ctx, tcp::endpoint{boost::asio::ip::make_address(address), port}}
+{
+}
+
+void metrics_server::handle()
+{
+    boost::asio::spawn(m_ctx, [this](boost::asio::yield_context yield) {
+        std::cout << "[INFO] Metrics endpoint listening on http://"
+                  << m_acceptor.local_endpoint() << "/metrics\n";
+
+        while (m_status == RUNNING)
+        {
+            auto sock = std::make_shared<tcp::socket>(m_ctx);
+            error_code err;
+            m_acceptor.async_accept(*sock, yield[err]);
+            if (err)
+            {
+                continue;
+            }
+
+            boost::asio::spawn(m_ctx, [this, sock](boost::asio::yield_context yield) {
+                serve(yield, *sock);
+            });
+        }
+    });
+}
+
+void metrics_server::serve(boost::asio::yield_context &yield, tcp::socket &sock)
+{
+    // Clients not sending their request in time are disconnected
+    boost::asio::steady_timer deadline{m_ctx, READ_TIMEOUT};
+    deadline.async_wait([&sock](const error_code &error) {
+        if (!error)
+        {
+            error_code ignored;
+            sock.close(ignored);
+        }
+    });
+
+    std::string request;
+    error_code err;
+    boost::asio::async_read_until(sock, boost::asio::dynamic_buffer(request, MAX_REQUEST_SIZE),
+                                  "\r\n\r\n", yield[err]);
+    deadline.cancel();
+    if (err)
+    {
+        return;
+    }
+
+    // Only the request line matters, e.g. "GET /metrics HTTP/1.1"
+    std::string_view line{request};
+    line = line.substr(0, line.find("\r\n"));
+    const auto method_end = line.find(' ');
+    std::string_view target = method_end == std::string_view::npos
+                                  ? std::string_view{}
+                                  : line.substr(method_end + 1, line.find(' ', method_end + 1) -
+                                                                    method_end - 1);
+    target = target.substr(0, target.find('?'));
+
+    std::string body;
+    std::string status;
+    std::string content_type = "text/plain; charset=utf-8";
+    if (line.substr(0, method_end) == "GET" && target == "/metrics")
+    {
+        status = "200 OK";
+        content_type = "text/plain; version=0.0.4; charset=utf-8";
+        body = metrics::instance().to_prometheus();
+    }
+    else
+    {
+        status = "404 Not Found";
+        body = "Not found, metrics are served at /metrics\n";
+    }
+
+    const std::string header = "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+                               "\r\nContent-Length: " + std::to_string(body.size()) +
+                               "\r\nConnection: close\r\n\r\n";
+    const std::array<boost::asio::const_buffer, 2> buffers{boost::asio::buffer(header),
+                                                           boost::asio::buffer(body)};
+    boost::asio::async_write(sock, buffers, yield[err]);
+    sock.shutdown(tcp::socket::shutdown_both, err);
+}
+
+}  // namespace server
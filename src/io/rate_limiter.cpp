@@ -0,0 +1,95 @@
+#include <networking/io/rate_limiter.hpp>
+
+#include <algorithm>
+#include <string_view>
+
+namespace server {
+
+namespace {
+    /// Number of remembered sources from which on full buckets are dropped
+    constexpr size_t MIN_SWEEP_SIZE = 1024;
+}  // namespace
+
+size_t rate_limiter::address_hash::operator()(const boost::asio::ip::address &address) const
+{
+    if (address.is_v4())
+    {
+        return std::hash<uint32_t>{}(address.to_v4().to_uint());
+    }
+
+    const auto bytes = address.to_v6().to_bytes();
+    return std::hash<std::string_view>{}(
+        std::string_view{reinterpret_cast<const char *>(bytes.data()), bytes.size()});
+}
+
+rate_limiter::rate_limiter(double rate, double burst)
+    : m_rate{rate}
+    , m_burst{std::max(burst, 1.0)}
+    , m_sweep_size{MIN_SWEEP_SIZE}
+{
+}
+
+bool rate_limiter::try_acquire(const boost::asio::ip::address &source)
+{
+    if (m_rate <= 0)
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto &source_bucket = refilled_bucket(source, clock::now());
+    if (source_bucket.tokens < 1)
+    {
+        return false;
+    }
+
+    source_bucket.tokens -= 1;
+    return true;
+}
+
+rate_limiter::clock::duration rate_limiter::acquire(const boost::asio::ip::address &source)
+{
+    if (m_rate <= 0)
+    {
+        return clock::duration::zero();
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto &source_bucket = refilled_bucket(source, clock::now());
+    source_bucket.tokens -= 1;
+    if (source_bucket.tokens >= 0)
+    {
+        return clock::duration::zero();
+    }
+
+    // The debt is paid back by the refill, which takes this long
+    return std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>{-source_bucket.tokens / m_rate});
+}
+
+rate_limiter::bucket &rate_limiter::refilled_bucket(const boost::asio::ip::address &source,
+                                                    clock::time_point now)
+{
+    if (m_buckets.size() >= m_sweep_size)
+    {
+        for (auto it = m_buckets.begin(); it != m_buckets.end();)
+        {
+            const std::chrono::duration<double> elapsed = now - it->second.updated;
+            const bool full = it->second.tokens + elapsed.count() * m_rate >= m_burst;
+            it = full ? m_buckets.erase(it) : std::next(it);
+        }
+        m_sweep_size = std::max(MIN_SWEEP_SIZE, 2 * m_buckets.size());
+    }
+
+    const auto [it, inserted] = m_buckets.try_emplace(source, bucket{m_burst, now});
+    auto &source_bucket = it->second;
+    if (!inserted)
+    {
+        const std::chrono::duration<double> elapsed = now - source_bucket.updated;
+        source_bucket.tokens = std::min(m_burst, source_bucket.tokens + elapsed.count() * m_rate);
+        source_bucket.updated = now;
+    }
+    return source_bucket;
+}
+
+}  // namespace server
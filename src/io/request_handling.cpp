@@ -1,10 +1,9 @@
 #include <networking/io/request_handling.hpp>
 
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filtering_streambuf.hpp>
-
 #include <auth/auth_utils.hpp>
 #include <handling/handler_utilities.hpp>
+#include <networking/io/compression.hpp>
+#include <networking/io/result_slicing.hpp>
 #include <networking/requests/generic_request.hpp>
 #include <networking/responses/new_job_response.hpp>
 #include <networking/responses/origin_graph_response.hpp>
@@ -12,12 +11,25 @@
 #include <networking/responses/status_response.hpp>
 #include <scheduler/scheduler.hpp>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <openssl/evp.h>
+#include <charconv>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
 #include "abort_job.pb.h"
 #include "delete_job.pb.h"
 #include "error.pb.h"
 #include "new_job_response.pb.h"
 #include "origin_graph.pb.h"
 #include "result.pb.h"
+#include "status.pb.h"
+#include "upload_graph.pb.h"
 
 using graphs::AbortJobRequest;
 using graphs::DeleteJobRequest;
@@ -30,30 +42,162 @@ using graphs::RequestContainer;
 using graphs::RequestType;
 using graphs::ResponseContainer;
 using graphs::ResultRequest;
+using graphs::StatusRequest;
 using graphs::StatusResponse;
+using graphs::UploadGraphResponse;
 
 namespace server {
 
 namespace request_handling {
 
+    namespace {
+        /// Cursors are passed to the client as "x<change_xid>.<job_id>" and are opaque to it
+        std::string format_status_cursor(const status_cursor &cursor)
+        {
+            return 'x' + std::to_string(cursor.change_xid) + '.' + std::to_string(cursor.job_id);
+        }
+
+        bool parse_status_cursor(const std::string &str, status_cursor &cursor)
+        {
+            // Cursors handed out before were timestamps, which would skip all later changes when
+            // compared to transaction IDs. Those clients get all jobs once more instead.
+            if (str.front() != 'x')
+            {
+                cursor = status_cursor{};
+                return str.find_first_not_of("0123456789.") == std::string::npos;
+            }
+
+            const char *const end = str.data() + str.size();
+            const auto [xid_end, xid_error] =
+                std::from_chars(str.data() + 1, end, cursor.change_xid);
+            if (xid_error != std::errc{} || xid_end == end || *xid_end != '.')
+            {
+                return false;
+            }
+
+            const auto [id_end, id_error] = std::from_chars(xid_end + 1, end, cursor.job_id);
+            return id_error == std::errc{} && id_end == end;
+        }
+
+        // Fields of google.protobuf.Any
+        constexpr const int ANY_TYPE_URL_FIELD = 1;
+        constexpr const int ANY_VALUE_FIELD = 2;
+
+        /**
+         * Scans the top level fields of a serialized message without parsing it. The visitor is
+         *  called with the number and the value of each length delimited field as view into the
+         *  message and of each varint field as uint64_t, other fields are skipped.
+         *
+         * @return bool False if the message is malformed
+         */
+        template <typename Visitor>
+        bool visit_fields(binary_data_view message, Visitor &&visitor)
+        {
+            using google::protobuf::internal::WireFormatLite;
+            if (message.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+            {
+                return false;
+            }
+
+            google::protobuf::io::CodedInputStream input{
+                reinterpret_cast<const uint8_t *>(message.data()),
+                static_cast<int>(message.size())};
+            while (const uint32_t tag = input.ReadTag())
+            {
+                const int number = WireFormatLite::GetTagFieldNumber(tag);
+                switch (WireFormatLite::GetTagWireType(tag))
+                {
+                    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+                        uint32_t length;
+                        if (!input.ReadVarint32(&length))
+                        {
+                            return false;
+                        }
+                        const int position = input.CurrentPosition();
+                        if (!input.Skip(static_cast<int>(length)))
+                        {
+                            return false;
+                        }
+                        visitor(number, message.substr(position, length));
+                        break;
+                    }
+                    case WireFormatLite::WIRETYPE_VARINT: {
+                        uint64_t value;
+                        if (!input.ReadVarint64(&value))
+                        {
+                            return false;
+                        }
+                        visitor(number, value);
+                        break;
+                    }
+                    default:
+                        if (!WireFormatLite::SkipField(&input, tag))
+                        {
+                            return false;
+                        }
+                }
+            }
+            return input.CurrentPosition() == static_cast<int>(message.size());
+        }
+
+        std::string sha256_hex(binary_data_view data)
+        {
+            unsigned char digest[EVP_MAX_MD_SIZE];
+            unsigned int digest_size = 0;
+            if (EVP_Digest(data.data(), data.size(), digest, &digest_size, EVP_sha256(),
+                           nullptr) != 1)
+            {
+                throw std::runtime_error{"Could not compute SHA-256"};
+            }
+
+            static constexpr const char HEX[] = "0123456789abcdef";
+            std::string hex;
+            hex.reserve(2 * digest_size);
+            for (unsigned int i = 0; i < digest_size; ++i)
+            {
+                hex.push_back(HEX[digest[i] >> 4]);
+                hex.push_back(HEX[digest[i] & 0xf]);
+            }
+            return hex;
+        }
+    }  // namespace
+
     handled_request handle_available_handlers()
     {
         return handled_request{meta_data{RequestType::AVAILABLE_HANDLERS},
                                response_factory::build_response(available_handlers())};
     }
 
-    handled_request handle_status(database_wrapper &db, const user &user)
+    handled_request handle_status(database_wrapper &db, const RequestContainer &container,
+                                  const user &user)
     {
-        std::vector<job_entry> jobs = db.get_job_entries(user.user_id);
+        // Requests without a body ask for all jobs
+        StatusRequest request;
+        if (container.has_request() && !container.request().UnpackTo(&request))
+        {
+            throw ResponseContainer::INVALID_REQUEST_ERROR;
+        }
+
+        status_cursor after;
+        if (!request.cursor().empty() && !parse_status_cursor(request.cursor(), after))
+        {
+            throw ResponseContainer::INVALID_REQUEST_ERROR;
+        }
+
+        auto page = db.get_status_changes(user.user_id, after, request.limit());
 
         StatusResponse status_response;
         auto respStates = status_response.mutable_states();
-
-        for (const auto &job : jobs)
+        respStates->Reserve(page.states.size());
+        for (auto &state : page.states)
         {
-            respStates->Add(db.get_status_data(job.job_id, user.user_id));
+            *respStates->Add() = std::move(state);
         }
 
+        // Polling with the returned cursor yields the next page, or the jobs changed since
+        status_response.set_cursor(format_status_cursor(page.cursor));
+        status_response.set_more(page.more);
+
         auto response =
             std::make_unique<server::status_response>(std::move(status_response), status_code::OK);
 
@@ -61,9 +205,8 @@ namespace request_handling {
                                response_factory::build_response(std::move(response))};
     }
 
-    std::pair<meta_data, binary_data> handle_result(database_wrapper &db, const MetaData &meta,
-                                                    const RequestContainer &request,
-                                                    const user &user)
+    handled_result handle_result(database_wrapper &db, const MetaData &meta,
+                                 const RequestContainer &request, const user &user)
     {
         ResultRequest res_req;
         if (const bool ok = request.request().UnpackTo(&res_req); !ok)
@@ -73,17 +216,39 @@ namespace request_handling {
 
         const int job_id = res_req.jobid();
 
-        meta_data job_meta_data = db.get_meta_data(job_id, user.user_id);
-        auto [type, binary_response] = db.get_response_data_raw(job_id, user.user_id);
+        handled_result result{db.get_meta_data(job_id, user.user_id),
+                              db.get_response_data_raw(job_id, user.user_id), {}};
 
-        // Add latest status information to the algorithm response
-        ResponseContainer status_container;
-        *(status_container.mutable_statusdata()) = db.get_status_data(job_id, user.user_id);
-        size_t old_len = binary_response.size();
-        binary_response.resize(old_len + status_container.ByteSizeLong());
-        status_container.SerializeToArray(binary_response.data() + old_len, binary_response.size());
+        // Only the selected parts are sent, sliced from the stored serialization
+        result_selection selection{{res_req.fields().begin(), res_req.fields().end()},
+                                   res_req.offset(),
+                                   res_req.count()};
+        if (!selection.selects_all())
+        {
+            auto &stored = result.response;
+            const auto data = stored.view();
+
+            std::string sliced;
+            const bool ok = compression::with_decompressed(
+                stored.compression, reinterpret_cast<const char *>(data.data()), data.size(),
+                [&](google::protobuf::io::ZeroCopyInputStream &in) {
+                    return slice_result(in, selection, sliced);
+                });
+            if (!ok)
+            {
+                throw ResponseContainer::ERROR;
+            }
+
+            stored.compression = graphs::CompressionType::NONE;
+            stored.binary.assign(reinterpret_cast<const std::byte *>(sliced.data()),
+                                 sliced.size());
+            stored.blob.reset();
+        }
 
-        return std::pair{job_meta_data, binary_response};
+        // Latest status information, merged into the algorithm response by the client
+        *(result.status.mutable_statusdata()) = db.get_status_data(job_id, user.user_id);
+
+        return result;
     }
 
     handled_request handle_abort_job(const RequestContainer &request, const user &user)
@@ -122,24 +287,11 @@ namespace request_handling {
         return handled_request{meta_data{RequestType::ABORT_JOB}, response};
     }
 
-    handled_request handle_new_job(database_wrapper &db, const MetaData &meta,
-                                   const std::vector<char> &buffer, const user &user)
+    handled_request handle_new_job(job_upload &upload, const database_pool::lease &database,
+                                   boost::asio::yield_context &yield,
+                                   const std::function<void(int)> &inserted)
     {
-        namespace io = boost::iostreams;
-
-        io::filtering_streambuf<io::input> in_str_buf;
-        in_str_buf.push(io::gzip_decompressor{});
-        in_str_buf.push(io::array_source{buffer.data(), buffer.size()});
-
-        // Copy compressed data into the decompressed buffer
-        std::vector<char> decompressed;
-        decompressed.reserve(buffer.size());
-        decompressed.assign(std::istreambuf_iterator<char>{&in_str_buf}, {});
-        binary_data_view binary(reinterpret_cast<std::byte *>(decompressed.data()),
-                                decompressed.size());
-
-        int job_id = db.add_job(user.user_id,
-                                meta_data{meta.type(), meta.handlertype(), meta.jobname()}, binary);
+        const int job_id = upload.commit(yield, database, inserted);
 
         NewJobResponse new_job_resp;
         new_job_resp.set_jobid(job_id);
@@ -151,7 +303,86 @@ namespace request_handling {
                                response_factory::build_response(std::move(response))};
     }
 
-    handled_request handle_user_creation(database_wrapper &db, const graphs::MetaData &meta)
+    uploaded_graph read_uploaded_graph(binary_data_view container)
+    {
+        // Fields are looked up by name, the same way the graph would be parsed
+        const int request_field =
+            RequestContainer::descriptor()->FindFieldByLowercaseName("request")->number();
+        const int graph_id_field =
+            graphs::GenericRequest::descriptor()->FindFieldByLowercaseName("graphid")->number();
+
+        // The last occurrence of a field wins, like when parsing
+        std::optional<binary_data_view> any;
+        if (!visit_fields(container, [&](int number, auto value) {
+                if constexpr (std::is_same_v<decltype(value), binary_data_view>)
+                {
+                    if (number == request_field)
+                    {
+                        any = value;
+                    }
+                }
+            }))
+        {
+            throw ResponseContainer::PROTO_PARSING_ERROR;
+        }
+
+        std::string_view type_url;
+        std::optional<binary_data_view> graph;
+        if (!any || !visit_fields(*any, [&](int number, auto value) {
+                if constexpr (std::is_same_v<decltype(value), binary_data_view>)
+                {
+                    if (number == ANY_TYPE_URL_FIELD)
+                    {
+                        type_url = {reinterpret_cast<const char *>(value.data()), value.size()};
+                    }
+                    else if (number == ANY_VALUE_FIELD)
+                    {
+                        graph = value;
+                    }
+                }
+            }))
+        {
+            throw ResponseContainer::INVALID_REQUEST_ERROR;
+        }
+
+        // Stored graphs can not reference other stored graphs
+        uint64_t graph_id = 0;
+        const bool is_generic_request =
+            type_url.substr(type_url.rfind('/') + 1) ==
+            graphs::GenericRequest::descriptor()->full_name();
+        if (!is_generic_request || !graph || !visit_fields(*graph, [&](int number, auto value) {
+                if constexpr (std::is_same_v<decltype(value), uint64_t>)
+                {
+                    if (number == graph_id_field)
+                    {
+                        graph_id = value;
+                    }
+                }
+            }) ||
+            graph_id != 0)
+        {
+            throw ResponseContainer::INVALID_REQUEST_ERROR;
+        }
+
+        return uploaded_graph{*graph, sha256_hex(*graph)};
+    }
+
+    handled_request handle_upload_graph(database_wrapper &db, const uploaded_graph &graph,
+                                        const user &user)
+    {
+        UploadGraphResponse upload_graph_resp;
+        upload_graph_resp.set_graphid(db.add_graph(user.user_id, graph.graph, graph.hash));
+        upload_graph_resp.set_hash(graph.hash);
+
+        graphs::ResponseContainer response;
+        response.set_status(graphs::ResponseContainer::OK);
+        response.mutable_response()->PackFrom(upload_graph_resp);
+        return handled_request{meta_data{RequestType::UPLOAD_GRAPH}, response};
+    }
+
+    handled_request handle_user_creation(database_pool::lease &database,
+                                         const graphs::MetaData &meta,
+                                         boost::asio::yield_context &yield)
     {
         // Create user data for new user
         user user_data{};
@@ -159,12 +390,15 @@ namespace request_handling {
         user_data.role = user_role::User;
 
         // Get password hash and used salt
-        if (!auth_utils::hash_password(meta.user().password(), user_data.pw_hash, user_data.salt))
+        if (!auth_utils::async_hash_password(yield, meta.user().password(), user_data.pw_hash,
+                                             user_data.salt))
         {
             throw ErrorType::USER_CREATION;
         }
 
-        if (!db.create_user(user_data))
+        if (!database.async_run(yield, [&](database_wrapper &db) {
+                return db.create_user(user_data);
+            }))
         {
             throw ErrorType::USER_CREATION;
         }
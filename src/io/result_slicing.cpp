@@ -0,0 +1,476 @@
+#include <networking/io/result_slicing.hpp>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <algorithm>
+#include <unordered_map>
+
+#include "container.pb.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::ZeroCopyInputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace server {
+
+namespace {
+
+    void append_varint(std::string &out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void append_length_delimited(std::string &out, uint32_t tag, const std::string &data)
+    {
+        append_varint(out, tag);
+        append_varint(out, data.size());
+        out.append(data);
+    }
+
+    /// Reads the value of a field with the given tag and appends tag and value to out
+    bool copy_field(CodedInputStream &in, uint32_t tag, std::string &out)
+    {
+        append_varint(out, tag);
+
+        switch (WireFormatLite::GetTagWireType(tag))
+        {
+            case WireFormatLite::WIRETYPE_VARINT: {
+                uint64_t value;
+                if (!in.ReadVarint64(&value))
+                {
+                    return false;
+                }
+                append_varint(out, value);
+                return true;
+            }
+            case WireFormatLite::WIRETYPE_FIXED64: {
+                char value[8];
+                if (!in.ReadRaw(value, sizeof(value)))
+                {
+                    return false;
+                }
+                out.append(value, sizeof(value));
+                return true;
+            }
+            case WireFormatLite::WIRETYPE_FIXED32: {
+                char value[4];
+                if (!in.ReadRaw(value, sizeof(value)))
+                {
+                    return false;
+                }
+                out.append(value, sizeof(value));
+                return true;
+            }
+            case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+                uint32_t length;
+                if (!in.ReadVarint32(&length))
+                {
+                    return false;
+                }
+                append_varint(out, length);
+
+                const size_t start = out.size();
+                out.resize(start + length);
+                return in.ReadRaw(out.data() + start, length);
+            }
+            default:
+                // Groups are not used by the protocol
+                return false;
+        }
+    }
+
+    bool starts_with(const std::string &str, const char *prefix)
+    {
+        return str.rfind(prefix, 0) == 0;
+    }
+
+    /// Repeated fields holding one element per vertex or per edge, like vertexList or edgeCosts
+    bool is_element_list(const FieldDescriptor *field)
+    {
+        const auto &name = field->lowercase_name();
+        return starts_with(name, "vertex") || starts_with(name, "node") ||
+               starts_with(name, "edge");
+    }
+
+    /// Fields of edges referencing a vertex by its index in the vertex list
+    bool is_vertex_index(const FieldDescriptor *field)
+    {
+        const auto &name = field->lowercase_name();
+        return name == "invertexindex" || name == "outvertexindex";
+    }
+
+    /// The enum field telling whether the values of an attribute belong to vertices or edges
+    const FieldDescriptor *attribute_type_field(const Descriptor *type)
+    {
+        const FieldDescriptor *field = type->FindFieldByLowercaseName("type");
+        return field && field->enum_type() && field->enum_type()->name() == "AttributeType"
+                   ? field
+                   : nullptr;
+    }
+
+    /// Slices the fields of a single message until the end of the current limit
+    class message_slicer
+    {
+    public:
+        message_slicer(CodedInputStream &in, const result_selection &selection)
+            : m_in{in}
+            , m_selection{selection}
+        {
+        }
+
+        /**
+         * Slices a message of the given type. Only the fields of the top level are filtered.
+         *
+         * @param elements True if all repeated fields of the message hold one element per vertex
+         *  or per edge, like the values of vertex and edge attributes
+         */
+        bool slice(const Descriptor *type, bool top_level, bool elements, std::string &out)
+        {
+            // Element indices are counted per repeated field of this message
+            std::unordered_map<int, uint64_t> indices;
+
+            while (const uint32_t tag = m_in.ReadTag())
+            {
+                const FieldDescriptor *field =
+                    type->FindFieldByNumber(WireFormatLite::GetTagFieldNumber(tag));
+
+                if (field && top_level && !is_selected(field))
+                {
+                    if (!WireFormatLite::SkipField(&m_in, tag))
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+
+                bool ok;
+                if (!field || !has_range())
+                {
+                    ok = copy_field(m_in, tag, out);
+                }
+                else if (field->is_map() || (!field->is_repeated() &&
+                                             field->type() == FieldDescriptor::TYPE_MESSAGE))
+                {
+                    // Lists nested in messages and attribute values are sliced as well
+                    ok = slice_nested(tag, field->message_type(), out);
+                }
+                else if (field->is_repeated() && !elements && !is_element_list(field))
+                {
+                    // E.g. a path or the values of a graph attribute, which are not paged
+                    ok = copy_field(m_in, tag, out);
+                }
+                else if (field->is_repeated() && field->is_packable() &&
+                         WireFormatLite::GetTagWireType(tag) ==
+                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED)
+                {
+                    ok = slice_packed(tag, field, indices[field->number()], out);
+                }
+                else if (field->is_repeated())
+                {
+                    const bool keep = in_range(indices[field->number()]++);
+                    if (!keep)
+                    {
+                        ok = WireFormatLite::SkipField(&m_in, tag);
+                    }
+                    else if (field->type() == FieldDescriptor::TYPE_MESSAGE)
+                    {
+                        // Kept edges are sliced to rewrite their vertex indices
+                        ok = slice_nested(tag, field->message_type(), out);
+                    }
+                    else
+                    {
+                        ok = copy_field(m_in, tag, out);
+                    }
+                }
+                else if (is_vertex_index(field) &&
+                         WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT)
+                {
+                    ok = rewrite_vertex_index(tag, out);
+                }
+                else
+                {
+                    ok = copy_field(m_in, tag, out);
+                }
+
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+
+            return m_in.ConsumedEntireMessage();
+        }
+
+        /// Slices a length delimited message, buffering it to write its new length
+        bool slice_nested(uint32_t tag, const Descriptor *type, std::string &out,
+                          bool top_level = false)
+        {
+            if (const FieldDescriptor *type_field = attribute_type_field(type))
+            {
+                return slice_attribute(tag, type, type_field, out);
+            }
+
+            uint32_t length;
+            if (!m_in.ReadVarint32(&length))
+            {
+                return false;
+            }
+
+            const auto limit = m_in.PushLimit(static_cast<int>(length));
+            std::string nested;
+            const bool ok = slice(type, top_level, false, nested);
+            m_in.PopLimit(limit);
+
+            if (ok)
+            {
+                append_length_delimited(out, tag, nested);
+            }
+            return ok;
+        }
+
+    private:
+        bool has_range() const { return m_selection.offset > 0 || m_selection.count > 0; }
+
+        bool in_range(uint64_t index) const
+        {
+            return index >= m_selection.offset &&
+                   (m_selection.count == 0 || index - m_selection.offset < m_selection.count);
+        }
+
+        bool is_selected(const FieldDescriptor *field) const
+        {
+            const auto &fields = m_selection.fields;
+            return fields.empty() ||
+                   std::find(fields.begin(), fields.end(), field->name()) != fields.end() ||
+                   std::find(fields.begin(), fields.end(), field->json_name()) != fields.end();
+        }
+
+        /// Makes the index of a vertex relative to the page, -1 if the vertex is not in the page
+        bool rewrite_vertex_index(uint32_t tag, std::string &out)
+        {
+            uint64_t value;
+            if (!m_in.ReadVarint64(&value))
+            {
+                return false;
+            }
+
+            // Negative int32 values are sign extended to 64 bits on the wire
+            const auto index = static_cast<int64_t>(value);
+            const int64_t rewritten = index >= 0 && in_range(static_cast<uint64_t>(index))
+                                          ? index - static_cast<int64_t>(m_selection.offset)
+                                          : int64_t{-1};
+
+            append_varint(out, tag);
+            append_varint(out, static_cast<uint64_t>(rewritten));
+            return true;
+        }
+
+        /**
+         * Slices the values of an attribute only if they belong to vertices or edges. The type
+         *  may be serialized after the values, so it is looked up in the whole message first.
+         */
+        bool slice_attribute(uint32_t tag, const Descriptor *type,
+                             const FieldDescriptor *type_field, std::string &out)
+        {
+            uint32_t length;
+            std::string message;
+            if (!m_in.ReadVarint32(&length) ||
+                !m_in.ReadString(&message, static_cast<int>(length)))
+            {
+                return false;
+            }
+
+            // The last occurrence wins, a missing type is the default value zero
+            int attribute_type = 0;
+            CodedInputStream scan{reinterpret_cast<const uint8_t *>(message.data()),
+                                  static_cast<int>(message.size())};
+            while (const uint32_t field_tag = scan.ReadTag())
+            {
+                uint64_t value;
+                if (WireFormatLite::GetTagFieldNumber(field_tag) == type_field->number() &&
+                    WireFormatLite::GetTagWireType(field_tag) == WireFormatLite::WIRETYPE_VARINT)
+                {
+                    if (!scan.ReadVarint64(&value))
+                    {
+                        return false;
+                    }
+                    attribute_type = static_cast<int>(value);
+                }
+                else if (!WireFormatLite::SkipField(&scan, field_tag))
+                {
+                    return false;
+                }
+            }
+
+            const auto *type_value = type_field->enum_type()->FindValueByNumber(attribute_type);
+            const bool elements =
+                type_value && (type_value->name() == "VERTEX" || type_value->name() == "EDGE");
+
+            CodedInputStream in{reinterpret_cast<const uint8_t *>(message.data()),
+                                static_cast<int>(message.size())};
+            std::string sliced;
+            if (!message_slicer{in, m_selection}.slice(type, false, elements, sliced))
+            {
+                return false;
+            }
+
+            append_length_delimited(out, tag, sliced);
+            return true;
+        }
+
+        /// Keeps the elements of a packed repeated field that are in range
+        bool slice_packed(uint32_t tag, const FieldDescriptor *field, uint64_t &index,
+                          std::string &out)
+        {
+            uint32_t length;
+            if (!m_in.ReadVarint32(&length))
+            {
+                return false;
+            }
+
+            const auto limit = m_in.PushLimit(static_cast<int>(length));
+            const auto wire_type = WireFormatLite::WireTypeForFieldType(
+                static_cast<WireFormatLite::FieldType>(field->type()));
+
+            std::string kept;
+            bool ok = true;
+            while (ok && m_in.BytesUntilLimit() > 0)
+            {
+                const bool keep = in_range(index++);
+                switch (wire_type)
+                {
+                    case WireFormatLite::WIRETYPE_FIXED64:
+                    case WireFormatLite::WIRETYPE_FIXED32: {
+                        char value[8];
+                        const int size = wire_type == WireFormatLite::WIRETYPE_FIXED64 ? 8 : 4;
+                        ok = m_in.ReadRaw(value, size);
+                        if (ok && keep)
+                        {
+                            kept.append(value, size);
+                        }
+                        break;
+                    }
+                    default: {
+                        uint64_t value;
+                        ok = m_in.ReadVarint64(&value);
+                        if (ok && keep)
+                        {
+                            append_varint(kept, value);
+                        }
+                        break;
+                    }
+                }
+            }
+            m_in.PopLimit(limit);
+
+            if (ok && !kept.empty())
+            {
+                append_length_delimited(out, tag, kept);
+            }
+            return ok;
+        }
+
+        CodedInputStream &m_in;
+        const result_selection &m_selection;
+    };
+
+    /// Extracts the message type from the type url of an Any
+    const Descriptor *find_type(const std::string &type_url)
+    {
+        const auto name_start = type_url.rfind('/');
+        return DescriptorPool::generated_pool()->FindMessageTypeByName(
+            name_start == std::string::npos ? type_url : type_url.substr(name_start + 1));
+    }
+
+    /// Slices the value of a google::protobuf::Any according to its type url
+    bool slice_any(CodedInputStream &in, const result_selection &selection, std::string &out)
+    {
+        const Descriptor *type = nullptr;
+        message_slicer slicer{in, selection};
+
+        while (const uint32_t tag = in.ReadTag())
+        {
+            bool ok;
+            if (WireFormatLite::GetTagFieldNumber(tag) == 1 &&
+                WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED)
+            {
+                // type_url, always serialized in front of the value
+                std::string type_url;
+                ok = WireFormatLite::ReadString(&in, &type_url);
+                append_length_delimited(out, tag, type_url);
+                type = find_type(type_url);
+            }
+            else if (WireFormatLite::GetTagFieldNumber(tag) == 2 && type)
+            {
+                ok = slicer.slice_nested(tag, type, out, true);
+            }
+            else
+            {
+                ok = copy_field(in, tag, out);
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+
+        return in.ConsumedEntireMessage();
+    }
+
+}  // namespace
+
+bool result_selection::selects_all() const
+{
+    return fields.empty() && offset == 0 && count == 0;
+}
+
+bool slice_result(ZeroCopyInputStream &container, const result_selection &selection,
+                  std::string &out)
+{
+    CodedInputStream in{&container};
+
+    const FieldDescriptor *response_field =
+        graphs::ResponseContainer::descriptor()->FindFieldByName("response");
+
+    while (const uint32_t tag = in.ReadTag())
+    {
+        bool ok;
+        if (WireFormatLite::GetTagFieldNumber(tag) == response_field->number())
+        {
+            uint32_t length;
+            ok = in.ReadVarint32(&length);
+            if (ok)
+            {
+                const auto limit = in.PushLimit(static_cast<int>(length));
+                std::string response;
+                ok = slice_any(in, selection, response);
+                in.PopLimit(limit);
+
+                append_length_delimited(out, tag, response);
+            }
+        }
+        else
+        {
+            ok = copy_field(in, tag, out);
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    return in.ConsumedEntireMessage();
+}
+
+}  // namespace server
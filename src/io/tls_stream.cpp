@@ -0,0 +1,111 @@
+#include <networking/io/tls_stream.hpp>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <cerrno>
+
+namespace server {
+
+using boost::system::error_code;
+
+tls_stream::tls_stream(const executor_type &executor, boost::asio::ssl::context &ctx)
+    : m_socket{executor}
+    , m_ssl{SSL_new(ctx.native_handle())}
+{
+    if (!m_ssl)
+    {
+        throw boost::system::system_error{static_cast<int>(ERR_get_error()),
+                                          boost::asio::error::get_ssl_category(), "SSL_new"};
+    }
+
+    // Writes are continued with the remainder of the buffer, which may be moved by asio
+    SSL_set_mode(m_ssl.get(),
+                 SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+}
+
+tls_stream::step tls_stream::handshake_step(boost::asio::ssl::stream_base::handshake_type type,
+                                            error_code &error)
+{
+    if (SSL_get_fd(m_ssl.get()) < 0)
+    {
+        // The socket is only connected now, OpenSSL reads and writes it directly
+        m_socket.non_blocking(true, error);
+        if (error || !SSL_set_fd(m_ssl.get(), m_socket.native_handle()))
+        {
+            if (!error)
+            {
+                error = error_code{static_cast<int>(ERR_get_error()),
+                                   boost::asio::error::get_ssl_category()};
+            }
+            return step::failed;
+        }
+
+        if (type == boost::asio::ssl::stream_base::server)
+        {
+            SSL_set_accept_state(m_ssl.get());
+        }
+        else
+        {
+            SSL_set_connect_state(m_ssl.get());
+        }
+    }
+
+    errno = 0;
+    const step s = to_step(SSL_do_handshake(m_ssl.get()), error);
+    if (s == step::done)
+    {
+        // Only set if OpenSSL enabled kTLS and the kernel accepted the negotiated cipher,
+        // otherwise writes keep using SSL_write
+        m_kernel_tls_send = BIO_get_ktls_send(SSL_get_wbio(m_ssl.get())) == 1;
+    }
+    return s;
+}
+
+tls_stream::step tls_stream::read_step(boost::asio::mutable_buffer buffer, size_t &transferred,
+                                       error_code &error)
+{
+    // Reads always go through OpenSSL, which also processes control messages if the kernel
+    // decrypts received records
+    errno = 0;
+    return to_step(SSL_read_ex(m_ssl.get(), buffer.data(), buffer.size(), &transferred), error);
+}
+
+tls_stream::step tls_stream::write_step(boost::asio::const_buffer buffer, size_t &transferred,
+                                        error_code &error)
+{
+    errno = 0;
+    return to_step(SSL_write_ex(m_ssl.get(), buffer.data(), buffer.size(), &transferred), error);
+}
+
+tls_stream::step tls_stream::to_step(int result, error_code &error)
+{
+    if (result == 1)
+    {
+        return step::done;
+    }
+
+    switch (SSL_get_error(m_ssl.get(), result))
+    {
+        case SSL_ERROR_WANT_READ:
+            return step::want_read;
+        case SSL_ERROR_WANT_WRITE:
+            return step::want_write;
+        case SSL_ERROR_ZERO_RETURN:
+            error = boost::asio::error::eof;
+            break;
+        case SSL_ERROR_SYSCALL:
+            // Without an error code the peer closed the connection without close_notify
+            error = errno != 0 ? error_code{errno, boost::system::system_category()}
+                               : error_code{boost::asio::ssl::error::stream_truncated};
+            break;
+        default:
+            error = error_code{static_cast<int>(ERR_get_error()),
+                               boost::asio::error::get_ssl_category()};
+            break;
+    }
+
+    ERR_clear_error();
+    return step::failed;
+}
+
+}  // namespace server
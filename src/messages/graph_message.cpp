@@ -2,6 +2,8 @@
 
 #include <chrono>
 
+#include "util/job_phases.hpp"
+
 namespace server {
 
 graph_message::graph_message()
@@ -12,6 +14,7 @@ graph_message::graph_message()
     , m_uid_to_node(std::make_unique<std::unordered_map<uid_t, ogdf::node>>())
     , m_uid_to_edge(std::make_unique<std::unordered_map<uid_t, ogdf::edge>>())
 {
+    this->update_index_order();
 }
 
 graph_message::graph_message(const graph_message &other)
@@ -51,6 +54,7 @@ graph_message::graph_message(const graph_message &other)
     }
 
     this->m_graph->allEdges(*(this->m_all_edges));
+    this->update_index_order();
 }
 
 graph_message::graph_message(const graphs::Graph &proto)
@@ -63,6 +67,8 @@ graph_message::graph_message(const graphs::Graph &proto)
     , m_uid_to_node(std::make_unique<std::unordered_map<uid_t, ogdf::node>>())
     , m_uid_to_edge(std::make_unique<std::unordered_map<uid_t, ogdf::edge>>())
 {
+    const job_phases::scope graph_phase{job_phases::GRAPH};
+
     for (auto it = proto.vertexlist().begin(); it != proto.vertexlist().end(); ++it)
     {
         const auto uid = it->uid();
@@ -92,6 +98,7 @@ graph_message::graph_message(const graphs::Graph &proto)
     }
 
     this->m_graph->allEdges(*(this->m_all_edges));
+    this->update_index_order();
 }
 
 graph_message::graph_message(const ogdf::Graph &graph, const ogdf::NodeArray<uid_t> &node_uids,
@@ -132,6 +139,7 @@ graph_message::graph_message(const ogdf::Graph &graph, const ogdf::NodeArray<uid
     }
 
     this->m_graph->allEdges(*(this->m_all_edges));
+    this->update_index_order();
 }
 
 graph_message::graph_message(std::unique_ptr<ogdf::Graph> graph,
@@ -165,6 +173,8 @@ graph_message::graph_message(std::unique_ptr<ogdf::Graph> graph,
     {
         this->m_uid_to_edge->insert({(*(this->m_edge_uids))[edge], edge});
     }
+
+    this->update_index_order();
 }
 
 graph_message &graph_message::operator=(const graph_message &other)
@@ -206,6 +216,7 @@ graph_message &graph_message::operator=(const graph_message &other)
     }
 
     this->m_graph->allEdges(*(this->m_all_edges));
+    this->update_index_order();
 
     // Make sure attribute maps are empty before copying contents
     this->m_uid_to_node->clear();
@@ -292,6 +303,16 @@ const ogdf::Array<ogdf::edge> &graph_message::all_edges() const
     return *(this->m_all_edges);
 }
 
+bool graph_message::has_ordered_node_indices() const
+{
+    return this->m_ordered_node_indices;
+}
+
+bool graph_message::has_ordered_edge_indices() const
+{
+    return this->m_ordered_edge_indices;
+}
+
 uid_t graph_message::make_uid() const
 {
     using namespace std::chrono;
@@ -299,4 +320,21 @@ uid_t graph_message::make_uid() const
     return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
 }
 
+void graph_message::update_index_order()
+{
+    const auto is_ordered = [](const auto &all_elements) {
+        for (int idx = 0; idx < all_elements.size(); ++idx)
+        {
+            if (all_elements[idx]->index() != idx)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    this->m_ordered_node_indices = is_ordered(*(this->m_all_nodes));
+    this->m_ordered_edge_indices = is_ordered(*(this->m_all_edges));
+}
+
 }  // namespace server
@@ -19,12 +19,16 @@ node_coordinates::node_coordinates(const graphs::VertexCoordinates &proto_coords
 graphs::VertexCoordinates node_coordinates::as_proto() const
 {
     graphs::VertexCoordinates proto;
+    this->to_proto(proto);
 
+    return proto;
+}
+
+void node_coordinates::to_proto(graphs::VertexCoordinates &proto) const
+{
     proto.set_x(this->m_x);
     proto.set_y(this->m_y);
     proto.set_z(this->m_z);
-
-    return proto;
 }
 
 }  // namespace server
@@ -0,0 +1,256 @@
+#include <persistence/blob_store.hpp>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+#include <config/config.hpp>
+
+namespace server {
+
+namespace {
+    [[noreturn]] void throw_errno(const std::string &what)
+    {
+        throw std::system_error{errno, std::generic_category(), what};
+    }
+
+    /// Writes all data, retrying on partial writes and interrupts
+    void write_all(int fd, const std::byte *data, size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw_errno("Could not write blob");
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    /// Makes a rename within the directory durable
+    void sync_directory(const std::filesystem::path &directory)
+    {
+        const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+}  // namespace
+
+mapped_blob::mapped_blob(const std::filesystem::path &path)
+    : mapped_blob{[&path] {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw_errno("Could not open blob " + path.string());
+        }
+        return fd;
+    }()}
+{
+}
+
+mapped_blob::mapped_blob(int fd)
+    : m_fd{fd}
+{
+    struct stat st;
+    if (::fstat(m_fd, &st) != 0)
+    {
+        const int error = errno;
+        ::close(m_fd);
+        throw std::system_error{error, std::generic_category(), "Could not stat blob"};
+    }
+
+    // Empty files can not be mapped
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size > 0)
+    {
+        void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (data == MAP_FAILED)
+        {
+            const int error = errno;
+            ::close(m_fd);
+            throw std::system_error{error, std::generic_category(), "Could not map blob"};
+        }
+        // Payloads are parsed or sent front to back
+        ::madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<std::byte *>(data);
+    }
+}
+
+mapped_blob::mapped_blob(mapped_blob &&rhs) noexcept
+    : m_fd{std::exchange(rhs.m_fd, -1)}
+    , m_data{std::exchange(rhs.m_data, nullptr)}
+    , m_size{std::exchange(rhs.m_size, 0)}
+{
+}
+
+mapped_blob &mapped_blob::operator=(mapped_blob &&rhs) noexcept
+{
+    // The previous mapping is released by rhs
+    std::swap(m_fd, rhs.m_fd);
+    std::swap(m_data, rhs.m_data);
+    std::swap(m_size, rhs.m_size);
+    return *this;
+}
+
+mapped_blob::~mapped_blob()
+{
+    if (m_data)
+    {
+        ::munmap(m_data, m_size);
+    }
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+blob_store::pending_blob::pending_blob(const blob_store &store, std::filesystem::path temporary,
+                                       int fd)
+    : m_store{store}
+    , m_temporary{std::move(temporary)}
+    , m_fd{fd}
+    , m_digest{EVP_MD_CTX_new()}
+{
+    if (!m_digest || EVP_DigestInit_ex(m_digest.get(), EVP_sha256(), nullptr) != 1)
+    {
+        ::close(m_fd);
+        ::unlink(m_temporary.c_str());
+        throw std::runtime_error{"Could not initialize SHA-256"};
+    }
+}
+
+blob_store::pending_blob::pending_blob(pending_blob &&rhs) noexcept
+    : m_store{rhs.m_store}
+    , m_temporary{std::move(rhs.m_temporary)}
+    , m_fd{std::exchange(rhs.m_fd, -1)}
+    , m_digest{std::move(rhs.m_digest)}
+    , m_hash{std::move(rhs.m_hash)}
+    , m_size{rhs.m_size}
+    , m_published{std::exchange(rhs.m_published, true)}
+{
+}
+
+blob_store::pending_blob::~pending_blob()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+    if (!m_published)
+    {
+        ::unlink(m_temporary.c_str());
+    }
+}
+
+void blob_store::pending_blob::append(const std::byte *data, size_t size)
+{
+    write_all(m_fd, data, size);
+    EVP_DigestUpdate(m_digest.get(), data, size);
+    m_size += size;
+}
+
+void blob_store::pending_blob::finish()
+{
+    if (::fsync(m_fd) != 0)
+    {
+        throw_errno("Could not flush blob");
+    }
+    ::close(m_fd);
+    m_fd = -1;
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+    EVP_DigestFinal_ex(m_digest.get(), digest, &digest_size);
+
+    static constexpr const char HEX[] = "0123456789abcdef";
+    m_hash.clear();
+    m_hash.reserve(2 * digest_size);
+    for (unsigned int i = 0; i < digest_size; ++i)
+    {
+        m_hash.push_back(HEX[digest[i] >> 4]);
+        m_hash.push_back(HEX[digest[i] & 0xf]);
+    }
+}
+
+void blob_store::pending_blob::publish()
+{
+    const auto target = m_store.path(m_hash);
+    std::filesystem::create_directories(target.parent_path());
+    std::filesystem::rename(m_temporary, target);
+    m_published = true;
+    sync_directory(target.parent_path());
+}
+
+blob_store::blob_store(std::filesystem::path root, size_t threshold)
+    : m_root{std::move(root)}
+    , m_threshold{threshold}
+{
+    // Temporary files are kept on the same file system, so they can be renamed atomically
+    std::filesystem::create_directories(m_root / "tmp");
+}
+
+std::shared_ptr<const blob_store> blob_store::configured()
+{
+    static const std::shared_ptr<const blob_store> store = []() -> std::shared_ptr<blob_store> {
+        const auto &path = config()[config_options::BLOB_STORE_PATH].as<std::string>();
+        if (path.empty())
+        {
+            return nullptr;
+        }
+        return std::make_shared<blob_store>(
+            path, config()[config_options::BLOB_STORE_THRESHOLD].as<size_t>());
+    }();
+    return store;
+}
+
+blob_store::pending_blob blob_store::create() const
+{
+    std::string temporary = (m_root / "tmp" / "blob-XXXXXX").string();
+    const int fd = ::mkostemp(temporary.data(), O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw_errno("Could not create blob in " + m_root.string());
+    }
+    return pending_blob{*this, std::move(temporary), fd};
+}
+
+blob_store::pending_blob blob_store::write(std::basic_string_view<std::byte> data) const
+{
+    auto blob = create();
+    blob.append(data.data(), data.size());
+    blob.finish();
+    return blob;
+}
+
+mapped_blob blob_store::map(const std::string &hash) const
+{
+    return mapped_blob{path(hash)};
+}
+
+void blob_store::remove(const std::string &hash) const
+{
+    std::error_code error;
+    std::filesystem::remove(path(hash), error);
+}
+
+std::filesystem::path blob_store::path(const std::string &hash) const
+{
+    // Split into subdirectories by the first byte, so no directory grows too large
+    return m_root / hash.substr(0, 2) / hash.substr(2);
+}
+
+}  // namespace server
@@ -0,0 +1,239 @@
+#include <persistence/database_pool.hpp>
+
+#include <boost/asio/post.hpp>
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include <config/config.hpp>
+
+namespace server {
+
+database_pool::lease::lease(std::unique_ptr<database_wrapper> database)
+    : m_database{std::move(database)}
+{
+}
+
+database_pool::lease &database_pool::lease::operator=(lease &&rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        if (m_database)
+        {
+            database_pool::instance().release(std::move(m_database));
+        }
+        m_database = std::move(rhs.m_database);
+    }
+    return *this;
+}
+
+database_pool::lease::~lease()
+{
+    if (m_database)
+    {
+        database_pool::instance().release(std::move(m_database));
+    }
+}
+
+database_pool &database_pool::instance()
+{
+    static database_pool instance{
+        get_db_connection_string(), config()[config_options::DB_POOL_MIN_SIZE].as<size_t>(),
+        config()[config_options::DB_POOL_MAX_SIZE].as<size_t>(),
+        std::chrono::seconds{config()[config_options::DB_POOL_CHECK_INTERVAL].as<int64_t>()},
+        std::chrono::seconds{config()[config_options::DB_POOL_IDLE_TIMEOUT].as<int64_t>()}};
+    return instance;
+}
+
+database_pool::database_pool(std::string connection_string, size_t min_size, size_t max_size,
+                             std::chrono::seconds check_interval,
+                             std::chrono::seconds idle_timeout)
+    : m_connection_string{std::move(connection_string)}
+    , m_min_size{std::min(min_size, std::max(max_size, size_t{1}))}
+    , m_max_size{std::max(max_size, size_t{1})}
+    , m_check_interval{check_interval}
+    , m_idle_timeout{idle_timeout}
+    , m_workers{m_max_size, m_max_size}
+{
+    // Open the minimum number of connections up front, so the first requests do not have to. The
+    // pool may be created by a coroutine, so they are opened on the database threads.
+    m_size = m_min_size;
+    for (size_t i = 0; i < m_min_size; ++i)
+    {
+        m_workers.try_submit([this] {
+            try
+            {
+                release(std::make_unique<database_wrapper>(m_connection_string,
+                                                           blob_store::configured()));
+            }
+            catch (const std::exception &error)
+            {
+                std::cout << "[DATABASE] Could not open pooled connection: " << error.what()
+                          << '\n';
+                discard();
+            }
+        });
+    }
+}
+
+database_pool::lease database_pool::acquire(boost::asio::yield_context &yield,
+                                            const boost::asio::any_io_executor &executor)
+{
+    idle_connection taken;
+    std::shared_ptr<boost::asio::steady_timer> signal;
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (take(taken))
+            {
+                break;
+            }
+
+            if (!signal)
+            {
+                signal = std::make_shared<boost::asio::steady_timer>(executor);
+            }
+            m_waiters.push_back(signal);
+        }
+
+        // Returned connections are signalled on the executor of this coroutine, so the signal can
+        // not get lost before the coroutine is suspended
+        boost::system::error_code error;
+        signal->expires_at(boost::asio::steady_timer::time_point::max());
+        signal->async_wait(yield[error]);
+    }
+
+    // Checking and opening connections block, which must not happen on the io threads. Each
+    // slot has at most one task queued, so the queue of the database threads never overflows.
+    bool prepared = false;
+    try
+    {
+        return m_workers.async_run(yield, [this, &taken, &prepared]() {
+            prepared = true;
+            return prepare(std::move(taken));
+        });
+    }
+    catch (...)
+    {
+        // The slot is still taken if the task could not be queued
+        if (!prepared && taken.database)
+        {
+            release(std::move(taken.database));
+        }
+        else if (!prepared)
+        {
+            discard();
+        }
+        throw;
+    }
+}
+
+database_pool::lease database_pool::acquire()
+{
+    idle_connection taken;
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_available.wait(lock, [&] {
+            return take(taken);
+        });
+    }
+
+    return prepare(std::move(taken));
+}
+
+bool database_pool::take(idle_connection &taken)
+{
+    // Close connections idle for too long, the oldest are at the front
+    const auto now = clock::now();
+    while (m_size > m_min_size && !m_idle.empty() &&
+           now - m_idle.front().since >= m_idle_timeout)
+    {
+        m_idle.pop_front();
+        --m_size;
+    }
+
+    if (!m_idle.empty())
+    {
+        taken = std::move(m_idle.back());
+        m_idle.pop_back();
+        return true;
+    }
+
+    if (m_size < m_max_size)
+    {
+        // The connection is opened by prepare(), outside of the lock
+        ++m_size;
+        taken = idle_connection{};
+        return true;
+    }
+
+    return false;
+}
+
+database_pool::lease database_pool::prepare(idle_connection taken)
+{
+    if (taken.database && clock::now() - taken.since >= m_check_interval &&
+        !taken.database->check_health())
+    {
+        std::cout << "[DATABASE] Replacing broken pooled connection\n";
+        taken.database.reset();
+    }
+
+    if (!taken.database)
+    {
+        try
+        {
+            taken.database =
+                std::make_unique<database_wrapper>(m_connection_string, blob_store::configured());
+        }
+        catch (...)
+        {
+            discard();
+            throw;
+        }
+    }
+
+    return lease{std::move(taken.database)};
+}
+
+void database_pool::release(std::unique_ptr<database_wrapper> database)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_idle.push_back({std::move(database), clock::now()});
+    }
+    notify_waiters();
+}
+
+void database_pool::discard()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        --m_size;
+    }
+    notify_waiters();
+}
+
+void database_pool::notify_waiters()
+{
+    std::vector<std::weak_ptr<boost::asio::steady_timer>> waiters;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        waiters.swap(m_waiters);
+    }
+    m_available.notify_one();
+
+    // Wake up all waiting coroutines, those not getting the connection wait again
+    for (auto &weak_signal : waiters)
+    {
+        if (auto signal = weak_signal.lock())
+        {
+            boost::asio::post(signal->get_executor(), [signal] {
+                signal->cancel();
+            });
+        }
+    }
+}
+
+}  // namespace server
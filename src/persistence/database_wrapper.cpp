@@ -1,17 +1,209 @@
 #include <persistence/database_wrapper.hpp>
 
 #include <charconv>
+#include <iostream>
 
+#include <networking/io/compression.hpp>
+#include <networking/requests/graph_delta.hpp>
+#include <persistence/payload_compression.hpp>
 #include <persistence/user.hpp>
+#include <persistence/user_cache.hpp>
 #include <scheduler/scheduler.hpp>
+#include <util/job_phases.hpp>
+#include <util/metrics.hpp>
 
 #include "networking/exceptions.hpp"
 #include "networking/utils.hpp"
 
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/util/time_util.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include "generic_container.pb.h"
 
 namespace server {
 
+namespace {
+    // Columns needed to build a <job_entry>, in the order it reads them
+    constexpr const char *JOB_COLUMNS =
+        "job_id, job_name, handler_type, user_id, time_received, starting_time, end_time, "
+        "ogdf_runtime, status, stdout_msg, error_msg, request_id, response_id ";
+
+    // Same as JOB_COLUMNS without the potentially large output of the algorithm, for listings
+    constexpr const char *JOB_LIST_COLUMNS =
+        "job_id, job_name, handler_type, user_id, time_received, starting_time, end_time, "
+        "ogdf_runtime, status, '' AS stdout_msg, '' AS error_msg, request_id, response_id ";
+
+    // The scheduler polls waiting jobs through the partial index jobs_waiting. Its predicate is
+    // only matched by generic plans of prepared statements if the status is written as a literal.
+    static_assert(graphs::StatusType::WAITING == 1,
+                  "Update the index jobs_waiting and the statement next_jobs");
+
+    // Columns needed to build a graphs::StatusSingle, the request type is taken from the request
+    // data. The transaction of the last change is the cursor of status changes.
+    constexpr const char *STATUS_COLUMNS =
+        "jobs.job_id, status, error_msg, data.type, handler_type, job_name, ogdf_runtime, "
+        "time_received, starting_time, end_time, change_xid, phase_times ";
+
+    // Deltas are resolved recursively, each reading its base job from the database. Update the
+    // message of the error in database_wrapper::resolve_delta() along with it.
+    constexpr const int MAX_DELTA_CHAIN = 16;
+
+    // Request data of jobs, which is kept in the partition of the month the job was received in
+    constexpr const char *JOIN_REQUEST =
+        "LEFT JOIN data ON request_id = data_id AND data.time_received = jobs.time_received ";
+
+    void set_timestamp(const pqxx::field &field, google::protobuf::Timestamp *timestamp)
+    {
+        // Only set if present, e.g. a waiting job has no starting time yet
+        if (field.is_null())
+        {
+            return;
+        }
+
+        auto time = field.as<std::string>();
+        utils::pqxx_timestampz_to_iso8601(time);
+        google::protobuf::util::TimeUtil::FromString(time, timestamp);
+    }
+
+    /// Graph references of a generic request
+    struct request_references {
+        std::optional<int> graph_id;
+        bool delta{false};
+    };
+
+    /// Finds the graph references of a generic request by scanning its top level fields, which
+    /// skips the (possibly huge) graph of requests without references
+    request_references find_references(const graphs::RequestContainer &container)
+    {
+        request_references references;
+        if (!container.request().Is<graphs::GenericRequest>())
+        {
+            return references;
+        }
+
+        using google::protobuf::internal::WireFormatLite;
+        static const auto *const descriptor = graphs::GenericRequest::descriptor();
+        static const int graph_id_number = descriptor->FindFieldByName("graphId")->number();
+        static const int delta_number = descriptor->FindFieldByName("delta")->number();
+
+        const auto &value = container.request().value();
+        google::protobuf::io::CodedInputStream in{reinterpret_cast<const uint8_t *>(value.data()),
+                                                  static_cast<int>(value.size())};
+
+        while (const uint32_t tag = in.ReadTag())
+        {
+            const int number = WireFormatLite::GetTagFieldNumber(tag);
+            if (number == graph_id_number &&
+                WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT)
+            {
+                uint32_t id;
+                if (!in.ReadVarint32(&id))
+                {
+                    break;
+                }
+                // The last occurrence wins, like when parsing
+                references.graph_id =
+                    id != 0 ? std::optional<int>{static_cast<int>(id)} : std::nullopt;
+                continue;
+            }
+
+            references.delta |= number == delta_number;
+            if (!WireFormatLite::SkipField(&in, tag))
+            {
+                break;
+            }
+        }
+
+        return references;
+    }
+
+    graphs::StatusSingle status_from_row(const pqxx::row &row)
+    {
+        graphs::StatusSingle status_single;
+        status_single.set_job_id(row[0].as<int>());
+        status_single.set_status(static_cast<graphs::StatusType>(row[1].as<int>()));
+        status_single.set_statusmessage(row[2].as<std::string>());
+        status_single.set_requesttype(row[3].is_null()
+                                          ? graphs::RequestType::UNDEFINED_REQUEST
+                                          : static_cast<graphs::RequestType>(row[3].as<int>()));
+        status_single.set_handlertype(row[4].as<std::string>());
+        status_single.set_jobname(row[5].as<std::string>());
+        status_single.set_ogdfruntime(row[6].as<size_t>());
+        set_timestamp(row[7], status_single.mutable_timereceived());
+        set_timestamp(row[8], status_single.mutable_startingtime());
+        set_timestamp(row[9], status_single.mutable_endtime());
+
+        // Only stored for jobs handled successfully, see <job_phases>
+        if (!row[11].is_null())
+        {
+            auto &phase_times = *status_single.mutable_phasetimes();
+            for (const auto &[phase, micros] : nlohmann::json::parse(row[11].c_str()).items())
+            {
+                phase_times[phase] = micros.get<uint64_t>();
+            }
+        }
+        return status_single;
+    }
+
+    /// Names of the statements prepared for every connection, see prepare_statements()
+    namespace statement {
+        constexpr const char *INSERT_JOB = "insert_job";
+        constexpr const char *INSERT_CHUNK = "insert_chunk";
+        constexpr const char *SET_DATA_BLOB = "set_data_blob";
+        constexpr const char *ADD_RESPONSE = "add_response";
+        constexpr const char *ADD_GRAPH = "add_graph";
+        constexpr const char *SET_STATUS = "set_status";
+        constexpr const char *SET_STARTED = "set_started";
+        constexpr const char *SET_FINISHED = "set_finished";
+        constexpr const char *NEXT_JOBS = "next_jobs";
+        constexpr const char *COUNT_WAITING = "count_waiting";
+        constexpr const char *REQUEST_DATA = "request_data";
+        constexpr const char *RESPONSE_DATA = "response_data";
+        constexpr const char *GRAPH_DATA = "graph_data";
+        constexpr const char *META_DATA = "meta_data";
+        constexpr const char *JOB_ENTRY = "job_entry";
+        constexpr const char *STATUS = "status";
+        constexpr const char *STATUS_CHANGES = "status_changes";
+        constexpr const char *USER_BY_NAME = "user_by_name";
+    }  // namespace statement
+
+    // Prepared statements are executed through the functions below, which record their duration
+    // by the name of the statement. Failed statements are not recorded.
+    histogram &query_duration(const char *name)
+    {
+        return metrics::instance().get_histogram("db_query_duration_seconds",
+                                                 "Time taken to execute prepared statements",
+                                                 {{"statement", name}});
+    }
+
+    template <typename... Args>
+    pqxx::result exec_prepared(pqxx::transaction_base &txn, const char *name, Args &&...args)
+    {
+        const stopwatch watch;
+        auto result = txn.exec_prepared(name, std::forward<Args>(args)...);
+        watch.record(query_duration(name));
+        return result;
+    }
+
+    template <typename... Args>
+    pqxx::row exec_prepared1(pqxx::transaction_base &txn, const char *name, Args &&...args)
+    {
+        const stopwatch watch;
+        auto row = txn.exec_prepared1(name, std::forward<Args>(args)...);
+        watch.record(query_duration(name));
+        return row;
+    }
+
+    template <typename... Args>
+    void exec_prepared0(pqxx::transaction_base &txn, const char *name, Args &&...args)
+    {
+        const stopwatch watch;
+        txn.exec_prepared0(name, std::forward<Args>(args)...);
+        watch.record(query_duration(name));
+    }
+}  // namespace
+
 job_entry::job_entry(const pqxx::row &db_row)
     : job_id{db_row[0].as<int>()}
     , job_name{db_row[1].as<std::string>()}
@@ -62,10 +254,72 @@ nlohmann::json job_entry::to_json() const
 }
 
 // Default static connection string
-database_wrapper::database_wrapper(const std::string &connection_string)
+database_wrapper::database_wrapper(const std::string &connection_string,
+                                   std::shared_ptr<const blob_store> blobs)
     : m_connection_string(connection_string)
     , m_database_connection(pqxx::connection(connection_string))
+    , m_blobs(std::move(blobs))
 {
+    prepare_statements();
+}
+
+const std::shared_ptr<const blob_store> &database_wrapper::blobs() const
+{
+    return m_blobs;
+}
+
+mapped_blob database_wrapper::map_blob(const std::string &hash) const
+{
+    if (!m_blobs)
+    {
+        throw std::runtime_error("Payload is kept in the blob store, which is not configured");
+    }
+    return m_blobs->map(hash);
+}
+
+std::vector<std::string> database_wrapper::collect_blobs(pqxx::transaction_base &txn)
+{
+    pqxx::result rows = txn.exec("DELETE FROM blobs WHERE refs <= 0 RETURNING hash");
+
+    std::vector<std::string> released;
+    released.reserve(rows.size());
+    for (const auto &row : rows)
+    {
+        released.push_back(row[0].as<std::string>());
+    }
+    return released;
+}
+
+void database_wrapper::remove_blobs(const std::vector<std::string> &hashes)
+{
+    if (!m_blobs || hashes.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        pqxx::work txn{m_database_connection};
+        for (const auto &hash : hashes)
+        {
+            // Claims the hash, an upload referencing the blob again waits until the file is gone.
+            // No row is inserted if the blob was referenced again since it was released.
+            if (!txn.exec_params("INSERT INTO blobs (hash, refs) VALUES ($1, 0) ON CONFLICT "
+                                 "(hash) DO NOTHING RETURNING hash",
+                                 hash)
+                     .empty())
+            {
+                m_blobs->remove(hash);
+                txn.exec_params0("DELETE FROM blobs WHERE hash = $1", hash);
+            }
+        }
+        txn.commit();
+    }
+    catch (const std::exception &e)
+    {
+        // The deletion already committed, the files are only left behind
+        std::cout << "[DATABASE] Could not remove released blobs: " << e.what() << std::endl;
+    }
 }
 
 void database_wrapper::check_connection()
@@ -73,41 +327,194 @@ void database_wrapper::check_connection()
     if (!(m_database_connection.is_open()))
     {
         m_database_connection = pqxx::connection(m_connection_string);
+        prepare_statements();
+    }
+}
+
+void database_wrapper::prepare_statements()
+{
+    // Statements used for every job or request are parsed and planned once per connection
+
+    // The job and its request reference each other, so both IDs are drawn up front to insert
+    // them in a single statement. Both rows get the same time_received from now(), which keeps
+    // them in the partitions of the same month. Chunks and blobs of the request are added in the
+    // same transaction and thus in the same month as well.
+    m_database_connection.prepare(
+        statement::INSERT_JOB,
+        "WITH ids AS (SELECT nextval('jobs_job_id_seq')::INT AS job_id, "
+        "nextval('data_data_id_seq')::INT AS data_id), "
+        "job AS (INSERT INTO jobs (job_id, handler_type, job_name, user_id, status, request_id) "
+        "SELECT job_id, $1::TEXT, $2::TEXT, $3::INT, $4::INT, data_id FROM ids), "
+        "request AS (INSERT INTO data (data_id, job_id, type, binary_data, compression, dict_id) "
+        "SELECT data_id, job_id, $5::INT, $6::BYTEA, $7::INT, $8::INT FROM ids) "
+        "SELECT job_id, data_id FROM ids");
+    m_database_connection.prepare(
+        statement::INSERT_CHUNK,
+        "INSERT INTO data_chunks (data_id, seq, chunk) VALUES ($1, $2, $3)");
+    m_database_connection.prepare(statement::SET_DATA_BLOB,
+                                  "UPDATE data SET binary_data = ''::bytea, blob_hash = $2, "
+                                  "blob_size = $3, compression = $4, dict_id = NULL "
+                                  "WHERE data_id = $1");
+
+    // The response is stored in the month of the job. If the job does no longer exist, neither
+    // data nor job are written and no row is returned. The phase times are only replaced if
+    // given, in the same update of the job.
+    m_database_connection.prepare(
+        statement::ADD_RESPONSE,
+        "WITH response AS (INSERT INTO data (job_id, time_received, type, binary_data, "
+        "compression, blob_hash, blob_size) SELECT job_id, time_received, $2, $3, $4, $6, $7 "
+        "FROM jobs WHERE job_id = $1 RETURNING data_id, time_received) "
+        "UPDATE jobs SET ogdf_runtime = $5, response_id = response.data_id, "
+        "phase_times = COALESCE($8::JSONB, phase_times) FROM response "
+        "WHERE jobs.job_id = $1 AND jobs.time_received = response.time_received "
+        "RETURNING jobs.job_id");
+
+    // The no-op update makes RETURNING yield the existing row if the graph is already stored
+    m_database_connection.prepare(
+        statement::ADD_GRAPH,
+        "INSERT INTO graphs (user_id, hash, graph_data) VALUES ($1, decode($2, 'hex'), $3) "
+        "ON CONFLICT (user_id, hash) DO UPDATE SET hash = EXCLUDED.hash RETURNING graph_id");
+
+    m_database_connection.prepare(
+        statement::SET_STATUS, "UPDATE jobs SET status = $1 WHERE job_id = $2 RETURNING job_id");
+    // Starting and finishing jobs return what the scheduler records in its metrics
+    m_database_connection.prepare(
+        statement::SET_STARTED,
+        "UPDATE jobs SET starting_time = now(), status = $1 WHERE job_id = $2 "
+        "RETURNING handler_type, (EXTRACT(EPOCH FROM now() - time_received) * 1000000)::BIGINT");
+    m_database_connection.prepare(statement::SET_FINISHED,
+                                  "UPDATE jobs SET status = $1, end_time=now(), stdout_msg = $2, "
+                                  "error_msg = $3 WHERE job_id = $4 RETURNING ogdf_runtime");
+    m_database_connection.prepare(statement::NEXT_JOBS,
+                                  "SELECT job_id, user_id FROM jobs WHERE status = 1 "
+                                  "ORDER BY time_received, job_id LIMIT $1");
+    m_database_connection.prepare(statement::COUNT_WAITING,
+                                  "SELECT count(*) FROM jobs WHERE status = 1");
+
+    // Large requests are uploaded in chunks or to the blob store, see <server::job_upload>. Data
+    // is joined on the time the job was received as well, so only the partition of its month is
+    // searched. The chunks of compressed requests are independent frames, which are decompressed
+    // at once after concatenating them.
+    m_database_connection.prepare(
+        statement::REQUEST_DATA,
+        "SELECT type, blob_hash, binary_data || COALESCE((SELECT string_agg(chunk, ''::bytea "
+        "ORDER BY seq) FROM data_chunks WHERE data_chunks.data_id = data.data_id AND "
+        "data_chunks.time_received = data.time_received), ''::bytea), compression, dict_id "
+        "FROM jobs JOIN data ON data_id = request_id AND data.time_received = jobs.time_received "
+        "WHERE jobs.job_id = $1 AND user_id = $2");
+    m_database_connection.prepare(
+        statement::RESPONSE_DATA,
+        "SELECT type, binary_data, compression, blob_hash FROM jobs JOIN data ON "
+        "data_id = response_id AND data.time_received = jobs.time_received "
+        "WHERE jobs.job_id = $1 AND user_id = $2");
+    m_database_connection.prepare(
+        statement::GRAPH_DATA,
+        "SELECT graph_data FROM graphs WHERE graph_id = $1 AND user_id = $2");
+    m_database_connection.prepare(statement::META_DATA,
+                                  std::string{"SELECT type, handler_type, job_name FROM jobs "} +
+                                      JOIN_REQUEST + "WHERE jobs.job_id = $1 AND user_id = $2");
+    m_database_connection.prepare(
+        statement::JOB_ENTRY,
+        std::string{"SELECT "} + JOB_COLUMNS + "FROM jobs WHERE job_id = $1 AND user_id = $2");
+
+    m_database_connection.prepare(statement::STATUS,
+                                  std::string{"SELECT "} + STATUS_COLUMNS +
+                                      "FROM jobs " + JOIN_REQUEST +
+                                      "WHERE jobs.job_id = $1 AND user_id = $2");
+    // Transaction IDs are assigned when a transaction starts writing, not in the order of their
+    // commits. Changes are only returned once every transaction with a lower ID finished, so a
+    // change committed late is never skipped by a cursor that already moved past its ID.
+    m_database_connection.prepare(
+        statement::STATUS_CHANGES,
+        std::string{"SELECT "} + STATUS_COLUMNS +
+            "FROM jobs " + JOIN_REQUEST + "WHERE user_id = $1 AND "
+            "change_xid < txid_snapshot_xmin(txid_current_snapshot()) AND "
+            "(change_xid, jobs.job_id) > ($2, $3) ORDER BY change_xid, jobs.job_id LIMIT $4");
+
+    m_database_connection.prepare(statement::USER_BY_NAME,
+                                  "SELECT * FROM users WHERE user_name = $1");
+}
+
+bool database_wrapper::check_health()
+{
+    try
+    {
+        check_connection();
+        pqxx::nontransaction txn{m_database_connection};
+        txn.exec("SELECT 1");
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
     }
 }
 
+pqxx::connection &database_wrapper::connection()
+{
+    check_connection();
+    return m_database_connection;
+}
+
 int database_wrapper::add_job(int user_id, const meta_data &meta, binary_data_view data)
 {
     check_connection();
     pqxx::work txn{m_database_connection};
 
-    pqxx::row row_job = txn.exec_params1("INSERT INTO jobs (handler_type, job_name, user_id, "
-                                         "status) VALUES ($1, $2, $3, $4) RETURNING job_id",
-                                         meta.handler_type, meta.job_name, user_id,
-                                         static_cast<int>(graphs::StatusType::WAITING));
-    int job_id;
-    if (!(row_job[0] >> job_id))
+    if (!m_blobs || !m_blobs->stores(data.size()))
     {
-        throw row_access_error("Can't access job_id");
+        auto &compression = payload_compression::instance();
+        const auto encoding = compression.current();
+        binary_data stored;
+        compression.encode(encoding, data, stored);
+
+        const int job_id =
+            insert_job(txn, user_id, meta, stored, encoding.codec, encoding.dict_id()).first;
+        txn.commit();
+        return job_id;
     }
 
+    auto blob = m_blobs->write(data);
+    const auto [job_id, data_id] = insert_job(txn, user_id, meta, {});
+    set_data_blob(txn, data_id, blob);
+    blob.publish();
+    txn.commit();
+
+    return job_id;
+}
+
+std::pair<int, int> database_wrapper::insert_job(pqxx::transaction_base &txn, int user_id,
+                                                 const meta_data &meta, binary_data_view data,
+                                                 graphs::CompressionType compression,
+                                                 std::optional<int> dict_id)
+{
     // We don't want to manually maintain an enum in Postgres. Thus, we represent the RequestType as
     // an int in the database.
-    pqxx::row row_request = txn.exec_params1(
-        "INSERT INTO data (job_id, type, binary_data) VALUES ($1, $2, $3) RETURNING data_id",
-        job_id, static_cast<int>(meta.request_type), data);
+    pqxx::row row = exec_prepared1(txn, statement::INSERT_JOB, meta.handler_type, meta.job_name,
+                                   user_id, static_cast<int>(graphs::StatusType::WAITING),
+                                   static_cast<int>(meta.request_type), data,
+                                   static_cast<int>(compression), dict_id);
 
-    int request_id;
-    if (!(row_request[0] >> request_id))
+    std::pair<int, int> ids;
+    if (!(row[0] >> ids.first && row[1] >> ids.second))
     {
-        throw row_access_error("Can't access request_id");
+        throw row_access_error("Can't access job_id");
     }
+    return ids;
+}
 
-    txn.exec_params0("UPDATE jobs SET request_id = $1 WHERE job_id = $2", request_id, job_id);
-
-    txn.commit();
+void database_wrapper::insert_chunk(pqxx::transaction_base &txn, int data_id, int seq,
+                                    binary_data_view chunk)
+{
+    exec_prepared0(txn, statement::INSERT_CHUNK, data_id, seq, chunk);
+}
 
-    return job_id;
+void database_wrapper::set_data_blob(pqxx::transaction_base &txn, int data_id,
+                                     const blob_store::pending_blob &blob)
+{
+    exec_prepared0(txn, statement::SET_DATA_BLOB, data_id, blob.hash(),
+                   static_cast<int64_t>(blob.size()),
+                   static_cast<int>(graphs::CompressionType::NONE));
 }
 
 void database_wrapper::set_status(int job_id, graphs::StatusType status)
@@ -116,66 +523,225 @@ void database_wrapper::set_status(int job_id, graphs::StatusType status)
 
     pqxx::work txn{m_database_connection};
 
-    txn.exec_params1("UPDATE jobs SET status = '$1' WHERE job_id = $2 RETURNING job_id",
-                     static_cast<int>(status), job_id);
+    exec_prepared1(txn, statement::SET_STATUS, static_cast<int>(status), job_id);
 
     txn.commit();
 }
 
 void database_wrapper::add_response(int job_id, graphs::RequestType type,
-                                    const graphs::ResponseContainer &response, long ogdf_time)
+                                    const graphs::ResponseContainer &response, long ogdf_time,
+                                    const std::function<nlohmann::json()> &phase_times)
 {
-    binary_data binary;
-    binary.resize(response.ByteSizeLong());
-    response.SerializeToArray(binary.data(), binary.size());
+    // Responses are stored in the default codec of the client protocol, so they can be sent to
+    // most clients as they are
+    constexpr auto codec = graphs::CompressionType::GZIP;
+
+    std::vector<char> compressed;
+    {
+        const job_phases::scope serialize_phase{job_phases::SERIALIZE};
+        compression::serialize(codec, response, compressed);
+    }
+    const binary_data_view binary(reinterpret_cast<const std::byte *>(compressed.data()),
+                                  compressed.size());
+
+    std::optional<job_phases::scope> store_phase{std::in_place, job_phases::STORE};
+
+    // Large responses are written to the blob store, which is published once referenced
+    std::optional<blob_store::pending_blob> blob;
+    if (m_blobs && m_blobs->stores(binary.size()))
+    {
+        blob.emplace(m_blobs->write(binary));
+    }
 
     check_connection();
 
     pqxx::work txn{m_database_connection};
 
-    // We don't want to manually maintain an enum in Postgres. Thus, we represent the RequestType as
-    // an int in the database.
-    pqxx::row row_res = txn.exec_params1(
-        "INSERT INTO data (job_id, type, binary_data) VALUES ($1, $2, $3) RETURNING data_id",
-        job_id, static_cast<int>(type), binary);
+    // Storing is measured until the statement writing the times, which is the last before commit
+    store_phase.reset();
+    const auto phases =
+        phase_times ? std::optional<std::string>{phase_times().dump()} : std::nullopt;
+
+    // Data and job are written in one statement. If the job does no longer exist, an error is
+    // thrown and we wont commit.
+    exec_prepared1(txn, statement::ADD_RESPONSE, job_id, static_cast<int>(type),
+                   blob ? binary_data_view{} : binary, static_cast<int>(codec), ogdf_time,
+                   blob ? std::optional<std::string>{blob->hash()} : std::nullopt,
+                   blob ? static_cast<int64_t>(blob->size()) : int64_t{0}, phases);
 
-    int result_id;
-    if (!(row_res[0] >> result_id))
+    if (blob)
     {
-        throw row_access_error("Can't access result_id");
+        blob->publish();
     }
+    txn.commit();
+}
+
+int database_wrapper::add_graph(int user_id, binary_data_view graph, const std::string &hash)
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
 
-    // If returned number of rows is zero, then the job does no longer exist, an error is thrown and we wont commit
-    txn.exec_params1(
-        "UPDATE jobs SET ogdf_runtime = $1, response_id = $2 WHERE job_id = $3 RETURNING job_id",
-        ogdf_time, result_id, job_id);
+    pqxx::row row = exec_prepared1(txn, statement::ADD_GRAPH, user_id, hash, graph);
+
+    int graph_id;
+    if (!(row[0] >> graph_id))
+    {
+        throw row_access_error("Can't access graph_id");
+    }
 
     txn.commit();
+
+    return graph_id;
 }
 
 std::pair<graphs::RequestType, graphs::RequestContainer> database_wrapper::get_request_data(
     int job_id, int user_id)
+{
+    return get_request_data(job_id, user_id, 0);
+}
+
+std::pair<graphs::RequestType, graphs::RequestContainer> database_wrapper::get_request_data(
+    int job_id, int user_id, int delta_depth)
+{
+    check_connection();
+
+    graphs::RequestType type;
+    auto request_container = graphs::RequestContainer();
+    compressed_data stored{};
+    bool ok = true;
+    {
+        pqxx::work txn{m_database_connection};
+
+        pqxx::row row = exec_prepared1(txn, statement::REQUEST_DATA, job_id, user_id);
+
+        type = static_cast<graphs::RequestType>(row[0].as<int>());
+
+        // Requests kept in the blob store are parsed from the mapped file without copying them
+        if (!row[1].is_null())
+        {
+            const auto blob = map_blob(row[1].as<std::string>());
+            ok = request_container.ParseFromArray(blob.data(), static_cast<int>(blob.size()));
+        }
+        else
+        {
+            stored.compression = static_cast<graphs::CompressionType>(row[3].as<int>());
+            stored.binary = row[2].as<binary_data>();
+            stored.dict_id = row[4].as<std::optional<int>>();
+        }
+    }
+
+    // Decompressed after the transaction, since the dictionary may have to be loaded first
+    if (!stored.binary.empty())
+    {
+        const auto binary = payload_compression::instance().decode(
+            stored.compression, stored.dict_id, std::move(stored.binary), *this);
+        ok = request_container.ParseFromArray(binary.data(), binary.size());
+    }
+
+    if (!ok)
+    {
+        throw std::runtime_error("Could not parse protobuff from request!");
+    }
+
+    const auto references = find_references(request_container);
+    if (references.delta)
+    {
+        resolve_delta(job_id, user_id, request_container, delta_depth);
+    }
+    else if (references.graph_id)
+    {
+        resolve_graph(*references.graph_id, user_id, request_container);
+    }
+
+    return {type, request_container};
+}
+
+binary_data database_wrapper::get_graph_data(int graph_id, int user_id)
 {
     check_connection();
 
     pqxx::work txn{m_database_connection};
+    pqxx::row row = exec_prepared1(txn, statement::GRAPH_DATA, graph_id, user_id);
 
-    pqxx::row row = txn.exec_params1("SELECT type, binary_data FROM data WHERE data_id = (SELECT "
-                                     "request_id FROM jobs WHERE job_id = $1 AND user_id = $2)",
-                                     job_id, user_id);
+    return row[0].as<binary_data>();
+}
 
-    const auto type = static_cast<graphs::RequestType>(row[0].as<int>());
-    auto binary = row[1].as<binary_data>();
+void database_wrapper::resolve_graph(int graph_id, int user_id,
+                                     graphs::RequestContainer &request_container)
+{
+    graphs::GenericRequest request;
+    if (!request_container.request().UnpackTo(&request))
+    {
+        throw std::runtime_error("Could not parse protobuff from request!");
+    }
 
-    auto request_container = graphs::RequestContainer();
-    if (request_container.ParseFromArray(binary.data(), binary.size()))
+    graphs::GenericRequest base;
+    const auto graph = get_graph_data(graph_id, user_id);
+    if (!base.ParseFromArray(graph.data(), graph.size()))
     {
-        return {type, request_container};
+        throw std::runtime_error("Could not parse protobuff from stored graph!");
     }
-    else
+
+    // The fields of the request (e.g. its costs) take precedence over the stored graph
+    merge_into_base(std::move(request), base);
+
+    request_container.mutable_request()->PackFrom(base);
+}
+
+void database_wrapper::resolve_delta(int job_id, int user_id,
+                                     graphs::RequestContainer &request_container, int delta_depth)
+{
+    graphs::GenericRequest request;
+    if (!request_container.request().UnpackTo(&request))
     {
         throw std::runtime_error("Could not parse protobuff from request!");
     }
+    const auto &delta = request.delta();
+
+    graphs::GenericRequest base;
+    switch (delta.base_case())
+    {
+        case graphs::GraphDelta::kBaseJobId: {
+            // Only earlier jobs can be referenced, so chains of deltas can not form a cycle
+            if (delta.basejobid() >= job_id)
+            {
+                throw request_parse_error("A delta can only be based on an earlier job",
+                                          request_type::GENERIC);
+            }
+            if (delta_depth + 1 >= MAX_DELTA_CHAIN)
+            {
+                throw request_parse_error("A delta can only be based on a chain of at most 15 "
+                                          "deltas",
+                                          request_type::GENERIC);
+            }
+
+            auto [base_type, base_container] =
+                get_request_data(delta.basejobid(), user_id, delta_depth + 1);
+            if (!base_container.request().UnpackTo(&base))
+            {
+                throw request_parse_error("The base job of a delta is no generic request",
+                                          request_type::GENERIC);
+            }
+            break;
+        }
+        case graphs::GraphDelta::kBaseGraphId: {
+            const auto graph = get_graph_data(delta.basegraphid(), user_id);
+            if (!base.ParseFromArray(graph.data(), graph.size()))
+            {
+                throw std::runtime_error("Could not parse protobuff from stored graph!");
+            }
+            break;
+        }
+        default:
+            throw request_parse_error("A delta needs a base job or graph", request_type::GENERIC);
+    }
+
+    apply_graph_delta(delta, base);
+
+    // The remaining fields of the request (e.g. its attributes) take precedence over the base
+    merge_into_base(std::move(request), base);
+
+    request_container.mutable_request()->PackFrom(base);
 }
 
 std::pair<graphs::RequestType, graphs::ResponseContainer> database_wrapper::get_response_data(
@@ -185,15 +751,27 @@ std::pair<graphs::RequestType, graphs::ResponseContainer> database_wrapper::get_
 
     pqxx::work txn{m_database_connection};
 
-    pqxx::row row = txn.exec_params1("SELECT type, binary_data FROM data WHERE data_id = (SELECT "
-                                     "response_id FROM jobs WHERE job_id = $1 AND user_id = $2)",
-                                     job_id, user_id);
+    pqxx::row row = exec_prepared1(txn, statement::RESPONSE_DATA, job_id, user_id);
 
     const auto type = static_cast<graphs::RequestType>(row[0].as<int>());
-    auto binary = row[1].as<binary_data>();
+    const auto codec = static_cast<graphs::CompressionType>(row[2].as<int>());
+
+    binary_data binary;
+    std::optional<mapped_blob> blob;
+    binary_data_view data;
+    if (!row[3].is_null())
+    {
+        data = blob.emplace(map_blob(row[3].as<std::string>())).view();
+    }
+    else
+    {
+        binary = row[1].as<binary_data>();
+        data = binary;
+    }
 
     auto response_container = graphs::ResponseContainer();
-    if (response_container.ParseFromArray(binary.data(), binary.size()))
+    if (compression::parse(codec, reinterpret_cast<const char *>(data.data()), data.size(),
+                           response_container))
     {
         return {type, response_container};
     }
@@ -203,20 +781,27 @@ std::pair<graphs::RequestType, graphs::ResponseContainer> database_wrapper::get_
     }
 }
 
-std::pair<graphs::RequestType, binary_data> database_wrapper::get_response_data_raw(int job_id,
-                                                                                    int user_id)
+compressed_data database_wrapper::get_response_data_raw(int job_id, int user_id)
 {
     check_connection();
 
     pqxx::work txn{m_database_connection};
 
-    pqxx::row row = txn.exec_params1("SELECT type, binary_data FROM data WHERE data_id = (SELECT "
-                                     "response_id FROM jobs WHERE job_id = $1 AND user_id = $2)",
-                                     job_id, user_id);
+    pqxx::row row = exec_prepared1(txn, statement::RESPONSE_DATA, job_id, user_id);
 
-    const auto type = static_cast<graphs::RequestType>(row[0].as<int>());
-    auto binary = row[1].as<binary_data>();
-    return {type, std::move(binary)};
+    compressed_data data{static_cast<graphs::RequestType>(row[0].as<int>()),
+                         static_cast<graphs::CompressionType>(row[2].as<int>()),
+                         {}};
+    if (!row[3].is_null())
+    {
+        // Mapped instead of copied, so it can be sent to the client from the page cache
+        data.blob = map_blob(row[3].as<std::string>());
+    }
+    else
+    {
+        data.binary = row[1].as<binary_data>();
+    }
+    return data;
 }
 
 size_t database_wrapper::get_job_data_size(int job_id, int user_id)
@@ -225,8 +810,10 @@ size_t database_wrapper::get_job_data_size(int job_id, int user_id)
 
     pqxx::work txn{m_database_connection};
     pqxx::result res = txn.exec_params(
-        "SELECT LENGTH(binary_data) as size FROM data LEFT JOIN "
-        "jobs ON data.job_id = jobs.job_id WHERE data.job_id = $1 AND jobs.user_id = $2",
+        "SELECT LENGTH(binary_data) + blob_size + COALESCE((SELECT SUM(LENGTH(chunk)) FROM "
+        "data_chunks WHERE data_chunks.data_id = data.data_id AND data_chunks.time_received = "
+        "data.time_received), 0) as size FROM jobs JOIN data ON data.job_id = jobs.job_id AND "
+        "data.time_received = jobs.time_received WHERE jobs.job_id = $1 AND jobs.user_id = $2",
         job_id, user_id);
 
     size_t data_size = 0;
@@ -242,7 +829,7 @@ std::vector<job_entry> database_wrapper::get_all_job_entries()
     check_connection();
 
     pqxx::work txn{m_database_connection};
-    pqxx::result rows = txn.exec_params("SELECT * FROM jobs");
+    pqxx::result rows = txn.exec_params(std::string{"SELECT "} + JOB_LIST_COLUMNS + "FROM jobs");
 
     std::vector<job_entry> jobs;
     for (const auto &row : rows)
@@ -264,12 +851,14 @@ std::optional<job_entry> database_wrapper::resolve_job_entry(std::string_view na
     if (errc == std::errc{})
     {
         // ID
-        rows = txn.exec_params("SELECT * FROM jobs WHERE job_id = $1", id);
+        rows = txn.exec_params(std::string{"SELECT "} + JOB_COLUMNS + "FROM jobs WHERE job_id = $1",
+                               id);
     }
     else
     {
         // Not ID but name
-        rows = txn.exec_params("SELECT * FROM jobs WHERE job_name = $1", name_or_id);
+        rows = txn.exec_params(
+            std::string{"SELECT "} + JOB_COLUMNS + "FROM jobs WHERE job_name = $1", name_or_id);
     }
 
     if (rows.size() != 1)
@@ -284,8 +873,7 @@ std::optional<job_entry> database_wrapper::get_job_entry(int job_id, int user_id
     check_connection();
 
     pqxx::work txn{m_database_connection};
-    pqxx::result result =
-        txn.exec_params("SELECT * FROM jobs WHERE job_id = $1 AND user_id = $2", job_id, user_id);
+    pqxx::result result = exec_prepared(txn, statement::JOB_ENTRY, job_id, user_id);
     if (result.size() != 1)
     {
         return std::nullopt;
@@ -298,8 +886,9 @@ std::optional<job_entry> database_wrapper::get_job_entry(std::string_view job_na
     check_connection();
 
     pqxx::work txn{m_database_connection};
-    pqxx::result result = txn.exec_params("SELECT * FROM jobs WHERE job_name = $1 AND user_id = $2",
-                                          job_name, user_id);
+    pqxx::result result = txn.exec_params(
+        std::string{"SELECT "} + JOB_COLUMNS + "FROM jobs WHERE job_name = $1 AND user_id = $2",
+        job_name, user_id);
     if (result.size() != 1)
     {
         return std::nullopt;
@@ -312,7 +901,8 @@ std::vector<job_entry> database_wrapper::get_job_entries(int user_id)
     check_connection();
 
     pqxx::work txn{m_database_connection};
-    pqxx::result rows = txn.exec_params("SELECT * FROM jobs WHERE user_id = $1", user_id);
+    pqxx::result rows = txn.exec_params(
+        std::string{"SELECT "} + JOB_COLUMNS + "FROM jobs WHERE user_id = $1", user_id);
 
     std::vector<job_entry> jobs;
     for (const auto &row : rows)
@@ -339,7 +929,9 @@ bool database_wrapper::delete_job(int job_id, int user_id)
     scheduler::instance().cancel_job(job_id, user_id);
 
     txn.exec_params0("DELETE FROM jobs WHERE job_id = $1", job_id);
+    const auto released = collect_blobs(txn);
     txn.commit();
+    remove_blobs(released);
 
     return true;
 }
@@ -349,10 +941,7 @@ meta_data database_wrapper::get_meta_data(int job_id, int user_id)
     check_connection();
 
     pqxx::work txn{m_database_connection};
-    pqxx::row row =
-        txn.exec_params1("SELECT type, handler_type, job_name FROM jobs LEFT JOIN data ON "
-                         "request_id = data_id WHERE jobs.job_id = $1 AND user_id = $2",
-                         job_id, user_id);
+    pqxx::row row = exec_prepared1(txn, statement::META_DATA, job_id, user_id);
 
     return meta_data{(row[0].is_null()) ? graphs::RequestType::UNDEFINED_REQUEST
                                         : static_cast<graphs::RequestType>(row[0].as<int>()),
@@ -366,9 +955,7 @@ std::vector<std::pair<int, int>> database_wrapper::get_next_jobs(int n)
 
     pqxx::work txn{m_database_connection};
 
-    pqxx::result rows = txn.exec_params("SELECT job_id, user_id FROM jobs WHERE STATUS = $1 "
-                                        "ORDER BY time_received ASC LIMIT $2",
-                                        static_cast<int>(graphs::StatusType::WAITING), n);
+    pqxx::result rows = exec_prepared(txn, statement::NEXT_JOBS, n);
 
     std::vector<std::pair<int, int>> available(rows.size());
 
@@ -389,71 +976,90 @@ std::vector<std::pair<int, int>> database_wrapper::get_next_jobs(int n)
     return available;
 }
 
-void database_wrapper::set_started(int job_id)
+int64_t database_wrapper::count_waiting_jobs()
 {
     check_connection();
 
     pqxx::work txn{m_database_connection};
 
-    txn.exec_params1("UPDATE jobs SET starting_time = now(), status = $1 WHERE job_id = $2 "
-                     "RETURNING job_id",
-                     static_cast<int>(graphs::StatusType::RUNNING), job_id);
+    return exec_prepared1(txn, statement::COUNT_WAITING)[0].as<int64_t>();
+}
+
+std::pair<std::string, std::chrono::microseconds> database_wrapper::set_started(int job_id)
+{
+    check_connection();
+
+    pqxx::work txn{m_database_connection};
+
+    pqxx::row row = exec_prepared1(txn, statement::SET_STARTED,
+                                   static_cast<int>(graphs::StatusType::RUNNING), job_id);
 
     txn.commit();
+
+    return {row[0].as<std::string>(), std::chrono::microseconds{row[1].as<int64_t>()}};
 }
 
-void database_wrapper::set_finished(int job_id, graphs::StatusType status, const std::string &out,
-                                    const std::string &err)
+std::chrono::microseconds database_wrapper::set_finished(int job_id, graphs::StatusType status,
+                                                         const std::string &out,
+                                                         const std::string &err)
 {
     check_connection();
 
     pqxx::work txn{m_database_connection};
 
-    txn.exec_params1("UPDATE jobs SET status = $1, end_time=now(), stdout_msg = $2, error_msg = $3 "
-                     " WHERE job_id = $4 RETURNING job_id",
-                     static_cast<int>(status), out, err, job_id);
+    pqxx::row row =
+        exec_prepared1(txn, statement::SET_FINISHED, static_cast<int>(status), out, err, job_id);
 
     txn.commit();
+
+    return std::chrono::microseconds{row[0].as<int64_t>()};
 }
 
 graphs::StatusSingle database_wrapper::get_status_data(int job_id, int user_id)
 {
-    graphs::StatusSingle status_single;
+    check_connection();
 
-    // Use meta data of the job to get the request type
-    std::optional<job_entry> job = get_job_entry(job_id, user_id);
-    if (!job)
+    pqxx::work txn{m_database_connection};
+    pqxx::result rows = exec_prepared(txn, statement::STATUS, job_id, user_id);
+    if (rows.empty())
     {
         throw row_access_error{"Job not found"};
     }
-    meta_data job_meta_data = get_meta_data(job->job_id, user_id);
 
-    status_single.set_job_id(job->job_id);
-    status_single.set_status(job->status);
-    status_single.set_statusmessage(std::move(job->error_msg));
-    status_single.set_requesttype(job_meta_data.request_type);
-    status_single.set_handlertype(std::move(job->handler_type));
-    status_single.set_jobname(std::move(job->job_name));
-    status_single.set_ogdfruntime(job->ogdf_runtime);
+    return status_from_row(rows[0]);
+}
 
-    // This is never supposed to be empty but we would rather be safe here
-    if (!job->time_received.empty())
-    {
-        google::protobuf::util::TimeUtil::FromString(job->time_received,
-                                                     status_single.mutable_timereceived());
-    }
-    if (!job->starting_time.empty())
+status_page database_wrapper::get_status_changes(int user_id, const status_cursor &after,
+                                                 size_t limit)
+{
+    check_connection();
+
+    // One more row than requested tells whether there are more
+    std::optional<int64_t> row_limit;
+    if (limit > 0)
     {
-        google::protobuf::util::TimeUtil::FromString(job->starting_time,
-                                                     status_single.mutable_startingtime());
+        row_limit = static_cast<int64_t>(limit) + 1;
     }
-    if (!job->end_time.empty())
+
+    pqxx::work txn{m_database_connection};
+    pqxx::result rows = exec_prepared(txn, statement::STATUS_CHANGES, user_id, after.change_xid,
+                                      after.job_id, row_limit);
+
+    status_page page;
+    page.cursor = after;
+    for (const auto &row : rows)
     {
-        google::protobuf::util::TimeUtil::FromString(job->end_time,
-                                                     status_single.mutable_endtime());
+        if (limit > 0 && page.states.size() == limit)
+        {
+            page.more = true;
+            break;
+        }
+
+        page.states.push_back(status_from_row(row));
+        page.cursor = status_cursor{row[10].as<int64_t>(), row[0].as<int>()};
     }
 
-    return status_single;
+    return page;
 }
 
 bool database_wrapper::create_user(user &u)
@@ -536,7 +1142,7 @@ std::optional<user> database_wrapper::get_user(const std::string &name)
     // (https://libpqxx.readthedocs.io/en/stable/a01383.html)
 
     pqxx::work txn{m_database_connection};
-    pqxx::result result = txn.exec_params("SELECT * FROM users WHERE user_name = $1", name);
+    pqxx::result result = exec_prepared(txn, statement::USER_BY_NAME, name);
 
     if (result.size() != 1)
     {
@@ -595,6 +1201,7 @@ bool database_wrapper::change_user_role(int user_id, user_role role)
     }
 
     txn.commit();
+    user_cache::instance().invalidate(user_id);
     return true;
 }
 
@@ -615,6 +1222,7 @@ bool database_wrapper::change_user_auth(int user_id, const std::string &pw_hash,
     }
 
     txn.commit();
+    user_cache::instance().invalidate(user_id);
     return true;
 }
 
@@ -632,10 +1240,31 @@ bool database_wrapper::set_user_blocked(int user_id, bool blocked)
 
     txn.exec_params0("UPDATE users SET blocked = $1 WHERE user_id = $2", blocked, user_id);
     txn.commit();
+    user_cache::instance().invalidate(user_id);
 
     return true;
 }
 
+bool database_wrapper::set_user_upload_limit(int user_id, std::optional<int64_t> upload_limit)
+{
+    check_connection();
+
+    pqxx::work txn{m_database_connection};
+
+    pqxx::result result =
+        txn.exec_params("UPDATE users SET upload_limit = $1 WHERE user_id = $2 RETURNING user_id",
+                        upload_limit, user_id);
+
+    if (result.size() != 1)
+    {
+        return false;
+    }
+
+    txn.commit();
+    user_cache::instance().invalidate(user_id);
+    return true;
+}
+
 bool database_wrapper::delete_user(int user_id)
 {
     check_connection();
@@ -657,30 +1286,152 @@ bool database_wrapper::delete_user(int user_id)
     scheduler::instance().cancel_user_jobs(user_id);
 
     txn.exec_params0("DELETE FROM users WHERE user_id = $1", user_id);
+    const auto released = collect_blobs(txn);
     txn.commit();
+    remove_blobs(released);
+    user_cache::instance().invalidate(user_id);
 
     return true;
 }
 
-bool database_wrapper::delete_user_jobs(int user_id)
+size_t database_wrapper::delete_user_jobs(int user_id, size_t limit)
 {
     check_connection();
     pqxx::work txn{m_database_connection};
 
-    if (pqxx::result rows =
-            txn.exec_params("SELECT user_id FROM users WHERE user_id = $1", user_id);
-        rows.size() != 1)
+    // Make sure the scheduler doesnt work on any of the jobs, including jobs not started yet
+    txn.exec_params0("UPDATE jobs SET status=$1 WHERE user_id=$2 AND status=$3",
+                     static_cast<int>(graphs::StatusType::ABORTED), user_id,
+                     static_cast<int>(graphs::StatusType::WAITING));
+    scheduler::instance().cancel_user_jobs(user_id);
+
+    // The primary key includes time_received, so the batch is deleted partition by partition
+    pqxx::result rows = txn.exec_params(
+        "DELETE FROM jobs WHERE (job_id, time_received) IN (SELECT job_id, time_received FROM "
+        "jobs WHERE user_id = $1 LIMIT $2) RETURNING job_id",
+        user_id, static_cast<int64_t>(limit));
+    const auto released = collect_blobs(txn);
+    txn.commit();
+    remove_blobs(released);
+
+    return rows.size();
+}
+
+void database_wrapper::create_job_partitions(int months_ahead)
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
+    txn.exec_params0("SELECT create_job_partitions(now(), now() + $1 * INTERVAL '1 month')",
+                     months_ahead);
+    txn.commit();
+}
+
+std::vector<std::string> database_wrapper::expire_job_partitions(int months, bool detach)
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
+
+    // The current month is kept in addition to the given number of full months
+    pqxx::result rows = txn.exec_params(
+        "SELECT expire_job_partitions(date_trunc('month', now()) - $1 * INTERVAL '1 month', $2)",
+        months, detach);
+    const auto released = collect_blobs(txn);
+    txn.commit();
+    remove_blobs(released);
+
+    std::vector<std::string> expired;
+    expired.reserve(rows.size());
+    for (const auto &row : rows)
     {
-        return false;
+        expired.push_back(row[0].as<std::string>());
     }
+    return expired;
+}
 
-    // Make sure the scheduler doesnt work on any of the jobs
-    scheduler::instance().cancel_user_jobs(user_id);
+std::vector<std::pair<std::string, int64_t>> database_wrapper::get_job_partitions()
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
 
-    txn.exec_params0("DELETE FROM jobs WHERE user_id = $1", user_id);
+    // The number of jobs is estimated from the statistics, counting would scan all partitions
+    pqxx::result rows =
+        txn.exec("SELECT relname, GREATEST(reltuples, 0)::BIGINT FROM pg_inherits JOIN pg_class "
+                 "ON pg_class.oid = inhrelid WHERE inhparent = 'jobs'::regclass ORDER BY relname");
+
+    std::vector<std::pair<std::string, int64_t>> partitions;
+    partitions.reserve(rows.size());
+    for (const auto &row : rows)
+    {
+        partitions.emplace_back(row[0].as<std::string>(), row[1].as<int64_t>());
+    }
+    return partitions;
+}
+
+binary_data database_wrapper::get_payload_dictionary(int dict_id)
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
+
+    pqxx::row row =
+        txn.exec_params1("SELECT dictionary FROM payload_dicts WHERE dict_id = $1", dict_id);
+    return row[0].as<binary_data>();
+}
+
+std::optional<std::pair<int, std::chrono::seconds>>
+database_wrapper::get_latest_payload_dictionary()
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
+
+    pqxx::result rows =
+        txn.exec("SELECT dict_id, EXTRACT(EPOCH FROM now() - trained_at)::BIGINT FROM "
+                 "payload_dicts ORDER BY dict_id DESC LIMIT 1");
+    if (rows.empty())
+    {
+        return std::nullopt;
+    }
+    return std::make_pair(rows[0][0].as<int>(), std::chrono::seconds{rows[0][1].as<int64_t>()});
+}
+
+int database_wrapper::add_payload_dictionary(binary_data_view dictionary)
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
+
+    pqxx::row row = txn.exec_params1(
+        "INSERT INTO payload_dicts (dictionary) VALUES ($1) RETURNING dict_id", dictionary);
     txn.commit();
 
-    return true;
+    return row[0].as<int>();
+}
+
+std::vector<compressed_data> database_wrapper::get_recent_request_payloads(size_t count)
+{
+    check_connection();
+    pqxx::work txn{m_database_connection};
+
+    // Recent jobs are found through the primary keys of the partitions, job IDs are increasing
+    pqxx::result rows = txn.exec_params(
+        "SELECT type, compression, dict_id, binary_data || COALESCE((SELECT chunk FROM "
+        "data_chunks WHERE data_chunks.data_id = data.data_id AND data_chunks.time_received = "
+        "data.time_received AND seq = 0), ''::bytea) "
+        "FROM jobs JOIN data ON data_id = request_id AND data.time_received = jobs.time_received "
+        "WHERE blob_hash IS NULL AND NOT EXISTS (SELECT 1 FROM data_chunks WHERE "
+        "data_chunks.data_id = data.data_id AND data_chunks.time_received = data.time_received "
+        "AND seq > 0) ORDER BY jobs.job_id DESC LIMIT $1",
+        static_cast<int64_t>(count));
+
+    std::vector<compressed_data> payloads;
+    payloads.reserve(rows.size());
+    for (const auto &row : rows)
+    {
+        auto &payload = payloads.emplace_back();
+        payload.type = static_cast<graphs::RequestType>(row[0].as<int>());
+        payload.compression = static_cast<graphs::CompressionType>(row[1].as<int>());
+        payload.dict_id = row[2].as<std::optional<int>>();
+        payload.binary = row[3].as<binary_data>();
+    }
+    return payloads;
 }
 
 }  // namespace server
@@ -0,0 +1,238 @@
+#include <persistence/job_maintenance.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <config/config.hpp>
+#include <persistence/database_pool.hpp>
+#include <persistence/payload_compression.hpp>
+#include <persistence/user_cache.hpp>
+#include <util/metrics.hpp>
+
+namespace server {
+
+namespace {
+    // Partitions exist a few months ahead, so inserts do not fail if the server was down a while
+    constexpr const int PARTITIONS_AHEAD = 2;
+
+    // Failed deletes are retried after this delay instead of the full interval
+    constexpr const std::chrono::seconds RETRY_DELAY{10};
+}  // namespace
+
+job_maintenance &job_maintenance::instance()
+{
+    static job_maintenance instance{
+        config()[config_options::JOB_RETENTION_MONTHS].as<int64_t>(),
+        parse_retention_mode(config()[config_options::JOB_RETENTION_MODE].as<std::string>()),
+        config()[config_options::JOB_DELETE_BATCH_SIZE].as<size_t>(),
+        std::chrono::seconds{config()[config_options::JOB_MAINTENANCE_INTERVAL].as<int64_t>()}};
+    return instance;
+}
+
+job_maintenance::job_maintenance(int64_t retention_months, retention_mode mode, size_t batch_size,
+                                 std::chrono::seconds interval)
+    : m_retention_months{retention_months}
+    , m_mode{mode}
+    , m_batch_size{std::max(batch_size, size_t{1})}
+    , m_interval{std::max(interval, std::chrono::seconds{1})}
+{
+    // The pool, the cache, the dictionaries and the metrics of queries are used by the thread
+    // until it is joined, so they must be destroyed after this
+    database_pool::instance();
+    user_cache::instance();
+    payload_compression::instance();
+    metrics::instance();
+}
+
+job_maintenance::~job_maintenance()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void job_maintenance::start()
+{
+    if (m_thread.joinable())
+    {
+        throw std::runtime_error("job_maintenance::start() called more than once!");
+    }
+    m_thread = std::thread([this] {
+        this->run_thread();
+    });
+}
+
+void job_maintenance::set_retention_months(int64_t months)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_retention_months = months;
+}
+
+int64_t job_maintenance::get_retention_months() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_retention_months;
+}
+
+void job_maintenance::set_retention_mode(retention_mode mode)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_mode = mode;
+}
+
+job_maintenance::retention_mode job_maintenance::get_retention_mode() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_mode;
+}
+
+std::vector<std::string> job_maintenance::run(database_wrapper &db)
+{
+    int64_t months;
+    retention_mode mode;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        months = m_retention_months;
+        mode = m_mode;
+    }
+
+    std::lock_guard<std::mutex> run_lock{m_run_mutex};
+    db.create_job_partitions(PARTITIONS_AHEAD);
+    if (months <= 0)
+    {
+        return {};
+    }
+
+    auto expired =
+        db.expire_job_partitions(static_cast<int>(months), mode == retention_mode::detach);
+    for (const auto &partition : expired)
+    {
+        std::cout << "[MAINTENANCE] " << (mode == retention_mode::detach ? "Detached" : "Dropped")
+                  << " partition " << partition << '\n';
+    }
+    return expired;
+}
+
+void job_maintenance::delete_user_jobs(int user_id, bool delete_user)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_deletes.push_back({user_id, delete_user});
+    }
+    m_wakeup.notify_all();
+}
+
+size_t job_maintenance::pending_deletes() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_deletes.size();
+}
+
+std::string_view job_maintenance::to_string(retention_mode mode)
+{
+    return mode == retention_mode::detach ? "detach" : "drop";
+}
+
+job_maintenance::retention_mode job_maintenance::parse_retention_mode(std::string_view name)
+{
+    if (name == "detach")
+    {
+        return retention_mode::detach;
+    }
+    if (name == "drop")
+    {
+        return retention_mode::drop;
+    }
+    throw std::invalid_argument{"Invalid retention mode, expected detach or drop"};
+}
+
+void job_maintenance::run_thread()
+{
+    auto next_run = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+    while (!m_stop)
+    {
+        if (std::chrono::steady_clock::now() >= next_run)
+        {
+            lock.unlock();
+            try
+            {
+                run(*database_pool::instance().acquire());
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "[MAINTENANCE] Could not maintain job partitions: " << e.what()
+                          << '\n';
+            }
+            try
+            {
+                payload_compression::instance().maintain(*database_pool::instance().acquire());
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "[MAINTENANCE] Could not maintain payload dictionaries: " << e.what()
+                          << '\n';
+            }
+            lock.lock();
+            next_run = std::chrono::steady_clock::now() + m_interval;
+            continue;
+        }
+
+        if (m_deletes.empty())
+        {
+            m_wakeup.wait_until(lock, next_run);
+            continue;
+        }
+
+        // One batch at a time, so stopping is not delayed by the deletes
+        const queued_delete queued = m_deletes.front();
+        lock.unlock();
+        bool done = false;
+        bool failed = false;
+        try
+        {
+            done = delete_batch(queued);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[MAINTENANCE] Could not delete jobs of user " << queued.user_id << ": "
+                      << e.what() << '\n';
+            failed = true;
+        }
+        lock.lock();
+
+        if (done)
+        {
+            m_deletes.pop_front();
+        }
+        else if (failed)
+        {
+            m_wakeup.wait_for(lock, RETRY_DELAY);
+        }
+    }
+}
+
+bool job_maintenance::delete_batch(const queued_delete &queued)
+{
+    auto db = database_pool::instance().acquire();
+    if (db->delete_user_jobs(queued.user_id, m_batch_size) == m_batch_size)
+    {
+        return false;
+    }
+
+    if (queued.delete_user)
+    {
+        db->delete_user(queued.user_id);
+    }
+    return true;
+}
+
+}  // namespace server
@@ -0,0 +1,114 @@
+#include <persistence/job_upload.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace server {
+
+namespace {
+    constexpr const size_t CHUNK_SIZE = 1 << 20;  // 1 MB
+}  // namespace
+
+job_upload::job_upload(int user_id, meta_data meta)
+    : m_user_id{user_id}
+    , m_meta{std::move(meta)}
+    , m_encoding{payload_compression::instance().current()}
+    , m_blobs{blob_store::configured()}
+{
+    m_buffer.reserve(CHUNK_SIZE);
+}
+
+void job_upload::append(boost::asio::yield_context &yield, const char *data, size_t size)
+{
+    m_size += size;
+    while (size > 0)
+    {
+        const size_t copied = std::min(size, CHUNK_SIZE - m_buffer.size());
+        m_buffer.append(reinterpret_cast<const std::byte *>(data), copied);
+        data += copied;
+        size -= copied;
+
+        if (m_buffer.size() == CHUNK_SIZE)
+        {
+            upload_spool::threads().async_run(yield, [this]() {
+                write_chunk(false);
+            });
+        }
+    }
+}
+
+int job_upload::commit(boost::asio::yield_context &yield, const database_pool::lease &database,
+                       const std::function<void(int)> &inserted)
+{
+    if (!m_buffer.empty())
+    {
+        upload_spool::threads().async_run(yield, [this]() {
+            write_chunk(true);
+        });
+    }
+    if (m_blob)
+    {
+        upload_spool::threads().async_run(yield, [this]() {
+            m_blob->finish();
+        });
+    }
+
+    // The request data itself is stored in data_chunks or the blob store
+    return database.async_run(yield, [&](database_wrapper &db) {
+        pqxx::work txn{db.connection()};
+        const auto [job_id, data_id] = db.insert_job(txn, m_user_id, m_meta, {}, m_encoding.codec,
+                                                     m_encoding.dict_id());
+
+        // Chunks are copied one at a time from the spool
+        off_t offset = 0;
+        for (size_t seq = 0; seq < m_chunk_sizes.size(); ++seq)
+        {
+            m_spool.read(offset, m_chunk_sizes[seq], m_compressed);
+            db.insert_chunk(txn, data_id, static_cast<int>(seq), m_compressed);
+            offset += static_cast<off_t>(m_chunk_sizes[seq]);
+        }
+
+        // The blob is referenced before it is published, see database_wrapper::remove_blobs()
+        if (m_blob)
+        {
+            db.set_data_blob(txn, data_id, *m_blob);
+            m_blob->publish();
+        }
+
+        if (inserted)
+        {
+            inserted(job_id);
+        }
+        txn.commit();
+        return job_id;
+    });
+}
+
+size_t job_upload::size() const
+{
+    return m_size;
+}
+
+void job_upload::write_chunk(bool last)
+{
+    // Decided on the first chunk, requests larger than a chunk always go to the blob store
+    if (m_chunk_sizes.empty() && !m_blob && m_blobs && (!last || m_blobs->stores(m_size)))
+    {
+        m_blob.emplace(m_blobs->create());
+    }
+
+    if (m_blob)
+    {
+        m_blob->append(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+        return;
+    }
+
+    m_compressed.clear();
+    payload_compression::instance().encode(m_encoding, m_buffer, m_compressed);
+    m_spool.write(m_compressed);
+    m_chunk_sizes.push_back(m_compressed.size());
+    m_buffer.clear();
+}
+
+}  // namespace server
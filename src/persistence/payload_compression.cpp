@@ -0,0 +1,303 @@
+#include <persistence/payload_compression.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef SPANNERS_WITH_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+#include <config/config.hpp>
+
+namespace server {
+
+namespace {
+#ifdef SPANNERS_WITH_ZSTD
+    // Dictionaries are trained on the start of requests only. They pay off for the first
+    // kilobytes of a payload, later data is compressed well by referencing earlier data anyway.
+    constexpr const size_t MAX_SAMPLE_SIZE = 32 << 10;  // 32 KB
+
+    // Fewer samples do not yield a useful dictionary, e.g. right after setting up the server
+    constexpr const size_t MIN_SAMPLES = 100;
+
+    struct zstd_deleter {
+        void operator()(ZSTD_CCtx *ctx) const { ZSTD_freeCCtx(ctx); }
+        void operator()(ZSTD_DCtx *ctx) const { ZSTD_freeDCtx(ctx); }
+        void operator()(ZSTD_CDict *dict) const { ZSTD_freeCDict(dict); }
+        void operator()(ZSTD_DDict *dict) const { ZSTD_freeDDict(dict); }
+    };
+
+    // Contexts are reused by the database threads, allocating them takes longer than compressing
+    // small payloads
+    ZSTD_CCtx *compression_context()
+    {
+        static thread_local std::unique_ptr<ZSTD_CCtx, zstd_deleter> ctx{ZSTD_createCCtx()};
+        return ctx.get();
+    }
+
+    ZSTD_DCtx *decompression_context()
+    {
+        static thread_local std::unique_ptr<ZSTD_DCtx, zstd_deleter> ctx{ZSTD_createDCtx()};
+        return ctx.get();
+    }
+#endif
+}  // namespace
+
+struct payload_dictionary {
+    int id;
+#ifdef SPANNERS_WITH_ZSTD
+    /// Only created if payloads are compressed, decompressing needs the digested dictionary only
+    std::unique_ptr<ZSTD_CDict, zstd_deleter> compress;
+    std::unique_ptr<ZSTD_DDict, zstd_deleter> decompress;
+#endif
+};
+
+namespace {
+    std::shared_ptr<const payload_dictionary> make_dictionary(int id, binary_data_view data,
+                                                              int level)
+    {
+        auto dictionary = std::make_shared<payload_dictionary>();
+        dictionary->id = id;
+#ifdef SPANNERS_WITH_ZSTD
+        if (level > 0)
+        {
+            dictionary->compress.reset(ZSTD_createCDict(data.data(), data.size(), level));
+        }
+        dictionary->decompress.reset(ZSTD_createDDict(data.data(), data.size()));
+        if ((level > 0 && !dictionary->compress) || !dictionary->decompress)
+        {
+            throw std::runtime_error("Could not load payload dictionary " + std::to_string(id));
+        }
+#else
+        static_cast<void>(data);
+        static_cast<void>(level);
+#endif
+        return dictionary;
+    }
+}  // namespace
+
+std::optional<int> payload_compression::encoding::dict_id() const
+{
+    return dictionary ? std::optional<int>{dictionary->id} : std::nullopt;
+}
+
+payload_compression &payload_compression::instance()
+{
+    // Programs which do not parse the config, like the handler processes, only decompress
+    static payload_compression instance{[] {
+        const auto &level = config(config_options::PAYLOAD_COMPRESSION_LEVEL);
+        const auto &interval = config(config_options::PAYLOAD_DICT_INTERVAL);
+        const auto &samples = config(config_options::PAYLOAD_DICT_SAMPLES);
+        const auto &size = config(config_options::PAYLOAD_DICT_SIZE);
+        return payload_compression{
+            level.empty() ? 0 : level.as<int>(),
+            std::chrono::seconds{interval.empty() ? 0 : interval.as<int64_t>()},
+            samples.empty() ? 0 : samples.as<size_t>(), size.empty() ? 0 : size.as<size_t>()};
+    }()};
+    return instance;
+}
+
+payload_compression::payload_compression(int level, std::chrono::seconds train_interval,
+                                         size_t samples, size_t dict_size)
+    : m_level{level}
+    , m_train_interval{train_interval}
+    , m_samples{samples}
+    , m_dict_size{dict_size}
+{
+}
+
+payload_compression::encoding payload_compression::current() const
+{
+    encoding enc;
+#ifdef SPANNERS_WITH_ZSTD
+    if (m_level > 0)
+    {
+        enc.codec = graphs::CompressionType::ZSTD;
+        std::lock_guard<std::mutex> lock{m_mutex};
+        enc.dictionary = m_current;
+    }
+#endif
+    return enc;
+}
+
+void payload_compression::encode(const encoding &enc, binary_data_view data,
+                                 binary_data &out) const
+{
+    // Empty payloads stay empty, e.g. the data entry of a request uploaded in chunks
+    if (enc.codec == graphs::CompressionType::NONE || data.empty())
+    {
+        out.append(data);
+        return;
+    }
+
+#ifdef SPANNERS_WITH_ZSTD
+    if (enc.codec == graphs::CompressionType::ZSTD)
+    {
+        const size_t old_size = out.size();
+        const size_t bound = ZSTD_compressBound(data.size());
+        out.resize(old_size + bound);
+
+        // Frames include the size of their content, so decode() allocates the output once
+        const size_t size =
+            enc.dictionary
+                ? ZSTD_compress_usingCDict(compression_context(), out.data() + old_size, bound,
+                                           data.data(), data.size(),
+                                           enc.dictionary->compress.get())
+                : ZSTD_compressCCtx(compression_context(), out.data() + old_size, bound,
+                                    data.data(), data.size(), m_level);
+        if (ZSTD_isError(size))
+        {
+            out.resize(old_size);
+            throw std::runtime_error(std::string{"Could not compress payload: "} +
+                                     ZSTD_getErrorName(size));
+        }
+        out.resize(old_size + size);
+        return;
+    }
+#endif
+
+    throw std::runtime_error("Unsupported payload compression");
+}
+
+binary_data payload_compression::decode(graphs::CompressionType codec,
+                                        std::optional<int> dict_id, binary_data data,
+                                        database_wrapper &db)
+{
+    if (codec == graphs::CompressionType::NONE || data.empty())
+    {
+        return data;
+    }
+
+#ifdef SPANNERS_WITH_ZSTD
+    if (codec == graphs::CompressionType::ZSTD)
+    {
+        const auto dictionary = dict_id ? load(*dict_id, db) : nullptr;
+
+        const auto size = ZSTD_findDecompressedSize(data.data(), data.size());
+        if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN)
+        {
+            throw std::runtime_error("Could not decompress payload: Invalid frames");
+        }
+
+        // Concatenated frames, e.g. of the chunks of an upload, are decompressed at once
+        binary_data out(size, std::byte{});
+        const size_t result =
+            dictionary ? ZSTD_decompress_usingDDict(decompression_context(), out.data(), size,
+                                                    data.data(), data.size(),
+                                                    dictionary->decompress.get())
+                       : ZSTD_decompressDCtx(decompression_context(), out.data(), size,
+                                             data.data(), data.size());
+        if (ZSTD_isError(result) || result != size)
+        {
+            throw std::runtime_error(std::string{"Could not decompress payload: "} +
+                                     (ZSTD_isError(result) ? ZSTD_getErrorName(result)
+                                                           : "Unexpected size"));
+        }
+        return out;
+    }
+#else
+    static_cast<void>(dict_id);
+    static_cast<void>(db);
+#endif
+
+    throw std::runtime_error("Unsupported payload compression");
+}
+
+void payload_compression::maintain(database_wrapper &db)
+{
+#ifdef SPANNERS_WITH_ZSTD
+    if (m_level <= 0)
+    {
+        return;
+    }
+
+    const auto latest = db.get_latest_payload_dictionary();
+    if (latest)
+    {
+        auto dictionary = load(latest->first, db);
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_current = std::move(dictionary);
+    }
+
+    if (m_train_interval <= std::chrono::seconds::zero() ||
+        (latest && latest->second < m_train_interval))
+    {
+        return;
+    }
+
+    // Samples are concatenated, ZDICT_trainFromBuffer() takes their sizes separately
+    binary_data samples;
+    std::vector<size_t> sizes;
+    for (auto &stored : db.get_recent_request_payloads(m_samples))
+    {
+        binary_data payload;
+        try
+        {
+            payload = decode(stored.compression, stored.dict_id, std::move(stored.binary), db);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[MAINTENANCE] Skipping sample for payload dictionary: " << e.what()
+                      << '\n';
+            continue;
+        }
+
+        if (!payload.empty())
+        {
+            const size_t size = std::min(payload.size(), MAX_SAMPLE_SIZE);
+            samples.append(payload, 0, size);
+            sizes.push_back(size);
+        }
+    }
+
+    if (sizes.size() < MIN_SAMPLES)
+    {
+        return;
+    }
+
+    binary_data trained(m_dict_size, std::byte{});
+    const size_t size = ZDICT_trainFromBuffer(trained.data(), trained.size(), samples.data(),
+                                              sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size))
+    {
+        std::cerr << "[MAINTENANCE] Could not train payload dictionary: "
+                  << ZDICT_getErrorName(size) << '\n';
+        return;
+    }
+    trained.resize(size);
+
+    const int dict_id = db.add_payload_dictionary(trained);
+    auto dictionary = make_dictionary(dict_id, trained, m_level);
+    std::cout << "[MAINTENANCE] Trained payload dictionary " << dict_id << " of " << size
+              << " bytes on " << sizes.size() << " requests\n";
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_loaded.emplace(dict_id, dictionary);
+    m_current = std::move(dictionary);
+#else
+    static_cast<void>(db);
+#endif
+}
+
+std::shared_ptr<const payload_dictionary> payload_compression::load(int dict_id,
+                                                                    database_wrapper &db)
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (const auto it = m_loaded.find(dict_id); it != m_loaded.end())
+        {
+            return it->second;
+        }
+    }
+
+    // Loaded outside of the lock, a dictionary loaded concurrently is simply loaded twice
+    auto dictionary = make_dictionary(dict_id, db.get_payload_dictionary(dict_id), m_level);
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_loaded.emplace(dict_id, std::move(dictionary)).first->second;
+}
+
+}  // namespace server
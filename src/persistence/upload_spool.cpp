@@ -0,0 +1,106 @@
+#include <persistence/upload_spool.hpp>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+#include <config/config.hpp>
+
+namespace server {
+
+namespace {
+    // Every upload waits for at most one write, so this only limits the number of uploads
+    // received at the same time
+    constexpr const size_t QUEUE_LIMIT = 1024;
+
+    [[noreturn]] void throw_errno(const std::string &what)
+    {
+        throw std::system_error{errno, std::generic_category(), what};
+    }
+}  // namespace
+
+upload_spool::~upload_spool()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+worker_pool &upload_spool::threads()
+{
+    static worker_pool pool{config()[config_options::UPLOAD_THREADS].as<size_t>(), QUEUE_LIMIT};
+    return pool;
+}
+
+void upload_spool::write(binary_data_view data)
+{
+    if (m_fd < 0)
+    {
+        m_fd = ::open(std::filesystem::temp_directory_path().c_str(),
+                      O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+        if (m_fd < 0)
+        {
+            throw_errno("Could not create spool file");
+        }
+    }
+
+    while (!data.empty())
+    {
+        const ssize_t written = ::write(m_fd, data.data(), data.size());
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw_errno("Could not write spool file");
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+        m_size += static_cast<size_t>(written);
+    }
+}
+
+void upload_spool::read(off_t offset, size_t size, binary_data &out) const
+{
+    out.resize(size);
+    size_t read = 0;
+    while (read < size)
+    {
+        const ssize_t count = ::pread(m_fd, out.data() + read, size - read,
+                                      offset + static_cast<off_t>(read));
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw_errno("Could not read spool file");
+        }
+        if (count == 0)
+        {
+            throw std::runtime_error{"Spool file is truncated"};
+        }
+        read += static_cast<size_t>(count);
+    }
+}
+
+mapped_blob upload_spool::map() const
+{
+    if (m_fd < 0)
+    {
+        return mapped_blob{};
+    }
+
+    const int fd = ::fcntl(m_fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw_errno("Could not map spool file");
+    }
+    return mapped_blob{fd};
+}
+
+}  // namespace server
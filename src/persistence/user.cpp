@@ -9,6 +9,7 @@ nlohmann::json user::to_json() const
     json_user["name"] = name;
     json_user["blocked"] = blocked;
     json_user["role"] = static_cast<int64_t>(role);
+    json_user["upload_limit"] = upload_limit ? nlohmann::json(*upload_limit) : nlohmann::json{};
     return json_user;
 }
 
@@ -16,13 +17,17 @@ user user::from_row(const pqxx::row &row)
 {
     binary_data pw = (!row["pw_hash"].is_null()) ? row["pw_hash"].as<binary_data>() : binary_data{};
     binary_data salt = (!row["salt"].is_null()) ? row["salt"].as<binary_data>() : binary_data{};
+    std::optional<int64_t> upload_limit = (!row["upload_limit"].is_null())
+                                              ? std::optional{row["upload_limit"].as<int64_t>()}
+                                              : std::nullopt;
 
     return user{row["user_id"].as<int>(),
                 row["user_name"].as<std::string>(),
                 std::move(pw),
                 std::move(salt),
                 row["blocked"].as<bool>(),
-                static_cast<user_role>(row["role"].as<int>())};
+                static_cast<user_role>(row["role"].as<int>()),
+                upload_limit};
 }
 
 }  // namespace server
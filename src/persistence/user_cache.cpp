@@ -0,0 +1,97 @@
+#include <persistence/user_cache.hpp>
+
+#include <algorithm>
+
+#include <config/config.hpp>
+
+namespace server {
+
+namespace {
+    constexpr const size_t MIN_SWEEP_SIZE = 1024;
+}  // namespace
+
+user_cache &user_cache::instance()
+{
+    // Programs which do not parse the config, like the examples, get a disabled cache
+    static user_cache instance{[] {
+        const auto &ttl = config(config_options::USER_CACHE_TTL);
+        return std::chrono::seconds{ttl.empty() ? 0 : ttl.as<int64_t>()};
+    }()};
+    return instance;
+}
+
+user_cache::user_cache(clock::duration ttl)
+    : m_ttl{ttl}
+    , m_sweep_size{MIN_SWEEP_SIZE}
+{
+}
+
+std::optional<user> user_cache::find(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    const auto it = m_users.find(name);
+    if (it == m_users.end() || it->second.expires <= clock::now())
+    {
+        return std::nullopt;
+    }
+    return it->second.cached;
+}
+
+uint64_t user_cache::generation()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_generation;
+}
+
+void user_cache::insert(const user &u, uint64_t generation)
+{
+    if (m_ttl <= clock::duration::zero())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (generation != m_generation)
+    {
+        // The user may have changed after it was loaded
+        return;
+    }
+
+    const auto now = clock::now();
+    m_users.insert_or_assign(u.name, entry{u, now + m_ttl});
+    m_names.insert_or_assign(u.user_id, u.name);
+
+    if (m_users.size() >= m_sweep_size)
+    {
+        for (auto it = m_users.begin(); it != m_users.end();)
+        {
+            if (it->second.expires <= now)
+            {
+                m_names.erase(it->second.cached.user_id);
+                it = m_users.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        m_sweep_size = std::max(MIN_SWEEP_SIZE, 2 * m_users.size());
+    }
+}
+
+void user_cache::invalidate(int user_id)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    ++m_generation;
+
+    const auto it = m_names.find(user_id);
+    if (it == m_names.end())
+    {
+        return;
+    }
+    m_users.erase(it->second);
+    m_names.erase(it);
+}
+
+}  // namespace server
@@ -2,6 +2,7 @@
 
 #include "networking/exceptions.hpp"
 #include "networking/utils.hpp"
+#include "util/job_phases.hpp"
 
 namespace server {
 
@@ -16,6 +17,8 @@ generic_request::generic_request(const graphs::GenericRequest &proto_request)
     , m_static_attributes{proto_request.staticattributes().begin(),
                           proto_request.staticattributes().end()}
 {
+    const job_phases::scope attributes_phase{job_phases::ATTRIBUTES};
+
     // --- Parse node and edge costs as well as node coordinates if they were given.
     if (proto_request.vertexcoordinates_size() != 0 &&
         proto_request.vertexcoordinates_size() != this->m_graph_message.graph().numberOfNodes())
@@ -66,6 +69,7 @@ generic_request::generic_request(const graphs::GenericRequest &proto_request)
     for (const auto &[name, attributes_msg] : proto_request.intattributes())
     {
         const auto type = attributes_msg.type();
+        check_attribute_size(type, attributes_msg.attributes_size());
         if (type == graphs::AttributeType::VERTEX)
         {
             auto [it, _] = this->m_node_int_attributes.emplace(
@@ -87,6 +91,7 @@ generic_request::generic_request(const graphs::GenericRequest &proto_request)
     for (const auto &[name, attributes_msg] : proto_request.doubleattributes())
     {
         const auto type = attributes_msg.type();
+        check_attribute_size(type, attributes_msg.attributes_size());
         if (type == graphs::AttributeType::VERTEX)
         {
             auto [it, _] = this->m_node_double_attributes.emplace(
@@ -106,6 +111,20 @@ generic_request::generic_request(const graphs::GenericRequest &proto_request)
     }
 }
 
+void generic_request::check_attribute_size(graphs::AttributeType type, int size) const
+{
+    // Like costs, attributes are either given for all elements or for none
+    const auto &graph = this->m_graph_message.graph();
+    if (size != 0 &&
+        ((type == graphs::AttributeType::VERTEX && size != graph.numberOfNodes()) ||
+         (type == graphs::AttributeType::EDGE && size != graph.numberOfEdges())))
+    {
+        throw request_parse_error(
+            "Attributes were provided but their number does not match the number of elements",
+            this->m_type);
+    }
+}
+
 const graph_message *generic_request::graph_message() const
 {
     return &(this->m_graph_message);
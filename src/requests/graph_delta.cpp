@@ -0,0 +1,299 @@
+#include "networking/requests/graph_delta.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "networking/exceptions.hpp"
+
+namespace server {
+
+namespace {
+
+    void fail(const char *msg)
+    {
+        throw request_parse_error(msg, request_type::GENERIC);
+    }
+
+    template <typename T>
+    void truncate(google::protobuf::RepeatedField<T> &values, int size)
+    {
+        values.Truncate(size);
+    }
+
+    template <typename T>
+    void truncate(google::protobuf::RepeatedPtrField<T> &values, int size)
+    {
+        values.DeleteSubrange(size, values.size() - size);
+    }
+
+    /// Removes all elements not marked to keep, preserving the order of the others
+    template <typename Repeated>
+    void compact(Repeated &values, const std::vector<bool> &keep)
+    {
+        int kept = 0;
+        for (int i = 0; i < values.size(); ++i)
+        {
+            if (keep[i])
+            {
+                if (kept != i)
+                {
+                    values.SwapElements(kept, i);
+                }
+                ++kept;
+            }
+        }
+        truncate(values, kept);
+    }
+
+    /// Compacts per element values, which are optional and only present if given for all elements
+    template <typename Repeated>
+    void compact_values(Repeated &values, const std::vector<bool> &keep)
+    {
+        if (values.size() == static_cast<int>(keep.size()))
+        {
+            compact(values, keep);
+        }
+    }
+
+    /// Appends the values of added elements, which are required if the base has per element values
+    template <typename Repeated>
+    void append_values(Repeated &values, const Repeated &added, int nof_elements, int nof_added)
+    {
+        if (values.size() == nof_elements && (nof_elements > 0 || added.size() > 0))
+        {
+            if (added.size() != nof_added)
+            {
+                fail("The number of values of added elements does not match the number of "
+                     "added elements");
+            }
+            values.MergeFrom(added);
+        }
+        else if (added.size() != 0)
+        {
+            fail("Values were given for added elements, but not for the other elements");
+        }
+    }
+
+    template <typename Attributes>
+    void compact_attributes(google::protobuf::Map<std::string, Attributes> &attributes,
+                            graphs::AttributeType type, const std::vector<bool> &keep)
+    {
+        for (auto &[name, attribute] : attributes)
+        {
+            if (attribute.type() == type)
+            {
+                compact_values(*attribute.mutable_attributes(), keep);
+            }
+        }
+    }
+
+    template <typename Attributes>
+    bool has_attributes(const google::protobuf::Map<std::string, Attributes> &attributes,
+                        graphs::AttributeType type)
+    {
+        for (const auto &[name, attribute] : attributes)
+        {
+            if (attribute.type() == type)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Elements>
+    std::unordered_map<int64_t, int> index_by_uid(const Elements &elements)
+    {
+        std::unordered_map<int64_t, int> indices;
+        indices.reserve(elements.size());
+        for (int i = 0; i < elements.size(); ++i)
+        {
+            indices.emplace(elements.Get(i).uid(), i);
+        }
+        return indices;
+    }
+
+}  // namespace
+
+void apply_graph_delta(const graphs::GraphDelta &delta, graphs::GenericRequest &base)
+{
+    auto &vertices = *(base.mutable_graph()->mutable_vertexlist());
+    auto &edges = *(base.mutable_graph()->mutable_edgelist());
+
+    // --- Removals
+    if (delta.removedvertexuids_size() > 0 || delta.removededgeuids_size() > 0)
+    {
+        const std::unordered_set<int64_t> removed_vertices(delta.removedvertexuids().begin(),
+                                                           delta.removedvertexuids().end());
+        const std::unordered_set<int64_t> removed_edges(delta.removededgeuids().begin(),
+                                                        delta.removededgeuids().end());
+
+        std::vector<bool> keep_vertex(vertices.size());
+        std::vector<int> new_index(vertices.size(), -1);
+        int nof_kept = 0;
+        for (int i = 0; i < vertices.size(); ++i)
+        {
+            keep_vertex[i] = removed_vertices.count(vertices.Get(i).uid()) == 0;
+            if (keep_vertex[i])
+            {
+                new_index[i] = nof_kept++;
+            }
+        }
+
+        std::vector<bool> keep_edge(edges.size());
+        for (int i = 0; i < edges.size(); ++i)
+        {
+            auto &edge = *(edges.Mutable(i));
+            if (edge.invertexindex() < 0 || edge.invertexindex() >= vertices.size() ||
+                edge.outvertexindex() < 0 || edge.outvertexindex() >= vertices.size())
+            {
+                fail("An edge of the base graph references an unknown vertex");
+            }
+
+            const int source = new_index[edge.invertexindex()];
+            const int target = new_index[edge.outvertexindex()];
+            keep_edge[i] = source >= 0 && target >= 0 && removed_edges.count(edge.uid()) == 0;
+
+            // Edges reference the vertices by their index, which changes by removing vertices
+            edge.set_invertexindex(source);
+            edge.set_outvertexindex(target);
+        }
+
+        compact_values(*base.mutable_vertexcoordinates(), keep_vertex);
+        compact_values(*base.mutable_vertexcosts(), keep_vertex);
+        compact_attributes(*base.mutable_intattributes(), graphs::AttributeType::VERTEX,
+                           keep_vertex);
+        compact_attributes(*base.mutable_doubleattributes(), graphs::AttributeType::VERTEX,
+                           keep_vertex);
+        compact(vertices, keep_vertex);
+
+        compact_values(*base.mutable_edgecosts(), keep_edge);
+        compact_attributes(*base.mutable_intattributes(), graphs::AttributeType::EDGE, keep_edge);
+        compact_attributes(*base.mutable_doubleattributes(), graphs::AttributeType::EDGE,
+                           keep_edge);
+        compact(edges, keep_edge);
+    }
+
+    // --- Additions
+    if (delta.addedvertices_size() > 0)
+    {
+        if (has_attributes(base.intattributes(), graphs::AttributeType::VERTEX) ||
+            has_attributes(base.doubleattributes(), graphs::AttributeType::VERTEX))
+        {
+            fail("Vertices can not be added to a graph with vertex attributes");
+        }
+
+        append_values(*base.mutable_vertexcoordinates(), delta.addedvertexcoordinates(),
+                      vertices.size(), delta.addedvertices_size());
+        append_values(*base.mutable_vertexcosts(), delta.addedvertexcosts(), vertices.size(),
+                      delta.addedvertices_size());
+        vertices.MergeFrom(delta.addedvertices());
+    }
+
+    const auto vertex_index = index_by_uid(vertices);
+    if (delta.addededges_size() > 0)
+    {
+        if (has_attributes(base.intattributes(), graphs::AttributeType::EDGE) ||
+            has_attributes(base.doubleattributes(), graphs::AttributeType::EDGE))
+        {
+            fail("Edges can not be added to a graph with edge attributes");
+        }
+
+        append_values(*base.mutable_edgecosts(), delta.addededgecosts(), edges.size(),
+                      delta.addededges_size());
+
+        edges.Reserve(edges.size() + delta.addededges_size());
+        for (const auto &added : delta.addededges())
+        {
+            const auto source = vertex_index.find(added.invertexuid());
+            const auto target = vertex_index.find(added.outvertexuid());
+            if (source == vertex_index.end() || target == vertex_index.end())
+            {
+                fail("An added edge references an unknown vertex");
+            }
+
+            auto *edge = edges.Add();
+            edge->set_uid(added.uid());
+            edge->set_invertexindex(source->second);
+            edge->set_outvertexindex(target->second);
+        }
+    }
+
+    // --- Changes
+    if (delta.changedvertexcoordinates_size() > 0)
+    {
+        if (base.vertexcoordinates_size() != vertices.size())
+        {
+            fail("Vertex coordinates were changed, but the graph has none");
+        }
+        for (const auto &[uid, coordinates] : delta.changedvertexcoordinates())
+        {
+            const auto it = vertex_index.find(uid);
+            if (it == vertex_index.end())
+            {
+                fail("Changed vertex coordinates reference an unknown vertex");
+            }
+            *(base.mutable_vertexcoordinates()->Mutable(it->second)) = coordinates;
+        }
+    }
+
+    if (delta.changedvertexcosts_size() > 0)
+    {
+        if (base.vertexcosts_size() != vertices.size())
+        {
+            fail("Vertex costs were changed, but the graph has none");
+        }
+        for (const auto &[uid, cost] : delta.changedvertexcosts())
+        {
+            const auto it = vertex_index.find(uid);
+            if (it == vertex_index.end())
+            {
+                fail("Changed vertex costs reference an unknown vertex");
+            }
+            base.set_vertexcosts(it->second, cost);
+        }
+    }
+
+    if (delta.changededgecosts_size() > 0)
+    {
+        if (base.edgecosts_size() != edges.size())
+        {
+            fail("Edge costs were changed, but the graph has none");
+        }
+        const auto edge_index = index_by_uid(edges);
+        for (const auto &[uid, cost] : delta.changededgecosts())
+        {
+            const auto it = edge_index.find(uid);
+            if (it == edge_index.end())
+            {
+                fail("Changed edge costs reference an unknown edge");
+            }
+            base.set_edgecosts(it->second, cost);
+        }
+    }
+}
+
+void merge_into_base(graphs::GenericRequest request, graphs::GenericRequest &base)
+{
+    if (request.has_graph())
+    {
+        fail("A request referencing a stored graph or base job can not contain a graph");
+    }
+    request.clear_delta();
+    request.clear_graphid();
+
+    // MergeFrom appends repeated fields, maps are merged by key
+    std::vector<const google::protobuf::FieldDescriptor *> fields;
+    request.GetReflection()->ListFields(request, &fields);
+    for (const auto *field : fields)
+    {
+        if (field->is_repeated() && !field->is_map())
+        {
+            base.GetReflection()->ClearField(&base, field);
+        }
+    }
+    base.MergeFrom(request);
+}
+
+}  // namespace server
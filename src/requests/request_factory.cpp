@@ -2,9 +2,19 @@
 
 #include "networking/requests/generic_request.hpp"
 #include "networking/requests/shortest_path_request.hpp"
+#include "util/job_phases.hpp"
 
 namespace server {
 
+namespace {
+    template <typename Message>
+    bool unpack(const graphs::RequestContainer &container, Message &proto_request)
+    {
+        const job_phases::scope parse_phase{job_phases::PARSE};
+        return container.request().UnpackTo(&proto_request);
+    }
+}  // namespace
+
 namespace request_factory {
     std::unique_ptr<abstract_request> build_request(graphs::RequestType type,
                                                     const graphs::RequestContainer &container)
@@ -14,7 +24,7 @@ namespace request_factory {
             case graphs::RequestType::SHORTEST_PATH: {
                 // We know that the container contains a shortest path request
                 graphs::ShortestPathRequest proto_request;
-                const bool ok = container.request().UnpackTo(&proto_request);
+                const bool ok = unpack(container, proto_request);
 
                 if (!ok)
                 {
@@ -28,7 +38,7 @@ namespace request_factory {
             case graphs::RequestType::GENERIC: {
                 graphs::GenericRequest proto_request;
 
-                if (const bool ok = container.request().UnpackTo(&proto_request); !ok)
+                if (const bool ok = unpack(container, proto_request); !ok)
                 {
                     return std::unique_ptr<abstract_request>(nullptr);
                 }
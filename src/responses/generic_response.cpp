@@ -24,12 +24,7 @@ generic_response::generic_response(
     {
         this->m_vertex_coords = google::protobuf::RepeatedPtrField<graphs::VertexCoordinates>{};
 
-        utils::serialize_node_attribute(
-            *node_coords, *graph, this->m_vertex_coords,
-            std::function<graphs::VertexCoordinates(const node_coordinates &)>(
-                [](const auto &coords) {
-                    return coords.as_proto();
-                }));
+        utils::serialize_node_attribute(*node_coords, *graph, this->m_vertex_coords);
     }
 
     if (edge_costs)
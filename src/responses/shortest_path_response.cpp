@@ -33,12 +33,7 @@ shortest_path_response::shortest_path_response(
 
     if (node_coords)
     {
-        utils::serialize_node_attribute(
-            *node_coords, *shortest_path, *(this->m_vertex_coords),
-            std::function<graphs::VertexCoordinates(const node_coordinates &)>(
-                [](const auto &coords) {
-                    return coords.as_proto();
-                }));
+        utils::serialize_node_attribute(*node_coords, *shortest_path, *(this->m_vertex_coords));
     }
 }
 
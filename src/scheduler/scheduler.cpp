@@ -1,12 +1,32 @@
 #include <boost/filesystem.hpp>
 #include <config/config.hpp>
+#include <networking/io/job_subscriptions.hpp>
+#include <persistence/blob_store.hpp>
 #include <scheduler/process_flags.hpp>
 #include <scheduler/scheduler.hpp>
 #include <stdexcept>
 #include <thread>
+#include <util/metrics.hpp>
+#include <util/tracing.hpp>
 
 namespace server {
 
+namespace {
+    gauge &waiting_jobs()
+    {
+        static gauge &jobs = metrics::instance().get_gauge(
+            "scheduler_waiting_jobs", "Jobs waiting to be scheduled, updated by the scheduler");
+        return jobs;
+    }
+
+    gauge &running_jobs()
+    {
+        static gauge &jobs =
+            metrics::instance().get_gauge("scheduler_running_jobs", "Running handler processes");
+        return jobs;
+    }
+}  // namespace
+
 scheduler &scheduler::instance()
 {
     static scheduler instance =
@@ -33,6 +53,10 @@ scheduler::scheduler(const std::string &exec_path, size_t process_limit, int64_t
     , m_sleep(std::chrono::milliseconds(config(config_options::SCHEDULER_SLEEP).as<int64_t>()))
     , m_thread()
 {
+    // Jobs still running are recorded when the scheduler is destroyed
+    metrics::instance();
+    tracing::instance();
+
     const boost::filesystem::path path{m_exec_path};
     if (!boost::filesystem::exists(path))
     {
@@ -155,23 +179,28 @@ void scheduler::run_thread()
                 {
                     case process_flags::SUCCESS: {
                         // Do nothing, in this case handling already updated database
-                        m_database.set_finished((*it)->job_id, graphs::StatusType::SUCCESS,
-                                                (*it)->data_cout.get(), (*it)->data_cerr.get());
+                        const auto ogdf_runtime = m_database.set_finished(
+                            (*it)->job_id, graphs::StatusType::SUCCESS, (*it)->data_cout.get(),
+                            (*it)->data_cerr.get());
+                        record_finished(**it, graphs::StatusType::SUCCESS, ogdf_runtime);
                     }
                     break;
 
                     case process_flags::SEGFAULT: {
                         m_database.set_finished((*it)->job_id, graphs::StatusType::FAILED,
                                                 (*it)->data_cout.get(), "Segfault");
+                        record_finished(**it, graphs::StatusType::FAILED, {});
                     }
                     break;
 
                     default: {
                         m_database.set_finished((*it)->job_id, graphs::StatusType::FAILED,
                                                 (*it)->data_cout.get(), (*it)->data_cerr.get());
+                        record_finished(**it, graphs::StatusType::FAILED, {});
                     }
                     break;
                 }
+                notify_status((*it)->job_id, (*it)->user_id);
 
                 it = m_processes.erase(it);
             }
@@ -180,6 +209,8 @@ void scheduler::run_thread()
                 (*it)->process->terminate();
 
                 m_database.set_finished((*it)->job_id, graphs::StatusType::ABORTED, "", "Timeout");
+                record_finished(**it, graphs::StatusType::ABORTED, {});
+                notify_status((*it)->job_id, (*it)->user_id);
 
                 it = m_processes.erase(it);
             }
@@ -194,25 +225,57 @@ void scheduler::run_thread()
         {
             auto new_jobs = m_database.get_next_jobs(m_process_limit - m_processes.size());
 
+            // Handler processes read and write large payloads in the blob store themselves
+            const auto blobs = blob_store::configured();
+
             for (const auto &job_info : new_jobs)
             {
-                m_database.set_started(job_info.first);
-                auto process =
-                    std::unique_ptr<job_process>(new job_process{job_info.first, job_info.second});
+                auto [handler_type, queue_wait] = m_database.set_started(job_info.first);
+                notify_status(job_info.first, job_info.second);
+                auto process = std::unique_ptr<job_process>(
+                    new job_process{job_info.first, job_info.second, std::move(handler_type)});
+                metrics::instance()
+                    .get_histogram("job_queue_wait_seconds",
+                                   "Time jobs waited from being received until they started",
+                                   {{"handler", process->handler_type}})
+                    .record(queue_wait);
+
                 process->start = std::chrono::steady_clock::now();
+
+                // The handler process appends its own spans to the trace of the job
+                auto &traces = tracing::instance();
+                process->trace = traces.take(job_info.first);
+                const uint64_t trace_id = process->trace ? process->trace->id : 0;
+                if (process->trace)
+                {
+                    traces.record(trace_id, "queue", process->trace->submitted, process->start);
+                }
+
                 process->process = std::make_unique<boost::process::child>(
                     m_exec_path,
-                    std::to_string(job_info.first),   //task_id
-                    std::to_string(job_info.second),  //user_id
+                    std::to_string(job_info.first),                   //task_id
+                    std::to_string(job_info.second),                  //user_id
                     m_database_connection_string,
-                    std::to_string(m_resource_limit),  //memory limit
+                    std::to_string(m_resource_limit),                 //memory limit
+                    blobs ? blobs->root().string() : std::string{},   //blob store path
+                    std::to_string(blobs ? blobs->threshold() : 0),   //blob store threshold
+                    trace_id != 0 ? traces.file() : std::string{},    //trace file
+                    std::to_string(trace_id),                         //trace id
                     boost::process::std_in.close(), boost::process::std_out > process->data_cout,
                     boost::process::std_err > process->data_cerr, process->ios);
+                metrics::instance()
+                    .get_histogram("job_spawn_duration_seconds",
+                                   "Time taken to spawn handler processes")
+                    .record(std::chrono::steady_clock::now() - process->start);
 
                 m_processes.insert(std::move(process));
             }
         }
 
+        // Counted once per round, which is as often as waiting jobs are looked for
+        waiting_jobs().set(m_database.count_waiting_jobs());
+        running_jobs().set(static_cast<int64_t>(m_processes.size()));
+
         auto tmp_sleep = m_sleep;
 
         lock.unlock();
@@ -237,6 +300,8 @@ void scheduler::stop_scheduler(bool force)
 
             m_database.set_finished(p->job_id, graphs::StatusType::ABORTED, "",
                                     "Global scheduler stop");
+            record_finished(*p, graphs::StatusType::ABORTED, {});
+            notify_status(p->job_id, p->user_id);
         }
         m_processes.clear();
     }
@@ -256,6 +321,8 @@ void scheduler::cancel_job(int job_id, int user_id)
 
                 m_database.set_finished((*it)->job_id, graphs::StatusType::ABORTED, "",
                                         "Aborted by Request");
+                record_finished(**it, graphs::StatusType::ABORTED, {});
+                notify_status((*it)->job_id, (*it)->user_id);
 
                 m_processes.erase(it);
             }
@@ -265,12 +332,77 @@ void scheduler::cancel_job(int job_id, int user_id)
     }
 
     m_database.set_finished(job_id, graphs::StatusType::ABORTED, "", "Preemptive abort");
+    if (const auto job_trace = tracing::instance().take(job_id))
+    {
+        record_aborted_waiting(*job_trace);
+    }
+    notify_status(job_id, user_id);
+}
+
+void scheduler::notify_status(int job_id, int user_id)
+{
+    // Only query the status if someone is listening
+    auto &subscriptions = job_subscriptions::instance();
+    if (subscriptions.has_subscribers(user_id))
+    {
+        subscriptions.notify(user_id, m_database.get_status_data(job_id, user_id));
+    }
+}
+
+void scheduler::record_finished(const job_process &process, graphs::StatusType status,
+                                std::chrono::microseconds ogdf_runtime)
+{
+    auto &registry = metrics::instance();
+    registry
+        .get_counter("jobs_finished_total", "Jobs finished by the scheduler",
+                     {{"status", graphs::StatusType_Name(status)}})
+        .add();
+    registry
+        .get_histogram("job_duration_seconds",
+                       "Time from spawning handler processes until they finished",
+                       {{"handler", process.handler_type}})
+        .record(std::chrono::steady_clock::now() - process.start);
+
+    // Only successful handler processes store the runtime of the algorithm
+    if (status == graphs::StatusType::SUCCESS)
+    {
+        registry
+            .get_histogram("handler_runtime_seconds",
+                           "Runtime of the algorithms as measured by the handler processes",
+                           {{"handler", process.handler_type}})
+            .record(ogdf_runtime);
+    }
+
+    if (process.trace)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const nlohmann::json status_name = graphs::StatusType_Name(status);
+        auto &traces = tracing::instance();
+        traces.record(process.trace->id, "process", process.start, now, {{"status", status_name}});
+        traces.end(process.trace->id, "job", now,
+                   {{"handler", process.handler_type}, {"status", status_name}});
+    }
+}
+
+void scheduler::record_aborted_waiting(const tracing::trace &job_trace)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const nlohmann::json status_name = graphs::StatusType_Name(graphs::StatusType::ABORTED);
+    auto &traces = tracing::instance();
+    traces.record(job_trace.id, "queue", job_trace.submitted, now, {{"status", status_name}});
+    traces.end(job_trace.id, "job", now, {{"status", status_name}});
 }
 
 void scheduler::cancel_user_jobs(int user_id)
 {
     std::lock_guard<std::mutex> lock_g(m_mutex);
 
+    // Waiting jobs of the user are aborted or deleted by the caller
+    for (const auto &taken : tracing::instance().take_user(user_id))
+    {
+        record_aborted_waiting(taken.second);
+    }
+
     for (auto it = m_processes.begin(); it != m_processes.end();)
     {
         if ((*it)->user_id == user_id)
@@ -279,7 +411,8 @@ void scheduler::cancel_user_jobs(int user_id)
             {
                 (*it)->process->terminate();
             }
-            m_processes.erase(it);
+            record_finished(**it, graphs::StatusType::ABORTED, {});
+            it = m_processes.erase(it);
         }
         else
         {
@@ -0,0 +1,56 @@
+#include <util/job_phases.hpp>
+
+namespace server {
+
+job_phases &job_phases::current()
+{
+    static thread_local job_phases phases;
+    return phases;
+}
+
+void job_phases::add(phase p, std::chrono::steady_clock::duration duration)
+{
+    m_durations[p] += std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+
+const char *job_phases::name(phase p)
+{
+    switch (p)
+    {
+        case LOAD:
+            return "load";
+        case PARSE:
+            return "parse";
+        case GRAPH:
+            return "graph";
+        case ATTRIBUTES:
+            return "attributes";
+        case PREPARE:
+            return "prepare";
+        case ALGORITHM:
+            return "algorithm";
+        case RESULT:
+            return "result";
+        case SERIALIZE:
+            return "serialize";
+        case STORE:
+            return "store";
+        default:
+            return "unknown";
+    }
+}
+
+nlohmann::json job_phases::to_json() const
+{
+    auto breakdown = nlohmann::json::object();
+    for (size_t p = 0; p < NOF_PHASES; ++p)
+    {
+        if (m_durations[p].count() > 0)
+        {
+            breakdown[name(static_cast<phase>(p))] = m_durations[p].count();
+        }
+    }
+    return breakdown;
+}
+
+}  // namespace server
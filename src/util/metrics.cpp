@@ -0,0 +1,240 @@
+#include <util/metrics.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace server {
+
+namespace {
+    constexpr const char *PREFIX = "spanners_";
+
+    /// Exponents of the exported bucket bounds of 2^k microseconds, from 16 us to about 19 hours
+    const std::vector<int> &bucket_bits()
+    {
+        static const std::vector<int> bits = [] {
+            std::vector<int> even;
+            for (int k = 4; k <= 36; k += 2)
+            {
+                even.push_back(k);
+            }
+            return even;
+        }();
+        return bits;
+    }
+
+    /// Renders label values without the braces, e.g. type="GENERIC",handler="dijkstra"
+    std::string render(metrics::labels label_values)
+    {
+        std::string rendered;
+        for (const auto &[name, value] : label_values)
+        {
+            if (!rendered.empty())
+            {
+                rendered += ',';
+            }
+            rendered.append(name);
+            rendered += "=\"";
+            for (const char c : value)
+            {
+                switch (c)
+                {
+                    case '\\':
+                        rendered += "\\\\";
+                        break;
+                    case '"':
+                        rendered += "\\\"";
+                        break;
+                    case '\n':
+                        rendered += "\\n";
+                        break;
+                    default:
+                        rendered += c;
+                }
+            }
+            rendered += '"';
+        }
+        return rendered;
+    }
+
+    /// Appends the labels of a series and an additional label, e.g. the bound of a bucket
+    void write_labels(std::ostream &out, const std::string &rendered, std::string_view extra = {})
+    {
+        if (rendered.empty() && extra.empty())
+        {
+            return;
+        }
+        out << '{' << rendered << (rendered.empty() || extra.empty() ? "" : ",") << extra << '}';
+    }
+
+    template <typename Family>
+    void write_header(std::ostream &out, const std::string &name, const Family &family,
+                      std::string_view type)
+    {
+        out << "# HELP " << PREFIX << name << ' ' << family.help << '\n';
+        out << "# TYPE " << PREFIX << name << ' ' << type << '\n';
+    }
+
+    std::string seconds(std::chrono::microseconds duration)
+    {
+        return std::to_string(std::chrono::duration<double>{duration}.count());
+    }
+}  // namespace
+
+void histogram::record(std::chrono::steady_clock::duration duration)
+{
+    const auto micros = static_cast<uint64_t>(
+        std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(),
+                          0));
+    m_buckets[bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(micros, std::memory_order_relaxed);
+}
+
+std::vector<uint64_t> histogram::counts_below(const std::vector<int> &bits) const
+{
+    // Recording continues meanwhile, so the total is taken from the same loads as the buckets
+    std::vector<uint64_t> counts;
+    counts.reserve(bits.size() + 1);
+
+    uint64_t seen = 0;
+    size_t i = 0;
+    for (const int bound_bits : bits)
+    {
+        // 2^bits is the lower bound of the first sub-bucket of its power of two
+        for (const size_t end = bucket(uint64_t{1} << bound_bits); i < end; ++i)
+        {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+        }
+        counts.push_back(seen);
+    }
+    for (; i < BUCKETS; ++i)
+    {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+    }
+    counts.push_back(seen);
+    return counts;
+}
+
+size_t histogram::bucket(uint64_t micros)
+{
+    if (micros < SUB_BUCKETS)
+    {
+        return static_cast<size_t>(micros);
+    }
+
+    // Durations of the same power of two share the shift, the top bits select the sub-bucket
+    const int bit_width = 64 - __builtin_clzll(micros);
+    if (bit_width > MAX_BITS)
+    {
+        return BUCKETS - 1;
+    }
+    const int shift = bit_width - SUB_BUCKET_BITS - 1;
+    return static_cast<size_t>(SUB_BUCKETS + shift * SUB_BUCKETS + (micros >> shift) -
+                               SUB_BUCKETS);
+}
+
+metrics &metrics::instance()
+{
+    static metrics instance;
+    return instance;
+}
+
+counter &metrics::get_counter(std::string_view name, std::string_view help, labels label_values)
+{
+    return get(m_counters, name, help, label_values);
+}
+
+gauge &metrics::get_gauge(std::string_view name, std::string_view help, labels label_values)
+{
+    return get(m_gauges, name, help, label_values);
+}
+
+histogram &metrics::get_histogram(std::string_view name, std::string_view help,
+                                  labels label_values)
+{
+    return get(m_histograms, name, help, label_values);
+}
+
+template <typename Metric>
+Metric &metrics::get(families<Metric> &all, std::string_view name, std::string_view help,
+                     labels label_values)
+{
+    const auto rendered = render(label_values);
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto it = all.find(name);
+    if (it == all.end())
+    {
+        it = all.emplace(std::string{name}, family<Metric>{std::string{help}, {}}).first;
+    }
+
+    auto &series = it->second.series;
+    auto metric = series.find(rendered);
+    if (metric == series.end())
+    {
+        metric = series.emplace(rendered, std::make_unique<Metric>()).first;
+    }
+    return *metric->second;
+}
+
+std::string metrics::to_prometheus() const
+{
+    std::ostringstream out;
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (const auto &[name, family] : m_counters)
+    {
+        write_header(out, name, family, "counter");
+        for (const auto &[labels, metric] : family.series)
+        {
+            out << PREFIX << name;
+            write_labels(out, labels);
+            out << ' ' << metric->value() << '\n';
+        }
+    }
+
+    for (const auto &[name, family] : m_gauges)
+    {
+        write_header(out, name, family, "gauge");
+        for (const auto &[labels, metric] : family.series)
+        {
+            out << PREFIX << name;
+            write_labels(out, labels);
+            out << ' ' << metric->value() << '\n';
+        }
+    }
+
+    for (const auto &[name, family] : m_histograms)
+    {
+        write_header(out, name, family, "histogram");
+        for (const auto &[labels, metric] : family.series)
+        {
+            // Durations are truncated to whole microseconds, so those recorded below a bound
+            // are the ones up to the bound
+            const auto &bits = bucket_bits();
+            const auto counts = metric->counts_below(bits);
+            for (size_t i = 0; i < bits.size(); ++i)
+            {
+                out << PREFIX << name << "_bucket";
+                write_labels(out, labels,
+                             "le=\"" + seconds(std::chrono::microseconds{int64_t{1} << bits[i]}) +
+                                 '"');
+                out << ' ' << counts[i] << '\n';
+            }
+            out << PREFIX << name << "_bucket";
+            write_labels(out, labels, "le=\"+Inf\"");
+            out << ' ' << counts.back() << '\n';
+
+            out << PREFIX << name << "_sum";
+            write_labels(out, labels);
+            out << ' ' << seconds(metric->sum()) << '\n';
+            out << PREFIX << name << "_count";
+            write_labels(out, labels);
+            out << ' ' << counts.back() << '\n';
+        }
+    }
+
+    return out.str();
+}
+
+}  // namespace server
@@ -0,0 +1,229 @@
+#include <util/tracing.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+namespace server {
+
+namespace {
+    // Traces are taken when jobs start or are aborted while waiting. Jobs which never reach
+    // the scheduler otherwise, e.g. when the server restarts, are bounded by this limit, jobs
+    // submitted beyond it are simply not followed to the scheduler.
+    constexpr const size_t MAX_PENDING = 100000;
+
+    int64_t micros(tracing::clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch())
+            .count();
+    }
+
+    std::string hex(uint64_t id)
+    {
+        static constexpr const char *DIGITS = "0123456789abcdef";
+        std::string rendered = "0x0000000000000000";
+        for (size_t i = rendered.size() - 1; id > 0; --i, id >>= 4)
+        {
+            rendered[i] = DIGITS[id & 0xF];
+        }
+        return rendered;
+    }
+
+    /// A line of the trace file. Nestable async events with a global ID are joined into one
+    /// track across processes.
+    std::string event(uint64_t trace_id, std::string_view name, char phase,
+                      tracing::clock::time_point time, const nlohmann::json &args)
+    {
+        static const auto pid = static_cast<int64_t>(::getpid());
+        static thread_local const auto tid = static_cast<int64_t>(::syscall(SYS_gettid));
+
+        nlohmann::json event = {{"name", name},
+                                {"cat", "job"},
+                                {"ph", std::string(1, phase)},
+                                {"id2", {{"global", hex(trace_id)}}},
+                                {"ts", micros(time)},
+                                {"pid", pid},
+                                {"tid", tid}};
+        if (!args.empty())
+        {
+            event["args"] = args;
+        }
+        return event.dump() + ",\n";
+    }
+}  // namespace
+
+tracing &tracing::instance()
+{
+    static tracing instance;
+    return instance;
+}
+
+tracing::~tracing()
+{
+    stop();
+}
+
+void tracing::start(const std::string &path)
+{
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Could not open trace file " + path + ": " +
+                                 std::strerror(errno));
+    }
+
+    // A new file starts the JSON array, processes append their events to it
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size == 0)
+    {
+        static_cast<void>(::write(fd, "[\n", 2));
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+    m_fd = fd;
+    m_file = path;
+    m_enabled.store(true, std::memory_order_relaxed);
+}
+
+void tracing::stop()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_enabled.store(false, std::memory_order_relaxed);
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_file.clear();
+    m_pending.clear();
+}
+
+std::string tracing::file() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_file;
+}
+
+size_t tracing::pending() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_pending.size();
+}
+
+uint64_t tracing::new_trace() const
+{
+    if (!enabled())
+    {
+        return 0;
+    }
+
+    static thread_local std::mt19937_64 generator{std::random_device{}()};
+    uint64_t id;
+    do
+    {
+        id = generator();
+    } while (id == 0);
+    return id;
+}
+
+void tracing::submitted(int job_id, const trace &job_trace)
+{
+    if (job_trace.id == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_enabled.load(std::memory_order_relaxed) && m_pending.size() < MAX_PENDING)
+    {
+        m_pending.insert_or_assign(job_id, job_trace);
+    }
+}
+
+std::optional<tracing::trace> tracing::take(int job_id)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto it = m_pending.find(job_id);
+    if (it == m_pending.end())
+    {
+        return std::nullopt;
+    }
+
+    auto job_trace = it->second;
+    m_pending.erase(it);
+    return job_trace;
+}
+
+std::vector<std::pair<int, tracing::trace>> tracing::take_user(int user_id)
+{
+    std::vector<std::pair<int, trace>> taken;
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (auto it = m_pending.begin(); it != m_pending.end();)
+    {
+        if (it->second.user_id == user_id)
+        {
+            taken.emplace_back(it->first, it->second);
+            it = m_pending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return taken;
+}
+
+void tracing::record(uint64_t trace_id, std::string_view name, clock::time_point start,
+                     clock::time_point end, const nlohmann::json &args)
+{
+    if (trace_id == 0 || !enabled())
+    {
+        return;
+    }
+
+    write(event(trace_id, name, 'b', start, args) + event(trace_id, name, 'e', end, {}));
+}
+
+void tracing::begin(uint64_t trace_id, std::string_view name, clock::time_point start,
+                    const nlohmann::json &args)
+{
+    if (trace_id == 0 || !enabled())
+    {
+        return;
+    }
+
+    write(event(trace_id, name, 'b', start, args));
+}
+
+void tracing::end(uint64_t trace_id, std::string_view name, clock::time_point end,
+                  const nlohmann::json &args)
+{
+    if (trace_id == 0 || !enabled())
+    {
+        return;
+    }
+
+    write(event(trace_id, name, 'e', end, args));
+}
+
+void tracing::write(const std::string &events)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_fd >= 0)
+    {
+        static_cast<void>(::write(m_fd, events.data(), events.size()));
+    }
+}
+
+}  // namespace server
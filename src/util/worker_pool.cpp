@@ -0,0 +1,74 @@
+#include <util/worker_pool.hpp>
+
+#include <algorithm>
+
+namespace server {
+
+worker_pool::worker_pool(size_t nof_threads, size_t queue_limit)
+    : m_queue_limit{queue_limit}
+{
+    nof_threads = std::max(nof_threads, size_t{1});
+    m_threads.reserve(nof_threads);
+    for (size_t i = 0; i < nof_threads; ++i)
+    {
+        m_threads.emplace_back([this]() {
+            this->run_worker();
+        });
+    }
+}
+
+worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stopped = true;
+    }
+    m_condition.notify_all();
+
+    for (auto &thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+bool worker_pool::try_submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock{m_mutex};
+        if (m_stopped || m_queue.size() >= m_queue_limit)
+        {
+            return false;
+        }
+        m_queue.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+
+    return true;
+}
+
+void worker_pool::run_worker()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock{m_mutex};
+            m_condition.wait(lock, [this]() {
+                return m_stopped || !m_queue.empty();
+            });
+
+            if (m_queue.empty())
+            {
+                // Stopped and all remaining tasks are done
+                return;
+            }
+
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        task();
+    }
+}
+
+}  // namespace server